@@ -39,7 +39,8 @@ enum class PARTIAL_ADDRESSING_MODES_SET : Byte {
 
 enum class JMP_ADDRESSING_MODES : Byte {
 	ABSOLUTE         = 0x4C,
-	INDIRECT         = 0x6C
+	INDIRECT         = 0x6C,
+	INDEXED_INDIRECT = 0x7C  // 65C02 only
 };
 
 enum class INDEX : Byte {
@@ -54,10 +55,4 @@ enum class BYTES_USED : size_t {
 	THREE_BYTES
 };
 
-enum class ARITHMETIC_OPERATION : Byte {
-	NO_OPERATION,
-	ADDITION,
-	SUBTRACTION
-};
-
 #endif // ADDRESSING_MODE_HPP
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef ANALYSIS_HPP
+#define ANALYSIS_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+
+#include "types.hpp"
+#include "opcodes.hpp"
+
+class SymbolTable;
+
+// What a ROM byte was found to be
+enum class BYTE_KIND : Byte {
+	UNKNOWN, // never reached
+	OPCODE,  // first byte of an instruction
+	OPERAND, // other bytes of an instruction
+	DATA     // read as a vector or a jump table entry
+};
+
+// Straight-line run of instructions, only entered at start and only left after last
+struct BasicBlock {
+	Word start;
+	Word last; // address of the last instruction
+	Word end;  // address after the last instruction
+
+	std::vector<Word> successors;
+
+	bool unresolved = false; // ends with a computed jump whose targets couldn't be found
+};
+
+// Targets of a computed jump, read from one word table or from split low/high tables
+struct JumpTable {
+	Word jump; // instruction doing the dispatch (JMP (ind) or the RTS of a push/RTS dispatch)
+	Word low;
+	Word high;
+	Byte stride;
+
+	std::vector<Word> targets;
+};
+
+/*
+Recursive descent disassembly of a ROM image :
+
+- exploration starts at the RESET, NMI and IRQ vectors (and any extra entry point)
+- every reached instruction is decoded once, following branches, jumps and calls
+- JMP ($xxxx) through a ROM pointer follows the pointer, through a RAM pointer it looks back in the same
+  run for the LDA table, X/Y + STA pointer pair(s) filling it and reads the table(s)
+- LDA high, X / PHA / LDA low, X / PHA / RTS is read as a table of addresses minus one
+- tables are read until an entry points outside the ROM or runs into code
+*/
+class ROMAnalysis {
+	public:
+		// opcodes : table of the variant running the ROM
+		ROMAnalysis(std::vector<Byte> const* rom, Word romStart, OpcodeTable const& opcodes = GetOpcodes<MOS6502>());
+
+		void AddEntryPoint(Word address, std::string const& name = "");
+
+		// Labels and operands of the listing named from symbols (label+$offset inside one), nullptr for none
+		void SetSymbols(SymbolTable const* symbols);
+
+		// Explores from the vectors and the entry points, then splits the code into blocks
+		void Analyze();
+
+		bool IsInROM(Word address) const;
+		BYTE_KIND GetKind(Word address) const;
+
+		std::map<Word, BasicBlock> const& GetBlocks() const;
+		std::vector<JumpTable> const& GetJumpTables() const;
+
+		// Start of every decoded instruction, in address order (eg. to predecode them)
+		std::vector<Word> GetInstructions() const;
+
+		// Code reached outside the ROM (routines copied to RAM, ...), not explored
+		std::set<Word> const& GetExternalTargets() const;
+
+		// Label of a block start or symbol, empty if address isn't one
+		std::string GetLabel(Word address) const;
+
+		// Instructions with labels, data as .BYTE rows and fills as .RES
+		void DisplayListing(std::ostream& output) const;
+
+		// Control-flow graph in Graphviz DOT format
+		void DisplayGraph(std::ostream& output) const;
+
+	private:
+		Byte ReadByte(Word address) const;
+		Word ReadWord(Word address) const;
+
+		void Explore(Word address);
+		void AddTarget(Word target, std::vector<Word>& pending);
+
+		// Both return the number of targets found
+		size_t ResolveIndirectJump(Word jump, std::vector<Word> const& run, std::vector<Word>& pending);
+		size_t ResolvePushReturn(Word rts, std::vector<Word> const& run, std::vector<Word>& pending);
+
+		// Finds the LDA table, X/Y whose result is stored to pointer in run, 0 if none
+		Word FindTableLoad(std::vector<Word> const& run, Word pointer) const;
+
+		void ReadJumpTable(JumpTable table, int adjust, std::vector<Word>& pending);
+
+		void BuildBlocks();
+
+		// Label, or symbol and offset, empty if address has neither
+		std::string GetReference(Word address) const;
+
+	private:
+		std::vector<Byte> const* _rom;
+		Word _romStart;
+		OpcodeTable const* _opcodes;
+
+		std::vector<BYTE_KIND> _kinds;
+
+		std::vector<Word> _entryPoints;
+		std::map<Word, std::string> _names;
+		SymbolTable const* _symbols = nullptr;
+		std::set<Word> _leaders;
+		std::set<Word> _externalTargets;
+
+		std::map<Word, std::vector<Word>> _computedTargets; // per dispatching instruction
+
+		std::vector<JumpTable> _jumpTables;
+		std::map<Word, BasicBlock> _blocks;
+};
+
+#endif // ANALYSIS_HPP
@@ -0,0 +1,96 @@
+#ifndef BUS_HPP
+#define BUS_HPP
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+
+#include "cpu.hpp"
+#include "device.hpp"
+
+/*
+Several CPUs sharing memory pages (eg. two 6502s and a mailbox RAM)
+
+The shared pages are mapped in every CPU attached as a device, the rest of each memory map stays private.
+Run gives every CPU its own host thread :
+
+- QUANTUM : the CPUs run quantum cycles then wait for each other, accesses to the shared pages inside a quantum
+  happen in no defined order between CPUs. Threads only meet at the end of a quantum, so CPUs rarely touching
+  the shared pages scale with the host cores
+- EXACT : an access to the shared pages waits until every other CPU is past its cycle (the first CPU attached
+  goes first on the same cycle), accesses happen in cycle order whatever the host scheduling. Every CPU
+  publishes its cycle before each instruction
+
+Cycles are those of the instruction start (InstructionStepped). The stack page can't be shared : pushes and
+pulls bypass devices. Traces should be silenced or sent to one stream per CPU.
+*/
+
+constexpr uint64_t DEFAULT_BUS_QUANTUM = 1000;
+
+enum class BUS_ORDER {
+	QUANTUM,
+	EXACT
+};
+
+class SharedBus {
+	public:
+		// Shares [start; start + size[, rounded to whole pages
+		SharedBus(Word start, Word size, BUS_ORDER order = BUS_ORDER::QUANTUM, uint64_t quantum = DEFAULT_BUS_QUANTUM);
+		~SharedBus();
+
+		SharedBus(SharedBus const&) = delete;
+		SharedBus& operator=(SharedBus const&) = delete;
+
+		// Maps the shared pages in cpu, the first CPU attached gives their initial contents
+		void Attach(CPU* cpu);
+
+		// CPU::RunCycles for every CPU on its own thread
+		// Returns the cycles elapsed by the CPU that ran the longest
+		uint64_t Run(uint64_t cycles);
+
+		// Direct access to the shared pages (devices and ordering bypassed), between runs
+		Byte Peek(Word address) const;
+		void Poke(Word address, Byte value);
+
+		uint64_t GetReads() const;
+		uint64_t GetWrites() const;
+
+		// Times a CPU had to wait for another one before an access (EXACT)
+		uint64_t GetWaits() const;
+
+	private:
+		class Port;
+
+		// Per CPU, on its own cache line
+		struct alignas(64) Processor {
+			CPU* cpu = nullptr;
+			std::unique_ptr<Port> port;
+
+			std::atomic<uint64_t> cycle = 0; // published cycle (EXACT), UINT64_MAX once the CPU is done
+			uint64_t reads = 0;
+			uint64_t writes = 0;
+			uint64_t waits = 0;
+		};
+
+		// Returns the cycles elapsed
+		uint64_t RunProcessor(size_t index, uint64_t cycles, std::barrier<>& quantumEnd);
+
+		// Waits until every other CPU is past the cycle published by index (EXACT)
+		void WaitTurn(size_t index);
+
+		Byte Load(Word address) const;
+		void Store(Word address, Byte value);
+
+	private:
+		Word _start;
+		Word _size;
+		BUS_ORDER _order;
+		uint64_t _quantum;
+
+		std::unique_ptr<std::atomic<Byte>[]> _memory;
+		std::vector<std::unique_ptr<Processor>> _processors;
+};
+
+#endif // BUS_HPP
@@ -0,0 +1,112 @@
+#ifndef CALLSTACK_HPP
+#define CALLSTACK_HPP
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <string>
+#include <cstdint>
+
+#include "cpu.hpp"
+
+/*
+Shadow call stack
+
+CallStack steps the CPU and keeps a frame for every JSR and interrupt entry, popped by the RTS or RTI
+returning to it. The CPU itself doesn't change : the stack costs nothing unless the CPU is stepped through it.
+
+- profile : calls, inclusive cycles (outermost activation of recursive subroutines only) and exclusive cycles
+  per subroutine
+- folded stacks (root;caller;callee cycles), for flamegraph.pl or speedscope
+- anomalies : returns to another address than the one of the top frame (the stack is resynchronized on a
+  deeper frame if one matches, RTS used as a computed jump matches none and leaves the frames as they are),
+  and pushes or pulls wrapping past the stack page
+*/
+
+// A 256 bytes stack holds at most this many return addresses, deeper frames were abandoned by the guest
+constexpr size_t MAX_CALL_FRAMES = 0x80;
+
+struct CallFrame {
+	Word target;
+	Word returnAddress;
+	uint64_t entryCycle;
+	bool interrupt;
+};
+
+struct SubroutineProfile {
+	uint64_t calls;
+	uint64_t inclusiveCycles;
+	uint64_t exclusiveCycles;
+};
+
+enum class CALL_ANOMALY : Byte {
+	MISMATCHED_RETURN, // returned below the top frame, frames above it dropped
+	UNMATCHED_RETURN,  // returned to an address no frame expects
+	STACK_OVERFLOW,    // pushed past $0100
+	STACK_UNDERFLOW    // pulled past $01FF
+};
+
+struct CallAnomaly {
+	CALL_ANOMALY kind;
+	Word pc;       // of the instruction
+	Word expected; // return address of the top frame (returns only)
+	Word actual;   // address returned to (returns only)
+	uint64_t cycle;
+};
+
+class CallStack {
+	public:
+		CallStack(CPU* cpu);
+
+		void Step();
+
+		// CPU::RunCycles, following the calls of every step
+		uint64_t Run(uint64_t cycles);
+
+		std::deque<CallFrame> const& GetFrames() const;
+		std::vector<CallAnomaly> const& GetAnomalies() const;
+
+		// Cycles up to now included
+		std::map<Word, SubroutineProfile> GetProfile();
+
+		// Names of the subroutines in the outputs, L_XXXX by default
+		void SetNames(std::function<std::string(Word)> names);
+
+		// name calls inclusive exclusive, by decreasing inclusive cycles
+		void DisplayProfile(std::ostream& output);
+		void DisplayFoldedStacks(std::ostream& output);
+		void DisplayAnomalies(std::ostream& output) const;
+
+		void Clear();
+
+	private:
+		// Gives the cycles since the last change of the stack to its top
+		void Attribute();
+
+		void Push(CallFrame const& frame);
+		void Return(Word pc, Word address);
+
+		std::string GetName(Word address) const;
+
+	private:
+		CPU* _cpu;
+
+		std::deque<CallFrame> _frames;
+		std::vector<CallAnomaly> _anomalies;
+
+		std::map<Word, SubroutineProfile> _profile;
+		std::unordered_map<Word, uint64_t> _active; // activations of each subroutine on the stack
+
+		// exclusive cycles by stack (targets from the bottom)
+		std::map<std::vector<Word>, uint64_t> _folded;
+		std::vector<Word> _path;
+
+		uint64_t _lastChange = 0;
+
+		std::function<std::string(Word)> _names;
+};
+
+#endif // CALLSTACK_HPP
@@ -0,0 +1,67 @@
+#ifndef COVERAGE_HPP
+#define COVERAGE_HPP
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <string>
+#include <cstdint>
+
+#include "types.hpp"
+#include "memory.hpp"
+#include "opcodes.hpp"
+
+class SymbolTable;
+
+/*
+Guest code coverage
+
+Attached to a CPU (CPU::SetCoverage), it sets one bit per instruction executed, at its opcode address, and one
+bit per direction of every conditional branch (taken or not taken, set by CheckBranching). Cheap enough to stay
+on for full speed regression runs.
+
+Bitmaps of parallel runs are saved to files and merged with a bitwise OR (tools/coverage.cpp), then reported
+as lcov tracefiles against the source lines of a ld65 debug file (see symbols.hpp) : a line is hit when one of
+its opcodes was executed, and its branches give BRDA records.
+*/
+
+constexpr uint32_t COVERAGE_MAGIC   = 0x56434F43; // "COCV"
+constexpr uint32_t COVERAGE_VERSION = 1;
+
+constexpr size_t COVERAGE_WORDS = MAX_ADDRESSABLE / 64;
+
+enum class COVERAGE_BIT : Byte {
+	EXECUTED,
+	TAKEN,
+	NOT_TAKEN,
+	COUNT
+};
+
+class Coverage {
+	public:
+		Coverage();
+
+		inline void Mark(COVERAGE_BIT bit, Word address) {
+			_bits[(size_t) bit][address >> 6] |= (uint64_t) 1 << (address & 0x3F);
+		}
+
+		bool IsMarked(COVERAGE_BIT bit, Word address) const;
+		size_t Count(COVERAGE_BIT bit) const;
+
+		void Clear();
+
+		// Bitwise OR of the bits of other
+		void Merge(Coverage const& other);
+
+		// Both false on I/O errors, Load also on a wrong magic or version
+		bool Save(std::string const& filepath) const;
+		bool Load(std::string const& filepath);
+
+		// lcov tracefile, instructions in the lines decoded from memory (64 KiB) with the opcodes of the variant to find the branches
+		void DisplayLcov(std::ostream& output, SymbolTable const& symbols, Byte const* memory, std::string const& testName = "", OpcodeTable const& opcodes = GetOpcodes<MOS6502>()) const;
+
+	private:
+		std::array<std::array<uint64_t, COVERAGE_WORDS>, (size_t) COVERAGE_BIT::COUNT> _bits;
+};
+
+#endif // COVERAGE_HPP
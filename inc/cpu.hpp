@@ -5,10 +5,17 @@
 #include <vector>
 #include <iomanip>
 #include <functional>
+#include <algorithm>
+#include <bitset>
+#include <deque>
 
 #include "types.hpp"
 #include "addressing_mode.hpp"
 #include "tools.hpp"
+#include "memory.hpp"
+#include "device.hpp"
+#include "record.hpp"
+#include "opcodes.hpp"
 
 enum class STATUS_FLAG : Byte {
 	N = 0b10000000,
@@ -26,13 +33,6 @@ enum class DATA_BUS_OPERATION : bool {
 	READ  = true
 };
 
-// Size of various memory map areas
-constexpr int MAX_ADDRESSABLE = 0x10000;
-constexpr int MAX_RAM_SIZE    = 0x800;
-constexpr int MAX_PAGE_SIZE   = 0x100;
-constexpr int MAX_STACK_SIZE  = 0x100;
-constexpr int MAX_ROM_SIZE    = 0x8000;
-
 // Vectors nibbles
 constexpr Word NMI_LOW    = 0xFFFA;
 constexpr Word NMI_HIGH   = 0xFFFB;
@@ -41,11 +41,95 @@ constexpr Word RESET_HIGH = 0xFFFD;
 constexpr Word IRQ_LOW    = 0xFFFE;
 constexpr Word IRQ_HIGH   = 0xFFFF;
 
-class CPU {
-	using Instruction = void (CPU::*)(void);
+// Registers, pins and counters of a CPU (memory excluded)
+// Addresses are held in natural order (high byte first)
+struct CPUState {
+	bool readWrite;
+	Byte dataBus;
+	Word addressBus;
+	bool irqLine;
+	bool nmiPending;
+
+	Byte accumulator;
+	Byte indexX;
+	Byte indexY;
+	Byte statusFlags;
+	Byte stackPointer;
+	Word programCounter;
+
+	uint64_t cycles;
+	uint64_t instructions;
+	uint64_t interrupts;
+};
+
+// Pins of a CPU at a given point of the execution
+struct BusState {
+	Word addressBus; // natural order (high byte first)
+	Byte dataBus;
+	bool readWrite;
+	uint64_t cycles;
+	bool access = true; // false for a cycle the bus log has no access for, the pins keep the values of the previous one
+};
+
+// Execution policies
+// InstructionStepped runs whole instructions with no per-cycle bookkeeping (throughput)
+// CycleStepped also logs the bus accesses of every instruction, dummy ones included, and hands them out one per Tick
+// The log is there to inspect and check the accesses of instructions, it doesn't make device timing cycle accurate :
+// - an instruction still runs at once on its first Tick, devices see all of its accesses then
+// - the accesses are logged in the order of the handlers, which isn't always the 6502's one
+// - cycles with no access logged are handed out with access false, nothing is read for them
+// Devices which depend on when an access happens inside an instruction need a per-cycle core, which this isn't
+struct InstructionStepped {
+	static constexpr bool CYCLE_STEPPED = false;
+};
+
+struct CycleStepped {
+	static constexpr bool CYCLE_STEPPED = true;
+};
+
+// Variant policies
+// MOS6502 only decodes documented opcodes
+// MOS6502Undocumented also decodes the stable undocumented NMOS opcodes (LAX, SAX, DCP, ISC, SLO, RLA, SRE, RRA, ...)
+// CMOS65C02 adds the 65C02 instructions and (zp) mode, fixes JMP ($xxFF) and leaves no undefined opcode
+// (the Rockwell/WDC bit instructions RMB, SMB, BBR and BBS are not part of it)
+struct MOS6502 {
+	static constexpr bool UNDOCUMENTED_OPCODES = false;
+	static constexpr bool CMOS = false;
+};
+
+struct MOS6502Undocumented {
+	static constexpr bool UNDOCUMENTED_OPCODES = true;
+	static constexpr bool CMOS = false;
+};
+
+struct CMOS65C02 {
+	static constexpr bool UNDOCUMENTED_OPCODES = false;
+	static constexpr bool CMOS = true;
+};
+
+class StepGenerator;
+class SymbolTable;
+class Heatmap;
+class Coverage;
+
+template <typename Variant, typename Bus>
+class BasicCPU {
+	using Instruction = void (BasicCPU::*)(void);
 
 	public:
-		CPU(std::vector<Byte>* ram, Word ramStart, Word ramSize, std::vector<Byte>* rom, Word romStart, Word romSize);
+		BasicCPU(std::vector<Byte>* ram, Word ramStart, Word ramSize, std::vector<Byte>* rom, Word romStart, Word romSize);
+
+		// CPUs built from the same image share its pages until they write them
+		BasicCPU(std::shared_ptr<MemoryImage const> image);
+
+		// Starts over without reallocating : the pages written are copied back from the image, the registers
+		// are cleared then go through the reset sequence (SP decremented three times, I set, reset vector, 7 cycles)
+		// Counters restart and a pending NMI is dropped, devices, the IRQ line, trace and inputs stay as they are
+		void Reset();
+
+		// Same as Reset with a new image of ram and rom, mapped where the current one maps RAM and ROM
+		// Later Resets restore these contents, the pages they change are marked dirty
+		void Reload(std::vector<Byte> const* ram, std::vector<Byte> const* rom);
 
 		// Debug log function
 		void DisplayStatus() const;
@@ -84,13 +168,131 @@ class CPU {
 		// Map display
 		void DisplayMap() const;
 
+		// Mnemonics ("" for the opcodes the variant doesn't decode) and base cycles of the variant
+		// (the opcode tables of the tools are built from them, see opcodes.hpp)
+		static std::vector<std::string> MakeInstructionsNames();
+		static std::vector<Byte> MakeInstructionsCycles();
+
+		// Opcode table of the variant, for the code looking at instructions before running them
+		static OpcodeTable const& GetOpcodes();
+
 		// Run execution of the CPU
 		void Run(bool stepByStep);
 
+		// Execute a single instruction (or enter a pending interrupt)
+		void Step();
+
+		// An NMI is pending or the IRQ line is asserted with I clear : the next Step enters the interrupt
+		bool IsInterruptPending() const;
+
+		// The next opcode is $00 and no interrupt is pending, RunCycles stops there
+		bool IsStopped() const;
+
+		// Run loop shared by the wrappers of the CPU (IdleSkipper, CallStack, TraceWriter, Pacer...)
+		// Runs for at least cycles, stops early when IsStopped, returns the cycles elapsed
+		// step runs the next instruction(s), Step when empty
+		uint64_t RunCycles(uint64_t cycles, std::function<void()> const& step = nullptr);
+
+		// Called every interval instructions stepped (eg. Metrics), then with true when RunCycles returns
+		// nullptr detaches
+		void SetRunHook(std::function<void(bool)> hook, uint64_t interval);
+
+		// Advance by one instruction (InstructionStepped) or one entry of the bus log (CycleStepped, the instruction
+		// runs on the first one) and return the bus state of that instruction end or of that entry
+		BusState Tick();
+
+		// Coroutine stepping (see steps.hpp), suspends after every Tick
+		// Like Run, it ends when the next opcode is $00
+		StepGenerator Steps();
+
+		BusState GetBusState() const;
+
+		// Instructions trace, nullptr silences it
+		void SetTraceOutput(std::ostream* output);
+		std::ostream* GetTraceOutput() const;
+
+		// Symbols shown as label+$offset after the addresses of the trace, nullptr for none
+		void SetSymbols(SymbolTable const* symbols);
+
+		// Counts the reads, writes and opcode fetches of every address, nullptr detaches
+		void SetHeatmap(Heatmap* heatmap);
+
+		// Marks the instructions executed and the directions taken by branches, nullptr detaches
+		void SetCoverage(Coverage* coverage);
+
+		// Cycles elapsed since construction
+		uint64_t GetCycles() const;
+
+		// Steps (instructions and interrupt entries) executed since construction
+		uint64_t GetInstructions() const;
+
+		// IRQ and NMI entries since construction
+		uint64_t GetInterrupts() const;
+
+		// Registers snapshot
+		CPUState GetState() const;
+		void SetState(CPUState const& state);
+
+		// Raw access to a page of the memory map (MAX_PAGE_SIZE bytes, devices bypassed)
+		Byte const* GetPage(Byte page) const;
+		void SetPage(Byte page, Byte const* data);
+
+		// Private copy of a page for bulk writes, marked dirty (nullptr for device pages)
+		Byte* GetWritablePage(Byte page);
+
+		// Pages written since the last clear (stores, stack pushes, SetPage and the pages Reset copies back)
+		// Reset keeps its own record of the pages to restore, clearing doesn't affect it
+		bool IsPageDirty(Byte page) const;
+		std::bitset<MAX_PAGES> const& GetDirtyPages() const;
+		void ClearDirtyPages();
+
+		std::shared_ptr<MemoryImage const> const& GetMemoryImage() const;
+
+		// Pages this CPU holds a private copy of
+		size_t GetPrivatePages() const;
+
+		// Maps a device over [start; start + size[, rounded to whole pages
+		void AttachDevice(Device* device, Word start, Word size);
+
+		// Attached devices, each listed once in order of their first page
+		std::vector<Device*> GetDevices() const;
+
+		// true if page is routed to a device
+		bool IsDevicePage(Byte page) const;
+		Device* GetDevice(Byte page) const;
+
+		// Bus access from outside the instruction handlers (devices, recording and dirty pages included)
+		Byte Read(Word address);
+		void Write(Word address, Byte value);
+
+		// Interrupt lines
+		// (IRQ is level triggered, NMI is edge triggered)
+		void AssertIRQ();
+		void ReleaseIRQ();
+		void AssertNMI();
+
+		// Inputs recording and replay, nullptr detaches
+		// While replaying, interrupts come from the stream and the lines above are ignored
+		void SetInputRecorder(InputRecorder* recorder);
+		void SetInputReplayer(InputReplayer* replayer);
+
 	private:
 		void FetchAndExecute();
 
-		void UpdateState(Byte reg, Byte* cmpVal = nullptr, ARITHMETIC_OPERATION operation = ARITHMETIC_OPERATION::NO_OPERATION);
+		// Calls the run hook once its interval of instructions is reached
+		void PollRunHook();
+		void TraceAddress();
+
+		void ServiceInterrupt(Word vectorLow);
+
+		// Pushes the return address (the program counter) and the flags, B set for BRK, then jumps through the vector
+		void EnterInterrupt(Word vectorLow, bool brk);
+		void SetInterruptLine(INPUT_EVENT event);
+		void ReplayInterrupts();
+
+		Byte ReadMemory(Word address);
+		Byte ReadDevice(Word address);
+		void WriteMemory(Word address, Byte value);
 
 		// ADd with Carry
 		void ADC();
@@ -260,6 +462,83 @@ class CPU {
 		// Transfer Y to A
 		void TYA();
 
+		// Undocumented NMOS instructions
+
+		// AND then copy N to Carry
+		void ANC();
+
+		// AND then Logical shift Right
+		void ALR();
+
+		// AND then Rotate Right
+		void ARR();
+
+		// DECrement then ComPare
+		void DCP();
+
+		// Increment then Subtract with Carry
+		void ISC();
+
+		// LoaD A and X
+		void LAX();
+
+		// Rotate Left then AND
+		void RLA();
+
+		// Rotate Right then Add with carry
+		void RRA();
+
+		// Store A AND X
+		void SAX();
+
+		// Subtract from A AND X
+		void SBX();
+
+		// Shift Left then OR
+		void SLO();
+
+		// Shift Right then EOR
+		void SRE();
+
+		// No OPeration reading one (DOP) or two (TOP) operand bytes
+		void DOP();
+		void TOP();
+
+		// 65C02 instructions
+
+		// BIT immediate
+		void BITImmediate();
+
+		// BRanch Always
+		void BRA();
+
+		// DEcrement A
+		void DEA();
+
+		// INcrement A
+		void INA();
+
+		// PusH X
+		void PHX();
+
+		// PusH Y
+		void PHY();
+
+		// PulL X
+		void PLX();
+
+		// PulL Y
+		void PLY();
+
+		// STore Zero
+		void STZ();
+
+		// Test and Reset Bits
+		void TRB();
+
+		// Test and Set Bits
+		void TSB();
+
 		void SetFlag(STATUS_FLAG flag);
 		void UnsetFlag(STATUS_FLAG flag);
 
@@ -267,26 +546,53 @@ class CPU {
 
 		bool IsSet(STATUS_FLAG flag) const;
 
-		void UseFullAddressingModeSet();
-		void UsePartialAddressingModeSet(INDEX index = INDEX::UNUSED);
+		void SetZeroAndNegative(Byte value);
+		// ADC and SBC, NMOS decimal mode when D is set
+		void AddWithCarry(Byte value);
+		void SubtractWithBorrow(Byte value);
+		void Compare(Byte reg, Byte value);
+
+		// Modes decoded from the opcode, or given explicitly when the opcode doesn't follow the usual pattern
+		// Store-only instructions pass WRITE : the operand isn't read, devices and the recorder see no access
+		void UseFullAddressingModeSet(DATA_BUS_OPERATION operation = DATA_BUS_OPERATION::READ);
+		void UseFullAddressingMode(FULL_ADDRESSING_MODES_SET mode, DATA_BUS_OPERATION operation = DATA_BUS_OPERATION::READ);
+		void UsePartialAddressingModeSet(INDEX index = INDEX::UNUSED, DATA_BUS_OPERATION operation = DATA_BUS_OPERATION::READ);
+		void UsePartialAddressingMode(PARTIAL_ADDRESSING_MODES_SET mode, INDEX index = INDEX::UNUSED, DATA_BUS_OPERATION operation = DATA_BUS_OPERATION::READ);
+		void UseZeroPageIndirect(DATA_BUS_OPERATION operation = DATA_BUS_OPERATION::READ);
+
+		// Effective address (natural order) of a memory operand put on the address bus, and the operand read from it (READ)
+		void UseEffectiveAddress(Word address, DATA_BUS_OPERATION operation);
+		// Same for an indexed mode, counting the cycle reads pay when the index crosses a page
+		void UseIndexedAddress(Byte opcode, Word base, Byte index, DATA_BUS_OPERATION operation);
 
 		void IncrementProgramCounter();
 
 		inline void SetDataBusFromByteAtPC();
 		inline void SetDataBusFromAddressBus();
+		void WriteDataBusToAddressBus();
 
 		void SetAddressBusFromTwoNextBytesInROM();
 
 		void PushToStack(Byte value);
 		Byte PullFromStack();
 
+		inline void LogBusCycle(Word address, Byte data, DATA_BUS_OPERATION operation);
+
+		// Accesses a real 6502 makes without using them, only performed when cycle stepped
+		inline void DummyRead(Word address);
+		inline void DummyWrite();
+
 		// checkSet checks if the function must check for the flag to be set or for it to be unset
 		// true : isSet(flag)
 		// false : !isSet(flag)
 		void CheckBranching(STATUS_FLAG flag, bool checkSet);
+		void CheckBranching(bool taken);
 
 		void SetProgramCounterFromResetVector();
 
+		void RestorePages();
+		void ResetRegisters();
+
 	private:
 		// Pins
 		// (Doesn't include RDY, VCC and VSS since this program assumes 
@@ -294,6 +600,8 @@ class CPU {
 		bool _readWrite         = (bool) DATA_BUS_OPERATION::READ; // 0 : Write / 1 : Read
 		Byte _dataBus           = (Byte) 0x00;  // D0-D7
 		Word _addressBus        = (Word) 0x0000; // A0-A15
+		bool _irqLine           = false; // IRQ (asserted)
+		bool _nmiPending        = false; // NMI (edge seen, not serviced yet)
 
 		// Internals
 		Byte _accumulator       = (Byte) 0x00; // A
@@ -303,13 +611,42 @@ class CPU {
 		Byte _stackPointer      = (Byte) 0x00; // SP
 		Word _programCounter    = (Word) 0x0000; // PC
 
+		// Timing
+		uint64_t _cycles        = 0;
+		uint64_t _instructions  = 0;
+		uint64_t _interrupts    = 0;
+
 		// Vectors
 		Word _nmi = (Word) 0x0000; // Non Maskable Interrupt vector
 		Word _res = (Word) 0x0000; // RESet vector
 		Word _irq = (Word) 0x0000; // Interrupt ReQuest vector
 
 		// Memory map
-		std::vector<Byte> _map;
+		PagedMemory _map;
+		std::vector<Device*> _devices; // one entry per page, nullptr for plain memory
+		std::bitset<MAX_PAGES> _dirtyPages; // one bit per page written, cleared by ClearDirtyPages
+		std::bitset<MAX_PAGES> _writtenPages; // one bit per page written since the last Reset, copied back from the image
+
+		// Inputs
+		InputRecorder* _recorder = nullptr;
+		InputReplayer* _replayer = nullptr;
+
+		// Access counters
+		Heatmap* _heatmap = nullptr;
+		Coverage* _coverage = nullptr;
+
+		// Run hook and the instruction count of its last call
+		std::function<void(bool)> _runHook;
+		uint64_t _runHookInterval = UINT64_MAX;
+		uint64_t _lastRunHook = 0;
+
+		// Bus cycles of the current instruction not handed out by Tick yet (CycleStepped only)
+		std::deque<BusState> _busCycles;
+
+		// Trace
+		std::ostream _silent{nullptr};
+		std::ostream* _trace = &std::cout;
+		SymbolTable const* _symbols = nullptr;
 
 		// Links
 		Word _ram         = (Word) 0x0000;
@@ -318,9 +655,17 @@ class CPU {
 		Word _rom         = (Word) 0x0000;
 		Word _romSize     = (Word) 0x0000;
 		
-		// Instructions
-		std::vector<std::string> _instructionsNames;
-		std::vector<Instruction> _instructionsMatrix;
+		// Instructions (shared by every CPU of the same variant)
+		static std::vector<Instruction> MakeInstructionsMatrix();
+		static std::vector<Byte> MakePageCrossCycles();
+
+		static std::vector<std::string> const _instructionsNames;
+		static std::vector<Instruction> const _instructionsMatrix;
+		static std::vector<Byte> const _instructionsCycles; // without the page crossing and taken branch cycles
+		static std::vector<Byte> const _pageCrossCycles;    // 1 for the instructions paying a cycle when an index crosses a page
 };
 
+using CPU = BasicCPU<MOS6502, InstructionStepped>;
+using CycleCPU = BasicCPU<MOS6502, CycleStepped>;
+
 #endif // CPU_HPP
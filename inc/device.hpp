@@ -0,0 +1,30 @@
+#ifndef DEVICE_HPP
+#define DEVICE_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "types.hpp"
+
+// Host-backed device mapped in the CPU address space (MMIO)
+// Devices are attached per page : every address of an attached page is routed to the device
+class Device {
+	public:
+		virtual ~Device() = default;
+
+		// Value seen on the data bus when the CPU reads address
+		virtual Byte Read(Word address) = 0;
+
+		// Value put on the data bus when the CPU writes address (ignored by default)
+		virtual void Write(Word /* address */, Byte /* value */) {}
+
+		// Earliest cycle at which reading address may return another value or have a side effect
+		// Idle loops polling the device are fast-forwarded up to it (the default never allows it)
+		virtual uint64_t GetStableUntil(Word /* address */, uint64_t cycle) const { return cycle; }
+
+		// Internal state, for save states (stateless devices keep the defaults)
+		virtual std::vector<Byte> SaveState() const { return {}; }
+		virtual bool LoadState(std::vector<Byte> const& state) { return state.empty(); }
+};
+
+#endif // DEVICE_HPP
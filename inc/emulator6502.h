@@ -0,0 +1,112 @@
+#ifndef EMULATOR6502_H
+#define EMULATOR6502_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+C interface of the emulator, for FFI
+
+g++ -std=c++20 -O2 -shared -fPIC -DEMULATOR6502_BUILD -Iinc src/emulator6502.cpp src/<everything but main.cpp> -o libemulator6502.so
+
+Calls are batched : Emulator6502Run executes up to a budget of instructions in a single call and fills an
+event list, memory and registers are copied in bulk. Every function is safe to call with the handle returned
+by Emulator6502Create, functions returning int give EMULATOR6502_OK or a negative EMULATOR6502_ERROR_*.
+*/
+
+#if defined(_WIN32)
+	#if defined(EMULATOR6502_BUILD)
+		#define EMULATOR6502_API __declspec(dllexport)
+	#else
+		#define EMULATOR6502_API __declspec(dllimport)
+	#endif
+#else
+	#define EMULATOR6502_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EMULATOR6502_ABI_VERSION 1
+
+#define EMULATOR6502_OK                 0
+#define EMULATOR6502_ERROR_NOT_LOADED  -1 // no image loaded yet
+#define EMULATOR6502_ERROR_LAYOUT      -2 // areas outside the address space or overlapping
+#define EMULATOR6502_ERROR_ARGUMENT    -3
+
+typedef struct Emulator6502 Emulator6502;
+
+typedef struct Emulator6502Registers {
+	uint8_t a;
+	uint8_t x;
+	uint8_t y;
+	uint8_t p;
+	uint8_t sp;
+	uint16_t pc;
+	uint64_t cycles;
+	uint64_t instructions;
+} Emulator6502Registers;
+
+typedef enum Emulator6502EventKind {
+	// Ending a run, always the last event of the list
+	EMULATOR6502_EVENT_BUDGET = 0,     // budget of instructions spent
+	EMULATOR6502_EVENT_BRK = 1,        // next opcode is $00, left unexecuted like CPU::Run
+	EMULATOR6502_EVENT_ILLEGAL = 2,    // next opcode is undefined
+	EMULATOR6502_EVENT_BREAKPOINT = 3, // next instruction is on a breakpoint
+	EMULATOR6502_EVENT_STOP = 4,       // Emulator6502Stop called from a callback
+	EMULATOR6502_EVENT_FULL = 5,       // no room left for another event
+
+	// Within a run
+	EMULATOR6502_EVENT_INTERRUPT = 6   // IRQ or NMI entered, address is the vector target
+} Emulator6502EventKind;
+
+typedef struct Emulator6502Event {
+	uint32_t kind;    // Emulator6502EventKind
+	uint16_t address; // program counter
+	uint8_t opcode;   // at address
+	uint8_t reserved;
+	uint64_t cycle;
+} Emulator6502Event;
+
+// MMIO callbacks, called during Emulator6502Run
+typedef uint8_t (*Emulator6502ReadCallback)(void* user, uint16_t address);
+typedef void (*Emulator6502WriteCallback)(void* user, uint16_t address, uint8_t value);
+
+EMULATOR6502_API uint32_t Emulator6502Version(void);
+
+EMULATOR6502_API Emulator6502* Emulator6502Create(void);
+EMULATOR6502_API void Emulator6502Destroy(Emulator6502* emulator);
+
+// Maps ram at ramStart and rom at romStart then resets, loading again with the same layout reuses the memory
+EMULATOR6502_API int Emulator6502Load(Emulator6502* emulator, uint8_t const* ram, uint16_t ramStart, uint32_t ramSize, uint8_t const* rom, uint16_t romStart, uint32_t romSize);
+
+// Written pages back to the loaded contents, registers through the reset sequence
+EMULATOR6502_API int Emulator6502Reset(Emulator6502* emulator);
+
+// Runs at most instructions, writes at most capacity (at least 1) events and returns how many
+EMULATOR6502_API size_t Emulator6502Run(Emulator6502* emulator, uint64_t instructions, Emulator6502Event* events, size_t capacity);
+
+// Ends the current run after the instruction being executed
+EMULATOR6502_API void Emulator6502Stop(Emulator6502* emulator);
+
+EMULATOR6502_API int Emulator6502GetRegisters(Emulator6502 const* emulator, Emulator6502Registers* registers);
+EMULATOR6502_API int Emulator6502SetRegisters(Emulator6502* emulator, Emulator6502Registers const* registers);
+
+// Bulk memory access, devices bypassed, return the bytes copied (writes stop at the first MMIO page)
+EMULATOR6502_API size_t Emulator6502ReadMemory(Emulator6502 const* emulator, uint16_t address, uint8_t* data, size_t size);
+EMULATOR6502_API size_t Emulator6502WriteMemory(Emulator6502* emulator, uint16_t address, uint8_t const* data, size_t size);
+
+// Routes [start; start + size[ (whole pages) to the callbacks, write may be NULL
+EMULATOR6502_API int Emulator6502MapIO(Emulator6502* emulator, uint16_t start, uint32_t size, Emulator6502ReadCallback read, Emulator6502WriteCallback write, void* user);
+
+EMULATOR6502_API int Emulator6502SetBreakpoint(Emulator6502* emulator, uint16_t address, int enabled);
+
+EMULATOR6502_API int Emulator6502SetIRQ(Emulator6502* emulator, int asserted);
+EMULATOR6502_API int Emulator6502TriggerNMI(Emulator6502* emulator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EMULATOR6502_H
@@ -0,0 +1,63 @@
+#ifndef HEATMAP_HPP
+#define HEATMAP_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "types.hpp"
+#include "memory.hpp"
+
+class SymbolTable;
+
+/*
+Memory access heatmap
+
+Attached to a CPU (CPU::SetHeatmap), it counts the reads, writes and opcode fetches of every address.
+Operand fetches aren't counted : an instruction counts once, on its opcode. Counters saturate instead of wrapping.
+
+- CSV : address,reads,writes,executes for every address accessed
+- images 256x256, one row per page (zero page on top), brightness on a log scale : PGM of one kind of access,
+  or PPM with reads in green, writes in red and executes in blue
+- the N hottest addresses by total accesses
+*/
+
+enum class ACCESS_KIND : Byte {
+	READ,
+	WRITE,
+	EXECUTE,
+	COUNT
+};
+
+class Heatmap {
+	public:
+		Heatmap();
+
+		inline void Count(ACCESS_KIND kind, Word address) {
+			uint32_t& counter = _counters[(size_t) kind][address];
+			counter += (counter != UINT32_MAX);
+		}
+
+		uint32_t Get(ACCESS_KIND kind, Word address) const;
+
+		void Clear();
+
+		void DisplayCSV(std::ostream& output) const;
+
+		// False if the file can't be written
+		bool SavePGM(std::string const& filepath, ACCESS_KIND kind) const;
+		bool SavePPM(std::string const& filepath) const;
+
+		// Named from symbols when given
+		void DisplayHottest(std::ostream& output, size_t count, SymbolTable const* symbols = nullptr) const;
+
+	private:
+		// 0 to 255, log of count relative to the highest count of kind
+		std::vector<Byte> Scale(ACCESS_KIND kind) const;
+
+	private:
+		std::vector<uint32_t> _counters[(size_t) ACCESS_KIND::COUNT];
+};
+
+#endif // HEATMAP_HPP
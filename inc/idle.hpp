@@ -0,0 +1,77 @@
+#ifndef IDLE_HPP
+#define IDLE_HPP
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "cpu.hpp"
+#include "opcodes.hpp"
+
+/*
+Idle loop fast-forward
+
+A short backward branch or JMP (loop of at most MAX_IDLE_LOOP_BYTES) whose body doesn't store, use the stack
+or leave the loop is watched when it is taken : two more iterations are stepped and compared at the loop head.
+
+- registers and flags unchanged : the loop polls memory or a device, it is skipped up to the end of the run
+  or until a device it reads may change (Device::GetStableUntil)
+- only X or Y moved by one, and nothing else in the body uses it : the loop counts, it is skipped while the
+  counter keeps the same N/Z class, the iterations left around the class change are stepped
+
+Skipped iterations add their cycles and instructions as if they had run. A pending interrupt stops skipping.
+Inputs recorded or replayed from device reads inside a skipped loop are not reproduced, don't combine the two.
+*/
+
+constexpr Word MAX_IDLE_LOOP_BYTES = 0x20;
+
+class IdleSkipper {
+	public:
+		IdleSkipper(CPU* cpu);
+
+		// CPU::RunCycles, fast-forwarding the idle loops met
+		uint64_t Run(uint64_t cycles);
+
+		uint64_t GetSkippedCycles() const;
+		uint64_t GetSkippedLoops() const;
+
+	private:
+		struct Read {
+			OPERAND_MODE mode;
+			Word operand;
+		};
+
+		struct Loop {
+			bool suitable = false;
+
+			size_t instructions = 0;
+			std::vector<Read> reads;
+
+			// Increments/decrements of X and Y, and other uses of them
+			int countX = 0;
+			int countY = 0;
+			bool usesX = false;
+			bool usesY = false;
+		};
+
+		Loop const& GetLoop(Word head, Word tail);
+		Loop Analyze(Word head, Word tail) const;
+
+		void TrySkip(Word head, Word tail, uint64_t end);
+
+		// Steps until the head is reached again, false if the loop was left
+		bool StepIteration(Word head, Word tail, size_t maxInstructions);
+
+		Byte Peek(Word address) const;
+		Word ResolveAddress(Read const& read, CPUState const& state) const;
+
+	private:
+		CPU* _cpu;
+
+		std::unordered_map<Word, Loop> _loops; // by address of the closing instruction
+
+		uint64_t _skippedCycles = 0;
+		uint64_t _skippedLoops = 0;
+};
+
+#endif // IDLE_HPP
@@ -0,0 +1,87 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <vector>
+#include <array>
+#include <memory>
+
+#include "types.hpp"
+
+// Size of various memory map areas
+constexpr int MAX_ADDRESSABLE = 0x10000;
+constexpr int MAX_RAM_SIZE    = 0x800;
+constexpr int MAX_PAGE_SIZE   = 0x100;
+constexpr int MAX_STACK_SIZE  = 0x100;
+constexpr int MAX_ROM_SIZE    = 0x8000;
+constexpr int MAX_PAGES       = MAX_ADDRESSABLE / MAX_PAGE_SIZE;
+
+// Initial memory map (ROM and RAM contents), never modified once built
+// A single image can be shared by any number of CPUs
+class MemoryImage {
+	public:
+		// ram and rom shorter than their sizes leave the rest of their area zeroed
+		MemoryImage(std::vector<Byte> const* ram, Word ramStart, Word ramSize, std::vector<Byte> const* rom, Word romStart, Word romSize);
+
+		Byte const* GetPage(Byte page) const;
+
+		Word GetRAMStart() const;
+		Word GetRAMSize() const;
+		Word GetROMStart() const;
+		Word GetROMSize() const;
+
+	private:
+		std::vector<Byte> _map;
+
+		Word _ram     = (Word) 0x0000;
+		Word _ramSize = (Word) 0x0000;
+		Word _rom     = (Word) 0x0000;
+		Word _romSize = (Word) 0x0000;
+};
+
+// Memory map of a single CPU
+// Pages are read from the shared image until they are first written, they are then copied (copy-on-write)
+class PagedMemory {
+	public:
+		PagedMemory(std::shared_ptr<MemoryImage const> image);
+
+		Byte operator[](Word address) const {
+			return _readPages[address >> 8][(Byte) address];
+		}
+
+		void Write(Word address, Byte value) {
+			Byte* page = _writePages[address >> 8];
+
+			if (page == nullptr) {
+				page = CopyPage((Byte)(address >> 8));
+			}
+
+			page[(Byte) address] = value;
+		}
+
+		Byte const* GetPage(Byte page) const;
+		void SetPage(Byte page, Byte const* data);
+
+		// Private copy of page, for direct writes
+		Byte* GetWritablePage(Byte page);
+
+		std::shared_ptr<MemoryImage const> const& GetImage() const;
+
+		// Reads every page from image again, the private copies are dropped
+		void SetImage(std::shared_ptr<MemoryImage const> image);
+
+		// Pages owned by this map (written at least once)
+		size_t GetPrivatePages() const;
+
+	private:
+		Byte* CopyPage(Byte page);
+
+	private:
+		std::shared_ptr<MemoryImage const> _image;
+
+		std::array<Byte const*, MAX_PAGES> _readPages;
+		std::array<Byte*, MAX_PAGES> _writePages; // nullptr while the page is shared
+
+		std::vector<std::unique_ptr<Byte[]>> _privatePages;
+};
+
+#endif // MEMORY_HPP
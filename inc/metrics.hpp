@@ -0,0 +1,85 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+#include "cpu.hpp"
+
+/*
+Live metrics block, shared through a memory mapped file
+
+The emulator maps the file read/write and stores the counters with relaxed atomics every METRICS_INTERVAL
+instructions (and when CPU::RunCycles returns), any number of readers (tools/metrics.cpp) map it read only.
+Values are published independently : a reader may see the cycles of an update with the instructions of the
+previous one, never a torn value.
+*/
+
+constexpr uint32_t METRICS_MAGIC   = 0x36353032; // "6502"
+constexpr uint32_t METRICS_VERSION = 1;
+
+constexpr uint64_t METRICS_INTERVAL = 0x10000;
+
+enum class STOP_REASON : Byte {
+	BRK,        // next opcode is $00
+	BUDGET,     // cycles or instructions given spent
+	BREAKPOINT,
+	ILLEGAL,    // undefined opcode
+	REQUESTED,  // by the host
+	COUNT
+};
+
+char const* GetStopReasonName(STOP_REASON reason);
+
+struct MetricsBlock {
+	uint32_t magic;
+	uint32_t version;
+
+	std::atomic<uint64_t> instructions;
+	std::atomic<uint64_t> cycles;
+	std::atomic<uint64_t> interrupts;
+	std::atomic<uint64_t> instructionsPerSecond; // over the last interval
+	std::atomic<uint64_t> programCounter;
+
+	std::atomic<uint64_t> stops[(size_t) STOP_REASON::COUNT];
+	std::atomic<uint64_t> lastStop; // STOP_REASON, COUNT before the first stop
+
+	std::atomic<uint64_t> updates; // published so far, a reader sees the emulator is alive when it moves
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "metrics are shared between processes");
+
+// Maps a metrics file, nullptr if it can't be created (writable) or isn't a metrics block
+MetricsBlock* MapMetrics(std::string const& filepath, bool writable);
+void UnmapMetrics(MetricsBlock* block);
+
+class Metrics {
+	public:
+		Metrics(CPU* cpu);
+		~Metrics();
+
+		Metrics(Metrics const&) = delete;
+		Metrics& operator=(Metrics const&) = delete;
+
+		// Creates (or clears) the file, maps it and installs the run hook of the CPU : whatever runs it publishes
+		bool Open(std::string const& filepath);
+		bool IsOpen() const;
+
+		// For run loops of the host which stop for their own reasons (breakpoints, requests) : counts a stop and publishes
+		// The stops of CPU::RunCycles are counted by the hook (BRK or BUDGET)
+		void RecordStop(STOP_REASON reason);
+
+		void Publish();
+
+	private:
+		CPU* _cpu;
+
+		MetricsBlock* _block = nullptr;
+
+		uint64_t _lastInstructions = 0;
+		std::chrono::steady_clock::time_point _lastTime;
+};
+
+#endif // METRICS_HPP
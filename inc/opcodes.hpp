@@ -0,0 +1,72 @@
+#ifndef OPCODES_HPP
+#define OPCODES_HPP
+
+#include <string>
+#include <array>
+#include <cstdint>
+
+#include "types.hpp"
+
+// Static description of the opcodes of each CPU variant, for the tools which look at code without running it
+// Names and cycles come from the CPU tables, modes are decoded from the opcode bits like the CPU does
+
+enum class OPERAND_MODE : Byte {
+	IMPLIED,
+	ACCUMULATOR,
+	IMMEDIATE,
+	ZEROPAGE,
+	ZEROPAGE_X,
+	ZEROPAGE_Y,
+	ABSOLUTE,
+	ABSOLUTE_X,
+	ABSOLUTE_Y,
+	INDIRECT,         // JMP ($xxxx)
+	INDEXED_INDIRECT, // ($xx, X)
+	INDIRECT_INDEXED, // ($xx), Y
+	RELATIVE,
+	ZEROPAGE_INDIRECT,         // ($xx), 65C02
+	ABSOLUTE_INDEXED_INDIRECT  // JMP ($xxxx, X), 65C02
+};
+
+// What happens to the program counter after the instruction
+enum class FLOW : Byte {
+	INVALID,       // not an opcode of the variant
+	NEXT,          // falls through
+	BRANCH,        // falls through or goes to the relative target
+	JUMP,          // goes to the absolute operand
+	JUMP_INDIRECT, // goes through a pointer
+	CALL,          // goes to the absolute operand and comes back after the instruction
+	RETURN,        // target taken from the stack
+	STOP           // BRK
+};
+
+struct OpcodeInfo {
+	std::string name;
+	OPERAND_MODE mode;
+	FLOW flow;
+	Byte cycles; // base cycles, same as the CPU tables (page crossings not counted)
+	int8_t stack; // bytes pushed (> 0) or pulled (< 0)
+};
+
+using OpcodeTable = std::array<OpcodeInfo, 0x100>;
+
+struct MOS6502;
+
+// Table of a variant (MOS6502, MOS6502Undocumented or CMOS65C02), built on first use
+template <typename Variant>
+OpcodeTable const& GetOpcodes();
+
+// Same for a variant named like the --variant option of the tools (6502, 6502u, 65c02), nullptr if unknown
+OpcodeTable const* GetOpcodes(std::string const& variant);
+
+// Instruction length (opcode included) for an addressing mode
+Byte GetInstructionLength(OPERAND_MODE mode);
+
+// Target of the relative branch at address
+Word GetBranchTarget(Word address, Byte offset);
+
+// Formats the instruction at address, eg. "LDA $1234, X"
+// bytes holds the opcode then two more bytes, whatever the instruction length
+std::string Disassemble(Word address, Byte const* bytes, OpcodeTable const& opcodes = GetOpcodes<MOS6502>());
+
+#endif // OPCODES_HPP
@@ -0,0 +1,109 @@
+#ifndef PACING_HPP
+#define PACING_HPP
+
+#include <iostream>
+#include <functional>
+#include <cstdint>
+
+#include "cpu.hpp"
+
+/*
+Real-time pacing
+
+The CPU runs a slice of cycles at full speed, then the host sleeps until the time at which a real CPU clocked at
+the configured frequency would have finished it. Deadlines are absolute (clock_nanosleep with TIMER_ABSTIME on
+Linux) and computed from the cycles run since the anchor, so the sleeps' own errors never add up.
+Nothing is timed inside a slice : the run loop stays as fast as unpaced.
+
+- drift : how late the host woke up past a deadline
+- late slice : a slice that ended after its deadline (the host is slower than the clock), there is no sleep
+- resync : the anchor moved to the present after being more than the maximum lateness behind, the time lost
+  isn't caught up at full speed
+
+A turbo ratio of 2 runs twice as fast as the clock, 0 doesn't pace at all (batch runs).
+*/
+
+constexpr double CLOCK_1_MHZ = 1000000.0;
+constexpr double CLOCK_NTSC  = 1789773.0; // NTSC colorburst / 2 (NES, Atari 2600 is / 3)
+
+constexpr int64_t DEFAULT_SLICE_NANOSECONDS = 1000000;    // 1 ms
+constexpr int64_t DEFAULT_MAX_LATENESS      = 100000000;  // 100 ms
+
+struct PacingStats {
+	uint64_t slices = 0;
+	uint64_t lateSlices = 0;
+	uint64_t resyncs = 0;
+
+	int64_t maxLateness = 0;  // ns past the deadline at the end of a late slice
+	int64_t maxDrift = 0;     // ns past the deadline at wake up
+	int64_t totalDrift = 0;
+	uint64_t sleeps = 0;
+
+	int64_t sleptNanoseconds = 0;
+};
+
+class Pacer {
+	public:
+		// The slice defaults to 1 ms of the clock
+		Pacer(CPU* cpu, double clock = CLOCK_1_MHZ);
+
+		// Hz, the anchor restarts
+		void SetClock(double clock);
+		double GetClock() const;
+
+		// Speed relative to the clock, 0 for unpaced, the anchor restarts
+		void SetTurbo(double ratio);
+		double GetTurbo() const;
+
+		// Cycles run between two deadlines, 0 for 1 ms of the clock
+		void SetSlice(uint64_t cycles);
+		uint64_t GetSlice() const;
+
+		// Busy-waits the last nanoseconds before a deadline instead of sleeping them (lower jitter, one core busy)
+		void SetSpin(int64_t nanoseconds);
+
+		// Lateness beyond which the anchor moves instead of catching up
+		void SetMaxLateness(int64_t nanoseconds);
+
+		// Runs a slice of at least the cycles given and returns the cycles elapsed, eg. an IdleSkipper
+		// The default is CPU::RunCycles
+		void SetRunner(std::function<uint64_t(uint64_t)> runner);
+
+		// Runs for at least cycles in paced slices, stops early when a slice stops early
+		// Returns the cycles elapsed
+		uint64_t Run(uint64_t cycles);
+
+		// Restarts the anchor from now, after the host paused the emulation
+		void Resync();
+
+		PacingStats const& GetStats() const;
+		void ClearStats();
+		void DisplayStats(std::ostream& output) const;
+
+	private:
+		// Ends a slice : sleeps until the time of the cycles run since the anchor
+		void WaitDeadline();
+
+		static int64_t Now();
+		static void SleepUntil(int64_t time);
+
+	private:
+		CPU* _cpu;
+		std::function<uint64_t(uint64_t)> _runner;
+
+		double _clock;
+		double _turbo = 1.0;
+		uint64_t _slice = 0; // 0 : from the clock
+
+		int64_t _spin = 0;
+		int64_t _maxLateness = DEFAULT_MAX_LATENESS;
+
+		// Time and cycles the deadlines are computed from
+		bool _anchored = false;
+		int64_t _anchorTime = 0;
+		uint64_t _anchorCycles = 0;
+
+		PacingStats _stats;
+};
+
+#endif // PACING_HPP
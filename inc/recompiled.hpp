@@ -0,0 +1,355 @@
+#ifndef RECOMPILED_HPP
+#define RECOMPILED_HPP
+
+#include <cstdint>
+#include <cstring>
+
+#include "types.hpp"
+#include "cpu.hpp"
+
+// Interface between the C++ written by the recompiler (see recompiler.hpp) and the emulator
+// The inline helpers below are compiled into the generated library
+
+constexpr uint32_t RECOMPILED_ABI_VERSION = 0x03;
+
+// Symbols exported by a recompiled library
+constexpr char const RECOMPILED_INFO_SYMBOL[]   = "Recompiled6502Info";
+constexpr char const RECOMPILED_BLOCKS_SYMBOL[] = "Recompiled6502Blocks";
+
+// Registers and memory as seen by the recompiled blocks
+struct RecompiledContext {
+	Byte a;
+	Byte x;
+	Byte y;
+	Byte p;
+	Byte sp;
+	Word pc; // natural order, unlike the CPU internals
+
+	uint64_t cycles;
+	uint64_t instructions;
+
+	// Plain memory pages read directly, nullptr sends the read through read (devices)
+	Byte const* pages[0x100];
+
+	Byte (*read)(RecompiledContext* context, Word address);
+	void (*write)(RecompiledContext* context, Word address, Byte value); // every store goes through it
+
+	// Plain memory page the bulk loops may write directly, nullptr for devices and recompiled code
+	Byte* (*writable)(RecompiledContext* context, Byte page);
+
+	// Set by write when recompiled code was overwritten, the block returns after the store
+	bool exit;
+
+	void* user;
+};
+
+// Runs one basic block, leaves pc on the next one
+using RecompiledBlock = void (*)(RecompiledContext* context);
+
+struct RecompiledEntry {
+	Word address;
+	Word end; // address after the last instruction of the block
+	RecompiledBlock block;
+};
+
+struct RecompiledInfo {
+	uint32_t abiVersion;
+	uint32_t romHash; // HashRecompiledROM of the image the blocks were built from
+	Word romStart;
+	uint32_t romSize;
+};
+
+using RecompiledInfoFunction = RecompiledInfo (*)();
+using RecompiledBlocksFunction = RecompiledEntry const* (*)(size_t* count);
+
+// FNV-1a
+inline uint32_t HashRecompiledROM(Byte const* data, size_t size) {
+	uint32_t hash = 0x811C9DC5;
+
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 0x01000193;
+	}
+
+	return hash;
+}
+
+inline Byte RecompiledRead(RecompiledContext* c, Word address) {
+	Byte const* page = c->pages[address >> 8];
+
+	return (page != nullptr) ? page[address & 0xFF] : c->read(c, address);
+}
+
+// Read of an indexed operand, one more cycle when the index crosses a page
+inline Byte RecompiledReadIndexed(RecompiledContext* c, Word base, Byte index) {
+	Word const address = (Word)(base + index);
+
+	if ((base ^ address) & 0xFF00) {
+		c->cycles++;
+	}
+
+	return RecompiledRead(c, address);
+}
+
+// Pointer in zero page, wrapping inside it
+inline Word RecompiledReadPointer(RecompiledContext* c, Byte address) {
+	return (Word)(RecompiledRead(c, address) | (RecompiledRead(c, (Byte)(address + 1)) << 8));
+}
+
+inline void RecompiledPush(RecompiledContext* c, Byte value) {
+	c->write(c, (Word)(0x0100 | c->sp), value);
+	c->sp--;
+}
+
+inline Byte RecompiledPull(RecompiledContext* c) {
+	c->sp++;
+	return RecompiledRead(c, (Word)(0x0100 | c->sp));
+}
+
+inline void RecompiledSetFlag(RecompiledContext* c, STATUS_FLAG flag, bool set) {
+	c->p = set ? (c->p | (Byte) flag) : (c->p & ~(Byte) flag);
+}
+
+inline bool RecompiledIsSet(RecompiledContext* c, STATUS_FLAG flag) {
+	return c->p & (Byte) flag;
+}
+
+inline void RecompiledSetZeroAndNegative(RecompiledContext* c, Byte value) {
+	RecompiledSetFlag(c, STATUS_FLAG::Z, value == 0x00);
+	RecompiledSetFlag(c, STATUS_FLAG::N, value & 0x80);
+}
+
+inline void RecompiledADC(RecompiledContext* c, Byte value) {
+	int const carry = RecompiledIsSet(c, STATUS_FLAG::C) ? 1 : 0;
+	int const sum = c->a + value + carry;
+
+	RecompiledSetFlag(c, STATUS_FLAG::Z, (Byte) sum == 0x00);
+
+	if (!RecompiledIsSet(c, STATUS_FLAG::D)) {
+		RecompiledSetFlag(c, STATUS_FLAG::V, ~(c->a ^ value) & (c->a ^ sum) & 0x80);
+		RecompiledSetFlag(c, STATUS_FLAG::C, sum > 0xFF);
+
+		c->a = (Byte) sum;
+		RecompiledSetFlag(c, STATUS_FLAG::N, c->a & 0x80);
+		return;
+	}
+
+	// NMOS decimal mode : N and V come from the half-adjusted result, Z from the binary one
+	int low = (c->a & 0x0F) + (value & 0x0F) + carry;
+	if (low > 0x09) low += 0x06;
+
+	int high = (c->a >> 4) + (value >> 4) + (low > 0x0F ? 1 : 0);
+
+	RecompiledSetFlag(c, STATUS_FLAG::N, high & 0x08);
+	RecompiledSetFlag(c, STATUS_FLAG::V, ~(c->a ^ value) & (c->a ^ (high << 4)) & 0x80);
+
+	if (high > 0x09) high += 0x06;
+
+	RecompiledSetFlag(c, STATUS_FLAG::C, high > 0x0F);
+
+	c->a = (Byte)((high << 4) | (low & 0x0F));
+}
+
+inline void RecompiledSBC(RecompiledContext* c, Byte value) {
+	int const borrow = RecompiledIsSet(c, STATUS_FLAG::C) ? 0 : 1;
+	int const difference = c->a - value - borrow;
+
+	// flags are the binary ones in both modes on NMOS
+	RecompiledSetFlag(c, STATUS_FLAG::V, (c->a ^ value) & (c->a ^ difference) & 0x80);
+	RecompiledSetFlag(c, STATUS_FLAG::C, difference >= 0);
+	RecompiledSetZeroAndNegative(c, (Byte) difference);
+
+	if (!RecompiledIsSet(c, STATUS_FLAG::D)) {
+		c->a = (Byte) difference;
+		return;
+	}
+
+	int low = (c->a & 0x0F) - (value & 0x0F) - borrow;
+	int high = (c->a >> 4) - (value >> 4);
+
+	if (low & 0x10) {
+		low -= 0x06;
+		high--;
+	}
+
+	if (high & 0x10) high -= 0x06;
+
+	c->a = (Byte)((high << 4) | (low & 0x0F));
+}
+
+inline void RecompiledCompare(RecompiledContext* c, Byte reg, Byte value) {
+	RecompiledSetFlag(c, STATUS_FLAG::C, reg >= value);
+	RecompiledSetZeroAndNegative(c, (Byte)(reg - value));
+}
+
+inline void RecompiledBIT(RecompiledContext* c, Byte value) {
+	RecompiledSetFlag(c, STATUS_FLAG::Z, (c->a & value) == 0x00);
+	RecompiledSetFlag(c, STATUS_FLAG::N, value & 0x80);
+	RecompiledSetFlag(c, STATUS_FLAG::V, value & 0x40);
+}
+
+inline Byte RecompiledASL(RecompiledContext* c, Byte value) {
+	RecompiledSetFlag(c, STATUS_FLAG::C, value & 0x80);
+	value <<= 1;
+	RecompiledSetZeroAndNegative(c, value);
+	return value;
+}
+
+inline Byte RecompiledLSR(RecompiledContext* c, Byte value) {
+	RecompiledSetFlag(c, STATUS_FLAG::C, value & 0x01);
+	value >>= 1;
+	RecompiledSetZeroAndNegative(c, value);
+	return value;
+}
+
+inline Byte RecompiledROL(RecompiledContext* c, Byte value) {
+	Byte const carry = RecompiledIsSet(c, STATUS_FLAG::C) ? 0x01 : 0x00;
+
+	RecompiledSetFlag(c, STATUS_FLAG::C, value & 0x80);
+	value = (Byte)(value << 1) | carry;
+	RecompiledSetZeroAndNegative(c, value);
+	return value;
+}
+
+inline Byte RecompiledROR(RecompiledContext* c, Byte value) {
+	Byte const carry = RecompiledIsSet(c, STATUS_FLAG::C) ? 0x80 : 0x00;
+
+	RecompiledSetFlag(c, STATUS_FLAG::C, value & 0x01);
+	value = (Byte)(value >> 1) | carry;
+	RecompiledSetZeroAndNegative(c, value);
+	return value;
+}
+
+// Copy, fill and compare loops indexed by X or Y (see recompiler.hpp)
+enum class RECOMPILED_BULK : Byte {
+	COPY,    // LDA source / STA destination
+	FILL,    // STA destination
+	COMPARE  // LDA source / CMP destination / BNE out
+};
+
+// Iterations of a loop left before its last one, the index moving by step until it equals end
+inline int RecompiledBulkIterations(Byte index, int step, Byte end) {
+	int const iterations = (Byte)((step > 0) ? end - index : index - end);
+
+	return (iterations == 0 ? 0x100 : iterations) - 1;
+}
+
+// Iterations among the count run by RecompiledBulk where the index crosses a page from base (a cycle more for each read)
+inline int RecompiledBulkPageCrossings(Word base, Byte index, int step, int count) {
+	int const low = (step > 0) ? index : index - count + 1;
+	int const crossing = std::max(low, 0x100 - (base & 0xFF)); // lowest index crossing
+
+	return std::max(0, low + count - crossing);
+}
+
+// Runs up to count iterations of a loop on host memory, source and destination being the addresses before indexing
+// Returns the iterations run : all of them, those before the first difference (COMPARE),
+// or none when a page isn't plain memory, the index would wrap or the areas overlap
+inline int RecompiledBulk(RecompiledContext* c, RECOMPILED_BULK operation, Word source, Word destination, Byte index, int step, int count) {
+	if (count <= 0 || (step > 0 ? index + count - 1 > 0xFF : index - count + 1 < 0x00)) {
+		return 0;
+	}
+
+	// lowest addresses touched, iterations run upwards or downwards from them
+	int const low = (step > 0) ? index : index - count + 1;
+	int const sourceLow = source + low;
+	int const destinationLow = destination + low;
+
+	if (destinationLow + count > 0x10000 || (operation != RECOMPILED_BULK::FILL && sourceLow + count > 0x10000)) {
+		return 0;
+	}
+
+	// zero page and stack hold the pointers and return addresses the loop depends on
+	if (operation != RECOMPILED_BULK::COMPARE && destinationLow < 0x0200) {
+		return 0;
+	}
+
+	if (operation == RECOMPILED_BULK::COPY && sourceLow != destinationLow && sourceLow < destinationLow + count && destinationLow < sourceLow + count) {
+		return 0;
+	}
+
+	Byte const* sources[2] = {};
+	Byte const* compared[2] = {};
+	Byte* destinations[2] = {};
+
+	for (int i = 0; i < 2; i++) {
+		Byte const sourcePage = (Byte)((sourceLow >> 8) + i);
+		Byte const destinationPage = (Byte)((destinationLow >> 8) + i);
+
+		if (operation != RECOMPILED_BULK::FILL && (sourceLow >> 8) + i <= (sourceLow + count - 1) >> 8) {
+			sources[i] = c->pages[sourcePage];
+			if (sources[i] == nullptr) return 0;
+		}
+
+		if ((destinationLow >> 8) + i > (destinationLow + count - 1) >> 8) {
+			continue;
+		}
+
+		if (operation == RECOMPILED_BULK::COMPARE) {
+			compared[i] = c->pages[destinationPage];
+			if (compared[i] == nullptr) return 0;
+		}
+
+		else {
+			destinations[i] = c->writable(c, destinationPage);
+			if (destinations[i] == nullptr) return 0;
+		}
+	}
+
+	// chunks inside a single source and destination page
+	auto const host = [](auto* pages, int base, int position) {
+		int const address = base + position;
+		return pages[(address >> 8) - (base >> 8)] + (address & 0xFF);
+	};
+
+	auto const chunk = [&](int position) {
+		int size = std::min(count - position, 0x100 - ((destinationLow + position) & 0xFF));
+
+		if (operation != RECOMPILED_BULK::FILL) {
+			size = std::min(size, 0x100 - ((sourceLow + position) & 0xFF));
+		}
+
+		return size;
+	};
+
+	if (operation != RECOMPILED_BULK::COMPARE) {
+		for (int position = 0, size = 0; position < count; position += size) {
+			size = chunk(position);
+
+			if (operation == RECOMPILED_BULK::COPY) {
+				std::memmove(host(destinations, destinationLow, position), host(sources, sourceLow, position), size);
+			}
+
+			else {
+				std::memset(host(destinations, destinationLow, position), c->a, size);
+			}
+		}
+
+		return count;
+	}
+
+	// the first difference in the order of the iterations ends the loop
+	int first = -1;
+
+	for (int position = 0, size = 0; position < count; position += size) {
+		size = chunk(position);
+
+		Byte const* const a = host(sources, sourceLow, position);
+		Byte const* const b = host(compared, destinationLow, position);
+
+		if (std::memcmp(a, b, size) == 0) {
+			continue;
+		}
+
+		for (int i = 0; i < size; i++) {
+			if (a[i] != b[i]) {
+				first = position + i;
+
+				if (step > 0) return first;
+			}
+		}
+	}
+
+	return (first < 0) ? count : count - 1 - first;
+}
+
+#endif // RECOMPILED_HPP
@@ -0,0 +1,83 @@
+#ifndef RECOMPILER_HPP
+#define RECOMPILER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "cpu.hpp"
+#include "analysis.hpp"
+#include "recompiled.hpp"
+
+/*
+Ahead-of-time recompilation of a ROM :
+
+- WriteRecompiledSource turns every basic block found by ROMAnalysis into a C++ function working on a
+  RecompiledContext, and exports them with the ROM hash
+- the source is built as a shared library, eg. g++ -O2 -shared -fPIC -Iinc rom.cpp -o rom.so
+- RecompiledROM loads it and runs the CPU block by block, every address without a block (RAM code,
+  computed jumps to unknown targets, BRK, pending interrupts) goes through CPU::Step, which stays the reference
+
+Blocks starting a copy, fill or compare loop indexed by X or Y (eg. LDA (src),Y / STA (dst),Y / INY / BNE)
+run all its iterations but the last one as a single host memcpy, memset or memcmp when the pages are plain
+memory, then the last one as usual, so registers, flags and cycles are those of the whole loop.
+Devices, recompiled code and overlapping areas leave the loop to run iteration by iteration.
+
+Blocks use the 6502 stack frames (JSR pushes the address of its last byte, RTS returns past it) so they and
+the interpreter can call each other, and count cycles with the CPU tables.
+*/
+
+// Writes the C++ source of the library for the blocks of analysis (rom must be the analyzed image)
+void WriteRecompiledSource(ROMAnalysis const& analysis, std::vector<Byte> const& rom, Word romStart, std::ostream& output);
+
+class RecompiledROM {
+	public:
+		RecompiledROM(CPU* cpu);
+		~RecompiledROM();
+
+		RecompiledROM(RecompiledROM const&) = delete;
+		RecompiledROM& operator=(RecompiledROM const&) = delete;
+
+		// false if the library can't be opened, has another ABI or was built from another ROM than the one mapped in the CPU
+		bool Load(std::string const& filepath);
+		bool IsLoaded() const;
+
+		// CPU::RunCycles, running the blocks natively and the rest (interrupt entries included) with the interpreter
+		uint64_t Run(uint64_t cycles);
+
+		// Blocks run natively and steps left to the interpreter since Load
+		uint64_t GetBlocksRun() const;
+		uint64_t GetInterpretedSteps() const;
+
+	private:
+		static Byte ReadCallback(RecompiledContext* context, Word address);
+		static void WriteCallback(RecompiledContext* context, Word address, Byte value);
+		static Byte* WritableCallback(RecompiledContext* context, Byte page);
+
+		void LoadContext(CPUState const& state);
+		void LoadPages();
+
+		// Registers and counters back to the CPU, its interrupt lines and bus are left as a device may have set them
+		void StoreContext();
+
+		void Unload();
+
+	private:
+		CPU* _cpu;
+
+		void* _library = nullptr;
+		RecompiledInfo _info = {};
+
+		RecompiledEntry const* _entries = nullptr;
+		size_t _entriesCount = 0;
+
+		// Indexed by address, nullptr where there is no block or the code under it was overwritten
+		std::vector<RecompiledBlock> _blocks;
+
+		RecompiledContext _context = {};
+
+		uint64_t _blocksRun = 0;
+		uint64_t _interpretedSteps = 0;
+};
+
+#endif // RECOMPILER_HPP
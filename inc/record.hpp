@@ -0,0 +1,81 @@
+#ifndef RECORD_HPP
+#define RECORD_HPP
+
+#include <iostream>
+#include <cstdint>
+
+#include "types.hpp"
+
+/*
+Record stream layout :
+
+- header : "6502REC" followed by RECORD_VERSION
+- events : kind (1 byte), cycles elapsed since the previous event (LEB128), payload
+	- MMIO_READ : address (2 bytes, low byte first) then the value read (1 byte)
+	- IRQ_ASSERT, IRQ_RELEASE, NMI_ASSERT : no payload
+- END closes the stream
+*/
+
+constexpr Byte RECORD_VERSION = 0x01;
+
+enum class INPUT_EVENT : Byte {
+	MMIO_READ   = 0x01,
+	IRQ_ASSERT  = 0x02,
+	IRQ_RELEASE = 0x03,
+	NMI_ASSERT  = 0x04,
+	END         = 0xFF
+};
+
+// Logs every external input seen by a CPU
+class InputRecorder {
+	public:
+		InputRecorder(std::ostream* output);
+
+		void RecordRead(uint64_t cycle, Word address, Byte value);
+		void RecordInterrupt(uint64_t cycle, INPUT_EVENT event);
+
+		// Writes END, nothing can be recorded afterwards
+		void Finish();
+
+	private:
+		void WriteEvent(INPUT_EVENT event, uint64_t cycle);
+
+	private:
+		std::ostream* _output;
+		uint64_t _lastCycle = 0;
+};
+
+// Feeds a stream written by InputRecorder back to a CPU
+class InputReplayer {
+	public:
+		InputReplayer(std::istream* input);
+
+		// false if the header is missing or of another version
+		bool IsValid() const;
+
+		// true once the run asked for an input which doesn't match the stream
+		bool IsDiverged() const;
+
+		// Gets the next interrupt event due at cycle, returns false if there is none
+		bool NextInterrupt(uint64_t cycle, INPUT_EVENT& event);
+
+		// Gets the value of the next MMIO read, returns false (and diverges) if the stream expected something else
+		bool NextRead(uint64_t cycle, Word address, Byte& value);
+
+	private:
+		void ReadEvent();
+
+	private:
+		std::istream* _input;
+
+		bool _valid    = false;
+		bool _diverged = false;
+
+		// Next event of the stream
+		INPUT_EVENT _event   = INPUT_EVENT::END;
+		uint64_t _cycle      = 0;
+		Word _address        = (Word) 0x0000;
+		Byte _value          = (Byte) 0x00;
+};
+
+#endif // RECORD_HPP
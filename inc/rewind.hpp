@@ -0,0 +1,67 @@
+#ifndef REWIND_HPP
+#define REWIND_HPP
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+#include "cpu.hpp"
+
+/*
+Rewind ring buffer
+
+- a keyframe (every page of the map and the registers) is taken every keyframeInterval cycles
+- deltaFrames frames are taken in between, holding only the pages written since the previous frame
+  (the CPU's dirty pages, cleared at every frame : nothing else on the CPU should rely on them)
+- when the buffer grows over maxBytes, the oldest keyframe and its deltas are dropped
+
+Going back restores the nearest frame and executes forward to the requested instruction.
+Re-execution is deterministic as long as the attached devices are (or the CPU is driven by an InputReplayer).
+*/
+
+class Rewind {
+	public:
+		Rewind(CPU* cpu, uint64_t keyframeInterval, size_t deltaFrames, size_t maxBytes);
+
+		// Steps the CPU, taking a frame when one is due
+		void Step();
+
+		// Goes back n instructions, returns false if they are not in the buffer anymore
+		bool StepBack(uint64_t n);
+
+		// Memory currently held by the frames
+		size_t GetSize() const;
+
+		// Drops every frame
+		void Clear();
+
+	private:
+		struct Frame {
+			CPUState state;
+			bool keyframe;
+			std::vector<Byte> pages; // index of every page held
+			std::vector<Byte> data;  // MAX_PAGE_SIZE bytes per page held
+		};
+
+		void Capture();
+		void Restore(size_t index);
+		void DropOldest();
+
+		size_t GetFrameSize(Frame const& frame) const;
+
+	private:
+		CPU* _cpu;
+
+		uint64_t _keyframeInterval;
+		uint64_t _frameInterval;
+		size_t _deltaFrames;
+		size_t _maxBytes;
+
+		std::deque<Frame> _frames;
+		size_t _size = 0;
+
+		uint64_t _nextCapture = 0;
+		size_t _framesSinceKeyframe = 0;
+};
+
+#endif // REWIND_HPP
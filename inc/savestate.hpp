@@ -0,0 +1,52 @@
+#ifndef SAVESTATE_HPP
+#define SAVESTATE_HPP
+
+#include <string>
+#include <type_traits>
+
+#include "cpu.hpp"
+
+/*
+Save state file layout (integers little endian) :
+
+- $0000 : "6502SAV" followed by SAVESTATE_VERSION
+- $0008 : flags (4 bytes), SAVESTATE_FLAG_BASE if pages refer to a base machine
+- $000C : offset of the devices section (4 bytes)
+- $0010 : CPU state (40 bytes, see WriteState)
+- $0038 : variant (1 byte, see SAVESTATE_VARIANT), a state only loads into a CPU of the same variant
+- $0040 : page table, one entry of 4 bytes per page : kind (high byte) and argument (low 3 bytes)
+	- PAGE_DATA : index of the page in the data section
+	- PAGE_FILL : every byte of the page holds the argument (zero pages are stored this way)
+	- PAGE_BASE : the page is the same as in the base machine
+- $0500 : data section, MAX_PAGE_SIZE bytes per stored page
+- devices section : count (4 bytes) then for each attached device its state size (4 bytes) and state
+
+Pages are stored raw and aligned, so a mapped file is loaded with plain copies.
+*/
+
+constexpr Byte SAVESTATE_VERSION = 0x03;
+
+constexpr uint32_t SAVESTATE_FLAG_BASE = 0x00000001;
+
+enum class SAVESTATE_PAGE : Byte {
+	PAGE_DATA = 0x00,
+	PAGE_FILL = 0x01,
+	PAGE_BASE = 0x02
+};
+
+// Instructions decoded by the variant : bit 0 undocumented opcodes, bit 1 CMOS
+template <typename Variant>
+constexpr Byte SAVESTATE_VARIANT = (Variant::UNDOCUMENTED_OPCODES ? 0x01 : 0x00) | (Variant::CMOS ? 0x02 : 0x00);
+
+// base (optional) is a machine both sides can build, e.g. freshly constructed from the same ROM
+// Pages left unchanged from it are not stored
+// (base isn't deduced so nullptr can be passed)
+template <typename Variant, typename Bus>
+bool SaveState(BasicCPU<Variant, Bus> const& cpu, std::string filepath, std::type_identity_t<BasicCPU<Variant, Bus>> const* base = nullptr);
+
+// base must match the one used for saving if the file refers to it
+// Nothing changes when the file or a device state is rejected
+template <typename Variant, typename Bus>
+bool LoadState(BasicCPU<Variant, Bus>& cpu, std::string filepath, std::type_identity_t<BasicCPU<Variant, Bus>> const* base = nullptr);
+
+#endif // SAVESTATE_HPP
@@ -0,0 +1,101 @@
+#ifndef STEPS_HPP
+#define STEPS_HPP
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "cpu.hpp"
+
+/*
+Generator returned by CPU::Steps (C++20 coroutine)
+
+Every resume runs one Tick of the CPU (an instruction, or an entry of the bus log for a CycleCPU, see CycleStepped for
+what the log does and doesn't model) and yields its bus state,
+so a scheduler can interleave several CPUs and devices on a single thread :
+
+	StepGenerator steps = cpu.Steps();
+
+	while (steps.Next()) {
+		BusState const& bus = steps.Get();
+		...
+	}
+*/
+
+class StepGenerator {
+	public:
+		struct promise_type {
+			BusState _current = {};
+
+			StepGenerator get_return_object() {
+				return StepGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+
+			std::suspend_always yield_value(BusState const& state) noexcept {
+				_current = state;
+				return {};
+			}
+
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		class Iterator {
+			public:
+				Iterator(StepGenerator* generator) : _generator(generator) {}
+
+				BusState const& operator*() const { return _generator->Get(); }
+				Iterator& operator++() { if (!_generator->Next()) _generator = nullptr; return *this; }
+
+				bool operator!=(Iterator const& other) const { return _generator != other._generator; }
+
+			private:
+				StepGenerator* _generator;
+		};
+
+		StepGenerator(StepGenerator const&) = delete;
+		StepGenerator& operator=(StepGenerator const&) = delete;
+
+		StepGenerator(StepGenerator&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+
+		StepGenerator& operator=(StepGenerator&& other) noexcept {
+			if (this != &other) {
+				if (_handle) _handle.destroy();
+				_handle = std::exchange(other._handle, nullptr);
+			}
+
+			return *this;
+		}
+
+		~StepGenerator() {
+			if (_handle) _handle.destroy();
+		}
+
+		// Runs up to the next suspension point, returns false once the CPU stopped
+		bool Next() {
+			if (!_handle || _handle.done()) return false;
+
+			_handle.resume();
+
+			return !_handle.done();
+		}
+
+		// Bus state at the last suspension point
+		BusState const& Get() const {
+			return _handle.promise()._current;
+		}
+
+		Iterator begin() { return Next() ? Iterator(this) : end(); }
+		Iterator end() { return Iterator(nullptr); }
+
+	private:
+		explicit StepGenerator(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+	private:
+		std::coroutine_handle<promise_type> _handle;
+};
+
+#endif // STEPS_HPP
@@ -0,0 +1,77 @@
+#ifndef SYMBOLS_HPP
+#define SYMBOLS_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "types.hpp"
+
+/*
+Symbols of the guest program, loaded from :
+
+- ca65/ld65 debug files (ld65 --dbgfile) : the sym lines of type lab, with their size when known, and the
+  source line map (file, line, seg and span lines)
+- VICE label files : al C:8000 .name
+- plain maps : name = $8000 (also 0x8000 or decimal), ; and # start comments
+
+Symbols are kept sorted by address. A symbol covers its size if it has one, otherwise up to the next symbol,
+and addresses are shown as label+$offset inside it.
+
+The CPU trace (CPU::SetSymbols), the listing (ROMAnalysis::SetSymbols) and the call stack profile
+(CallStack::SetNames with Format) use them.
+*/
+
+struct Symbol {
+	std::string name;
+	Word address;
+	Word size; // 0 when unknown
+};
+
+// Bytes assembled from a source line
+struct SourceLine {
+	std::string file;
+	uint32_t line;
+	Word address;
+	Word size;
+};
+
+class SymbolTable {
+	public:
+		// Format detected from the contents, false if the file can't be read
+		bool Load(std::string const& filepath);
+
+		void Add(std::string const& name, Word address, Word size = 0);
+
+		bool IsEmpty() const;
+		std::vector<Symbol> const& GetSymbols() const;
+
+		// Symbol covering address (binary search), nullptr if none
+		Symbol const* Find(Word address) const;
+
+		// Symbol index of every address (-1 where none), through a flattened table built by the first batch
+		// Meant for attributing many samples at once
+		void FindAll(Word const* addresses, size_t count, int32_t* indices) const;
+
+		// label, label+$offset or $XXXX
+		std::string Format(Word address) const;
+
+		// Source lines of debug files, in file order
+		std::vector<SourceLine> const& GetLines() const;
+
+	private:
+		void LoadDebugInfo(std::istream& input);
+		void LoadLabels(std::istream& input);
+
+		void Sort() const;
+
+	private:
+		mutable std::vector<Symbol> _symbols;
+		std::vector<SourceLine> _lines;
+		mutable bool _sorted = true;
+
+		// Symbol index per address, empty until FindAll needs it
+		mutable std::vector<int32_t> _table;
+};
+
+#endif // SYMBOLS_HPP
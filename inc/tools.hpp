@@ -3,7 +3,16 @@
 
 #include "types.hpp"
 
+#include <string>
+#include <vector>
+
 Word GetBigEndianAddress(Word address);
 Word GetLittleEndianAddress(Word address);
 
+// Whole file contents, false if it can't be read
+bool LoadFile(std::vector<Byte>& data, std::string const& filepath);
+
+// Hexadecimal address with an optional '$' ("$C000", "fffc"), false if it isn't one
+bool ParseAddress(std::string const& text, Word& address);
+
 #endif // TOOLS_HPP
@@ -0,0 +1,80 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+
+#include "cpu.hpp"
+
+/*
+Binary execution trace layout :
+
+- header : "6502TRC" followed by TRACE_VERSION
+- one TraceRecord per step, as the CPU was before it (host byte order, little-endian on every supported host)
+
+Records have a fixed size and no padding left uninitialized, so two traces can be compared as raw bytes :
+the first differing byte gives the first differing record (tools/tracediff.cpp).
+*/
+
+constexpr Byte TRACE_VERSION = 0x01;
+constexpr size_t TRACE_HEADER_SIZE = 8;
+
+struct TraceRecord {
+	uint64_t cycles;
+	Word programCounter;
+	Byte bytes[3];  // instruction (opcode and operands)
+	Byte accumulator;
+	Byte indexX;
+	Byte indexY;
+	Byte stackPointer;
+	Byte statusFlags;
+	Byte interrupt; // 1 for an IRQ or NMI entry
+	Byte reserved[5];
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must stay packed");
+
+// Steps a CPU and writes its trace
+class TraceWriter {
+	public:
+		TraceWriter(CPU* cpu, std::ostream* output);
+
+		void Step();
+
+		// CPU::RunCycles, writing the record of every step
+		uint64_t Run(uint64_t cycles);
+
+	private:
+		CPU* _cpu;
+		std::ostream* _output;
+};
+
+// Read only mapping of a trace file
+class TraceFile {
+	public:
+		TraceFile() = default;
+		~TraceFile();
+
+		TraceFile(TraceFile const&) = delete;
+		TraceFile& operator=(TraceFile const&) = delete;
+
+		// false if the file can't be mapped or has no valid header
+		bool Open(std::string const& filepath);
+
+		TraceRecord const* GetRecords() const;
+		size_t GetCount() const;
+
+	private:
+		void Close();
+
+	private:
+		void* _data = nullptr;
+		size_t _size = 0;
+};
+
+// Offset of the first byte differing between a and b, size if they are equal
+// Compared by vector registers where available
+size_t FindFirstDifference(void const* a, void const* b, size_t size);
+
+#endif // TRACE_HPP
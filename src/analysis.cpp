@@ -0,0 +1,551 @@
+#include "analysis.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+#include "cpu.hpp"
+#include "symbols.hpp"
+
+ROMAnalysis::ROMAnalysis(std::vector<Byte> const* rom, Word romStart, OpcodeTable const& opcodes) {
+	_rom = rom;
+	_romStart = romStart;
+	_opcodes = &opcodes;
+
+	_kinds.assign(_rom->size(), BYTE_KIND::UNKNOWN);
+}
+
+void ROMAnalysis::AddEntryPoint(Word address, std::string const& name) {
+	_entryPoints.push_back(address);
+
+	if (!name.empty()) {
+		_names[address] = name;
+	}
+}
+
+void ROMAnalysis::SetSymbols(SymbolTable const* symbols) {
+	_symbols = symbols;
+}
+
+void ROMAnalysis::Analyze() {
+	// vectors only exist if the ROM covers the top of the address space
+	if (IsInROM(NMI_LOW) && IsInROM(IRQ_HIGH)) {
+		for (Word vector : { RESET_LOW, NMI_LOW, IRQ_LOW }) {
+			for (Word i = 0; i < 2; i++) {
+				_kinds[vector + i - _romStart] = BYTE_KIND::DATA;
+			}
+		}
+
+		// named before exploring so the listing keeps the vector name over a generic label
+		if (_names.find(ReadWord(IRQ_LOW)) == _names.end())   _names[ReadWord(IRQ_LOW)]   = "IRQ";
+		if (_names.find(ReadWord(NMI_LOW)) == _names.end())   _names[ReadWord(NMI_LOW)]   = "NMI";
+		if (_names.find(ReadWord(RESET_LOW)) == _names.end()) _names[ReadWord(RESET_LOW)] = "RESET";
+
+		_entryPoints.push_back(ReadWord(RESET_LOW));
+		_entryPoints.push_back(ReadWord(NMI_LOW));
+		_entryPoints.push_back(ReadWord(IRQ_LOW));
+	}
+
+	for (Word entry : _entryPoints) {
+		Explore(entry);
+	}
+
+	BuildBlocks();
+}
+
+bool ROMAnalysis::IsInROM(Word address) const {
+	return address >= _romStart && (size_t)(address - _romStart) < _rom->size();
+}
+
+BYTE_KIND ROMAnalysis::GetKind(Word address) const {
+	return IsInROM(address) ? _kinds[address - _romStart] : BYTE_KIND::UNKNOWN;
+}
+
+std::map<Word, BasicBlock> const& ROMAnalysis::GetBlocks() const {
+	return _blocks;
+}
+
+std::vector<JumpTable> const& ROMAnalysis::GetJumpTables() const {
+	return _jumpTables;
+}
+
+std::vector<Word> ROMAnalysis::GetInstructions() const {
+	std::vector<Word> instructions;
+
+	for (size_t i = 0; i < _kinds.size(); i++) {
+		if (_kinds[i] == BYTE_KIND::OPCODE) {
+			instructions.push_back((Word)(_romStart + i));
+		}
+	}
+
+	return instructions;
+}
+
+std::set<Word> const& ROMAnalysis::GetExternalTargets() const {
+	return _externalTargets;
+}
+
+std::string ROMAnalysis::GetLabel(Word address) const {
+	auto const name = _names.find(address);
+
+	if (name != _names.end()) {
+		return name->second;
+	}
+
+	if (_symbols != nullptr) {
+		Symbol const* const symbol = _symbols->Find(address);
+
+		if (symbol != nullptr && symbol->address == address) {
+			return symbol->name;
+		}
+	}
+
+	if (_blocks.find(address) == _blocks.end()) {
+		return "";
+	}
+
+	std::ostringstream label;
+	label << "L_" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << address;
+
+	return label.str();
+}
+
+void ROMAnalysis::DisplayListing(std::ostream& output) const {
+	std::ios_base::fmtflags f(output.flags());
+	output << std::hex << std::uppercase << std::setfill('0');
+
+	size_t i = 0;
+
+	while (i < _kinds.size()) {
+		Word const address = (Word)(_romStart + i);
+
+		if (_kinds[i] == BYTE_KIND::OPCODE) {
+			std::string const label = GetLabel(address);
+
+			if (!label.empty()) {
+				output << std::endl << label << ":" << std::endl;
+			}
+
+			OpcodeInfo const& info = (*_opcodes)[(*_rom)[i]];
+			Byte const length = GetInstructionLength(info.mode);
+
+			Byte bytes[3] = { ReadByte(address), ReadByte((Word)(address + 1)), ReadByte((Word)(address + 2)) };
+
+			std::ostringstream hex;
+			hex << std::hex << std::uppercase << std::setfill('0');
+			for (Byte b = 0; b < length; b++) {
+				hex << (b ? " " : "") << std::setw(2) << (int) bytes[b];
+			}
+
+			output << "$" << std::setw(4) << address << "    " << std::setfill(' ') << std::left << std::setw(12) << hex.str() << std::right << std::setfill('0');
+			output << Disassemble(address, bytes, *_opcodes);
+
+			// name the target of direct transfers, and the operand of others when symbols are known
+			if (info.flow == FLOW::BRANCH || info.flow == FLOW::JUMP || info.flow == FLOW::CALL) {
+				Word const target = (info.flow == FLOW::BRANCH) ? GetBranchTarget(address, bytes[1]) : (Word)(bytes[1] | (bytes[2] << 8));
+				std::string const targetLabel = GetReference(target);
+
+				if (!targetLabel.empty()) {
+					output << " ; " << targetLabel;
+				}
+			}
+
+			else if (_symbols != nullptr && info.mode != OPERAND_MODE::IMPLIED && info.mode != OPERAND_MODE::ACCUMULATOR && info.mode != OPERAND_MODE::IMMEDIATE) {
+				Word const operand = (length == 3) ? (Word)(bytes[1] | (bytes[2] << 8)) : bytes[1];
+				std::string const operandLabel = GetReference(operand);
+
+				if (!operandLabel.empty()) {
+					output << " ; " << operandLabel;
+				}
+			}
+
+			auto const computed = _computedTargets.find(address);
+			if (computed != _computedTargets.end()) {
+				output << " ; " << std::dec << computed->second.size() << " target(s)" << std::hex;
+			}
+
+			output << std::endl;
+
+			i += length;
+			continue;
+		}
+
+		// run of bytes of the same kind which aren't code
+		size_t end = i;
+		while (end < _kinds.size() && _kinds[end] == _kinds[i]) end++;
+
+		char const* comment = (_kinds[i] == BYTE_KIND::DATA) ? " ; data" : "";
+
+		output << std::endl;
+
+		while (i < end) {
+			Byte const value = (*_rom)[i];
+
+			size_t fill = i;
+			while (fill < end && (*_rom)[fill] == value) fill++;
+
+			// long fills (erased EPROM areas, padding, ...) on one line
+			if (fill - i >= 16) {
+				output << "$" << std::setw(4) << (Word)(_romStart + i) << "    .RES " << std::dec << (fill - i) << std::hex << ", $" << std::setw(2) << (int) value << comment << std::endl;
+				i = fill;
+				continue;
+			}
+
+			output << "$" << std::setw(4) << (Word)(_romStart + i) << "    .BYTE ";
+
+			for (size_t b = 0; b < 8 && i < end; b++, i++) {
+				output << (b ? ", $" : "$") << std::setw(2) << (int)(*_rom)[i];
+			}
+
+			output << comment << std::endl;
+		}
+	}
+
+	output.flags(f);
+}
+
+void ROMAnalysis::DisplayGraph(std::ostream& output) const {
+	std::ios_base::fmtflags f(output.flags());
+	output << std::hex << std::uppercase << std::setfill('0');
+
+	output << "digraph ROM {" << std::endl;
+	output << "\tnode [shape=box, fontname=monospace];" << std::endl;
+
+	for (auto const& [start, block] : _blocks) {
+		output << "\t\"" << GetLabel(start) << "\" [label=\"" << GetLabel(start) << "\\n$" << std::setw(4) << block.start << "-$" << std::setw(4) << block.last << "\"];" << std::endl;
+
+		for (Word successor : block.successors) {
+			std::string const label = GetLabel(successor);
+
+			if (label.empty()) {
+				output << "\t\"" << GetLabel(start) << "\" -> \"$" << std::setw(4) << successor << "\" [style=dashed];" << std::endl;
+			}
+
+			else {
+				output << "\t\"" << GetLabel(start) << "\" -> \"" << label << "\";" << std::endl;
+			}
+		}
+
+		if (block.unresolved) {
+			output << "\t\"" << GetLabel(start) << "\" -> \"?\" [style=dotted];" << std::endl;
+		}
+	}
+
+	output << "}" << std::endl;
+
+	output.flags(f);
+}
+
+Byte ROMAnalysis::ReadByte(Word address) const {
+	return IsInROM(address) ? (*_rom)[address - _romStart] : (Byte) 0x00;
+}
+
+Word ROMAnalysis::ReadWord(Word address) const {
+	return (Word)(ReadByte(address) | (ReadByte((Word)(address + 1)) << 8));
+}
+
+void ROMAnalysis::Explore(Word address) {
+	std::vector<Word> pending = { address };
+	_leaders.insert(address);
+
+	// instructions decoded since the start of the current straight-line run, to look for table loads
+	std::vector<Word> run;
+
+	while (!pending.empty()) {
+		Word pc = pending.back();
+		pending.pop_back();
+
+		if (!IsInROM(pc)) {
+			_externalTargets.insert(pc);
+			continue;
+		}
+
+		run.clear();
+
+		while (IsInROM(pc) && _kinds[pc - _romStart] == BYTE_KIND::UNKNOWN) {
+			OpcodeInfo const& info = (*_opcodes)[ReadByte(pc)];
+
+			if (info.flow == FLOW::INVALID) {
+				break;
+			}
+
+			Byte const length = GetInstructionLength(info.mode);
+
+			// the operands must be unclaimed ROM bytes too
+			bool fits = true;
+			for (Byte b = 1; b < length; b++) {
+				fits &= GetKind((Word)(pc + b)) == BYTE_KIND::UNKNOWN && IsInROM((Word)(pc + b)) && (Word)(pc + b) > pc;
+			}
+
+			if (!fits) {
+				break;
+			}
+
+			_kinds[pc - _romStart] = BYTE_KIND::OPCODE;
+			for (Byte b = 1; b < length; b++) {
+				_kinds[pc + b - _romStart] = BYTE_KIND::OPERAND;
+			}
+
+			run.push_back(pc);
+
+			Word const next = (Word)(pc + length);
+
+			switch (info.flow) {
+				case FLOW::BRANCH:
+					AddTarget(GetBranchTarget(pc, ReadByte((Word)(pc + 1))), pending);
+					_leaders.insert(next);
+					break;
+
+				case FLOW::CALL:
+					AddTarget(ReadWord((Word)(pc + 1)), pending);
+					_leaders.insert(next);
+					break;
+
+				case FLOW::JUMP:
+					AddTarget(ReadWord((Word)(pc + 1)), pending);
+					break;
+
+				case FLOW::JUMP_INDIRECT:
+					// the 65C02 JMP ($xxxx, X) is left unresolved
+					if (info.mode == OPERAND_MODE::INDIRECT) {
+						ResolveIndirectJump(pc, run, pending);
+					}
+					break;
+
+				case FLOW::RETURN:
+					if (ReadByte(pc) == 0x60) { // RTS
+						ResolvePushReturn(pc, run, pending);
+					}
+					break;
+
+				default:
+					break;
+			}
+
+			if (info.flow != FLOW::NEXT && info.flow != FLOW::BRANCH && info.flow != FLOW::CALL) {
+				break;
+			}
+
+			// wrapped around the top of the address space
+			if (next < pc) {
+				break;
+			}
+
+			pc = next;
+		}
+	}
+}
+
+void ROMAnalysis::AddTarget(Word target, std::vector<Word>& pending) {
+	_leaders.insert(target);
+
+	if (IsInROM(target)) {
+		pending.push_back(target);
+	}
+
+	else {
+		_externalTargets.insert(target);
+	}
+}
+
+size_t ROMAnalysis::ResolveIndirectJump(Word jump, std::vector<Word> const& run, std::vector<Word>& pending) {
+	Word const pointer = ReadWord((Word)(jump + 1));
+
+	// fixed vector in ROM
+	if (IsInROM(pointer) && IsInROM((Word)(pointer + 1))) {
+		for (Word b = 0; b < 2; b++) {
+			if (_kinds[pointer + b - _romStart] == BYTE_KIND::UNKNOWN) {
+				_kinds[pointer + b - _romStart] = BYTE_KIND::DATA;
+			}
+		}
+
+		Word const target = ReadWord(pointer);
+
+		_computedTargets[jump].push_back(target);
+		AddTarget(target, pending);
+
+		return 1;
+	}
+
+	Word const low = FindTableLoad(run, pointer);
+	Word const high = FindTableLoad(run, (Word)(pointer + 1));
+
+	if (low == 0 || high == 0) {
+		return 0;
+	}
+
+	ReadJumpTable({ jump, low, high, (Byte)((high == low + 1) ? 2 : 1), {} }, 0, pending);
+
+	return _computedTargets[jump].size();
+}
+
+size_t ROMAnalysis::ResolvePushReturn(Word rts, std::vector<Word> const& run, std::vector<Word>& pending) {
+	// LDA high, X / PHA / LDA low, X / PHA / RTS
+	size_t const n = run.size();
+
+	if (n < 5 || ReadByte(run[n - 2]) != 0x48 || ReadByte(run[n - 4]) != 0x48) {
+		return 0;
+	}
+
+	Byte const highLoad = ReadByte(run[n - 5]);
+	Byte const lowLoad = ReadByte(run[n - 3]);
+
+	if ((highLoad != 0xBD && highLoad != 0xB9) || (lowLoad != 0xBD && lowLoad != 0xB9)) {
+		return 0;
+	}
+
+	Word const high = ReadWord((Word)(run[n - 5] + 1));
+	Word const low = ReadWord((Word)(run[n - 3] + 1));
+
+	// RTS returns to the pulled address + 1
+	ReadJumpTable({ rts, low, high, (Byte)((high == low + 1) ? 2 : 1), {} }, 1, pending);
+
+	return _computedTargets[rts].size();
+}
+
+Word ROMAnalysis::FindTableLoad(std::vector<Word> const& run, Word pointer) const {
+	for (size_t i = run.size(); i-- > 1;) {
+		Byte const opcode = ReadByte(run[i]);
+
+		bool const store = (opcode == 0x85 && pointer < 0x100 && ReadByte((Word)(run[i] + 1)) == pointer)
+			|| (opcode == 0x8D && ReadWord((Word)(run[i] + 1)) == pointer);
+
+		if (!store) {
+			continue;
+		}
+
+		Byte const load = ReadByte(run[i - 1]);
+
+		// LDA absolute, X or LDA absolute, Y right before the store
+		if (load == 0xBD || load == 0xB9) {
+			return ReadWord((Word)(run[i - 1] + 1));
+		}
+
+		return 0;
+	}
+
+	return 0;
+}
+
+void ROMAnalysis::ReadJumpTable(JumpTable table, int adjust, std::vector<Word>& pending) {
+	// an index register can't go further
+	for (int i = 0; i < 0x100; i++) {
+		Word const low = (Word)(table.low + i * table.stride);
+		Word const high = (Word)(table.high + i * table.stride);
+
+		bool const claimed = GetKind(low) == BYTE_KIND::OPCODE || GetKind(low) == BYTE_KIND::OPERAND
+			|| GetKind(high) == BYTE_KIND::OPCODE || GetKind(high) == BYTE_KIND::OPERAND;
+
+		if (!IsInROM(low) || !IsInROM(high) || claimed) {
+			break;
+		}
+
+		// split tables end where the other one starts
+		if (table.stride == 1 && i > 0 && (low == table.high || high == table.low)) {
+			break;
+		}
+
+		Word const target = (Word)((ReadByte(low) | (ReadByte(high) << 8)) + adjust);
+
+		if (!IsInROM(target) || GetKind(target) == BYTE_KIND::OPERAND || GetKind(target) == BYTE_KIND::DATA) {
+			break;
+		}
+
+		_kinds[low - _romStart] = BYTE_KIND::DATA;
+		_kinds[high - _romStart] = BYTE_KIND::DATA;
+
+		table.targets.push_back(target);
+	}
+
+	if (table.targets.empty()) {
+		return;
+	}
+
+	for (Word target : table.targets) {
+		_computedTargets[table.jump].push_back(target);
+		AddTarget(target, pending);
+	}
+
+	_jumpTables.push_back(table);
+}
+
+void ROMAnalysis::BuildBlocks() {
+	_blocks.clear();
+
+	for (Word leader : _leaders) {
+		if (GetKind(leader) != BYTE_KIND::OPCODE) {
+			continue;
+		}
+
+		BasicBlock block;
+		block.start = leader;
+
+		Word pc = leader;
+
+		while (true) {
+			OpcodeInfo const& info = (*_opcodes)[ReadByte(pc)];
+			int const next = pc + GetInstructionLength(info.mode);
+
+			bool const fallsThrough = next <= 0xFFFF && GetKind((Word) next) == BYTE_KIND::OPCODE;
+
+			if (info.flow == FLOW::NEXT && fallsThrough && _leaders.count((Word) next) == 0) {
+				pc = (Word) next;
+				continue;
+			}
+
+			block.last = pc;
+			block.end = (Word) next;
+
+			switch (info.flow) {
+				case FLOW::NEXT:
+					if (fallsThrough) block.successors.push_back((Word) next);
+					break;
+
+				case FLOW::BRANCH:
+					block.successors.push_back(GetBranchTarget(pc, ReadByte((Word)(pc + 1))));
+					if (fallsThrough) block.successors.push_back((Word) next);
+					break;
+
+				case FLOW::CALL:
+					block.successors.push_back(ReadWord((Word)(pc + 1)));
+					if (fallsThrough) block.successors.push_back((Word) next);
+					break;
+
+				case FLOW::JUMP:
+					block.successors.push_back(ReadWord((Word)(pc + 1)));
+					break;
+
+				case FLOW::JUMP_INDIRECT:
+				case FLOW::RETURN: {
+					auto const computed = _computedTargets.find(pc);
+
+					if (computed != _computedTargets.end()) {
+						block.successors = computed->second;
+					}
+
+					// a plain RTS/RTI returns to its caller, only the computed jumps are unknown
+					else if (info.flow == FLOW::JUMP_INDIRECT) {
+						block.unresolved = true;
+					}
+					break;
+				}
+
+				default:
+					break;
+			}
+
+			break;
+		}
+
+		_blocks[leader] = block;
+	}
+}
+
+std::string ROMAnalysis::GetReference(Word address) const {
+	std::string const label = GetLabel(address);
+
+	if (!label.empty() || _symbols == nullptr || _symbols->Find(address) == nullptr) {
+		return label;
+	}
+
+	return _symbols->Format(address);
+}
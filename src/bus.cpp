@@ -0,0 +1,211 @@
+#include "bus.hpp"
+
+#include <thread>
+
+// Device seen by one CPU, routes its accesses to the shared pages
+class SharedBus::Port : public Device {
+	public:
+		Port(SharedBus* bus, size_t index) : _bus(bus), _index(index) {}
+
+		// Instructions add their cycles before accessing memory, the cycle published before the instruction orders them
+		Byte Read(Word address) override {
+			Processor& processor = *_bus->_processors[_index];
+
+			if (_bus->_order == BUS_ORDER::EXACT) {
+				_bus->WaitTurn(_index);
+			}
+
+			processor.reads++;
+
+			return _bus->Load(address);
+		}
+
+		void Write(Word address, Byte value) override {
+			Processor& processor = *_bus->_processors[_index];
+
+			if (_bus->_order == BUS_ORDER::EXACT) {
+				_bus->WaitTurn(_index);
+			}
+
+			processor.writes++;
+
+			_bus->Store(address, value);
+		}
+
+	private:
+		SharedBus* _bus;
+		size_t _index;
+};
+
+SharedBus::SharedBus(Word start, Word size, BUS_ORDER order, uint64_t quantum) {
+	Word const first = start >> 8;
+	Word const last = std::min(((uint32_t) start + size + MAX_PAGE_SIZE - 1) >> 8, (uint32_t) MAX_PAGES);
+
+	_start = (Word)(first << 8);
+	_size = (Word)((last - first) * MAX_PAGE_SIZE);
+	_order = order;
+	_quantum = std::max<uint64_t>(quantum, 1);
+
+	_memory = std::make_unique<std::atomic<Byte>[]>((size_t)(last - first) * MAX_PAGE_SIZE);
+}
+
+SharedBus::~SharedBus() = default;
+
+void SharedBus::Attach(CPU* cpu) {
+	size_t const pages = (size_t) _size / MAX_PAGE_SIZE;
+
+	if (_processors.empty()) {
+		for (size_t page = 0; page < pages; page++) {
+			Byte const* const data = cpu->GetPage((Byte)((_start >> 8) + page));
+
+			for (size_t i = 0; i < MAX_PAGE_SIZE; i++) {
+				_memory[page * MAX_PAGE_SIZE + i].store(data[i], std::memory_order_relaxed);
+			}
+		}
+	}
+
+	auto processor = std::make_unique<Processor>();
+	processor->cpu = cpu;
+	processor->port = std::make_unique<Port>(this, _processors.size());
+
+	cpu->AttachDevice(processor->port.get(), _start, _size);
+
+	_processors.push_back(std::move(processor));
+}
+
+uint64_t SharedBus::Run(uint64_t cycles) {
+	if (_processors.empty()) {
+		return 0;
+	}
+
+	// every cycle published before any thread starts, so none goes ahead of a CPU not started yet
+	for (auto& processor : _processors) {
+		processor->cycle.store(processor->cpu->GetCycles(), std::memory_order_relaxed);
+	}
+
+	std::barrier<> quantumEnd((std::ptrdiff_t) _processors.size());
+	std::vector<uint64_t> elapsed(_processors.size(), 0);
+	std::vector<std::thread> threads;
+
+	// the calling thread runs the first CPU
+	for (size_t i = 1; i < _processors.size(); i++) {
+		threads.emplace_back([&, i]() {
+			elapsed[i] = RunProcessor(i, cycles, quantumEnd);
+		});
+	}
+
+	elapsed[0] = RunProcessor(0, cycles, quantumEnd);
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	return *std::max_element(elapsed.begin(), elapsed.end());
+}
+
+Byte SharedBus::Peek(Word address) const {
+	return Load(address);
+}
+
+void SharedBus::Poke(Word address, Byte value) {
+	Store(address, value);
+}
+
+uint64_t SharedBus::GetReads() const {
+	uint64_t reads = 0;
+
+	for (auto const& processor : _processors) {
+		reads += processor->reads;
+	}
+
+	return reads;
+}
+
+uint64_t SharedBus::GetWrites() const {
+	uint64_t writes = 0;
+
+	for (auto const& processor : _processors) {
+		writes += processor->writes;
+	}
+
+	return writes;
+}
+
+uint64_t SharedBus::GetWaits() const {
+	uint64_t waits = 0;
+
+	for (auto const& processor : _processors) {
+		waits += processor->waits;
+	}
+
+	return waits;
+}
+
+uint64_t SharedBus::RunProcessor(size_t index, uint64_t cycles, std::barrier<>& quantumEnd) {
+	Processor& processor = *_processors[index];
+	CPU& cpu = *processor.cpu;
+
+	uint64_t elapsed = 0;
+
+	if (_order == BUS_ORDER::EXACT) {
+		// no quantum, accesses wait on the cycles published
+		quantumEnd.arrive_and_drop();
+
+		elapsed = cpu.RunCycles(cycles, [&]() {
+			processor.cycle.store(cpu.GetCycles(), std::memory_order_release);
+			cpu.Step();
+		});
+	}
+
+	else {
+		uint64_t limit = cpu.GetCycles() + _quantum;
+
+		elapsed = cpu.RunCycles(cycles, [&]() {
+			while (cpu.GetCycles() >= limit) {
+				quantumEnd.arrive_and_wait();
+				limit += _quantum;
+			}
+
+			cpu.Step();
+		});
+
+		// a CPU done leaves the others to their quanta
+		quantumEnd.arrive_and_drop();
+	}
+
+	processor.cycle.store(UINT64_MAX, std::memory_order_release);
+
+	return elapsed;
+}
+
+void SharedBus::WaitTurn(size_t index) {
+	uint64_t const cycle = _processors[index]->cycle.load(std::memory_order_relaxed);
+
+	for (size_t other = 0; other < _processors.size(); other++) {
+		if (other == index) {
+			continue;
+		}
+
+		// on the same cycle the CPU attached first goes first
+		auto const isBehind = [&]() {
+			uint64_t const published = _processors[other]->cycle.load(std::memory_order_acquire);
+			return published < cycle || (published == cycle && other < index);
+		};
+
+		if (isBehind()) {
+			_processors[index]->waits++;
+
+			do {
+				std::this_thread::yield();
+			} while (isBehind());
+		}
+	}
+}
+
+Byte SharedBus::Load(Word address) const {
+	return _memory[(Word)(address - _start)].load(std::memory_order_relaxed);
+}
+
+void SharedBus::Store(Word address, Byte value) {
+	_memory[(Word)(address - _start)].store(value, std::memory_order_relaxed);
+}
@@ -0,0 +1,221 @@
+#include "callstack.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+#include "opcodes.hpp"
+
+CallStack::CallStack(CPU* cpu) {
+	_cpu = cpu;
+	_lastChange = _cpu->GetCycles();
+}
+
+void CallStack::Step() {
+	CPUState const state = _cpu->GetState();
+	Word const pc = state.programCounter;
+	bool const interrupt = _cpu->IsInterruptPending();
+
+	Byte const opcode = interrupt ? 0x00 : _cpu->GetPage(pc >> 8)[pc & 0xFF];
+	int const moves = interrupt ? 3 : _cpu->GetOpcodes()[opcode].stack;
+
+	if (moves > 0 && state.stackPointer < moves) {
+		_anomalies.push_back({ CALL_ANOMALY::STACK_OVERFLOW, pc, 0x0000, 0x0000, state.cycles });
+	}
+
+	if (moves < 0 && state.stackPointer - moves > 0xFF) {
+		_anomalies.push_back({ CALL_ANOMALY::STACK_UNDERFLOW, pc, 0x0000, 0x0000, state.cycles });
+	}
+
+	_cpu->Step();
+
+	Word const next = _cpu->GetState().programCounter;
+
+	if (interrupt) {
+		Push({ next, pc, state.cycles, true });
+	}
+
+	else if (_cpu->GetOpcodes()[opcode].flow == FLOW::CALL) {
+		// JSR pushes pc + 2, RTS resumes after it
+		Push({ next, (Word)(pc + 3), state.cycles, false });
+	}
+
+	else if (_cpu->GetOpcodes()[opcode].flow == FLOW::RETURN) {
+		Return(pc, next);
+	}
+}
+
+uint64_t CallStack::Run(uint64_t cycles) {
+	return _cpu->RunCycles(cycles, [this]() { Step(); });
+}
+
+std::deque<CallFrame> const& CallStack::GetFrames() const {
+	return _frames;
+}
+
+std::vector<CallAnomaly> const& CallStack::GetAnomalies() const {
+	return _anomalies;
+}
+
+std::map<Word, SubroutineProfile> CallStack::GetProfile() {
+	Attribute();
+
+	// activations not returned from yet
+	std::map<Word, SubroutineProfile> profile = _profile;
+	std::unordered_map<Word, bool> counted;
+
+	for (CallFrame const& frame : _frames) {
+		if (!counted[frame.target]) {
+			profile[frame.target].inclusiveCycles += _cpu->GetCycles() - frame.entryCycle;
+			counted[frame.target] = true;
+		}
+	}
+
+	return profile;
+}
+
+void CallStack::SetNames(std::function<std::string(Word)> names) {
+	_names = names;
+}
+
+void CallStack::DisplayProfile(std::ostream& output) {
+	std::map<Word, SubroutineProfile> const profile = GetProfile();
+	std::vector<std::pair<Word, SubroutineProfile>> sorted(profile.begin(), profile.end());
+
+	std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) {
+		return a.second.inclusiveCycles > b.second.inclusiveCycles;
+	});
+
+	output << std::left << std::setw(24) << "subroutine" << std::right << std::setw(12) << "calls" << std::setw(16) << "inclusive" << std::setw(16) << "exclusive" << std::endl;
+
+	for (auto const& [target, entry] : sorted) {
+		output << std::left << std::setw(24) << GetName(target) << std::right << std::setw(12) << entry.calls
+			<< std::setw(16) << entry.inclusiveCycles << std::setw(16) << entry.exclusiveCycles << std::endl;
+	}
+}
+
+void CallStack::DisplayFoldedStacks(std::ostream& output) {
+	Attribute();
+
+	for (auto const& [path, cycles] : _folded) {
+		output << "root";
+
+		for (Word target : path) {
+			output << ";" << GetName(target);
+		}
+
+		output << " " << cycles << std::endl;
+	}
+}
+
+void CallStack::DisplayAnomalies(std::ostream& output) const {
+	static char const* const KINDS[] = { "mismatched return", "unmatched return", "stack overflow", "stack underflow" };
+
+	for (CallAnomaly const& anomaly : _anomalies) {
+		output << "cycle " << std::dec << anomaly.cycle << " $" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << anomaly.pc
+			<< " " << KINDS[(int) anomaly.kind];
+
+		if (anomaly.kind == CALL_ANOMALY::MISMATCHED_RETURN || anomaly.kind == CALL_ANOMALY::UNMATCHED_RETURN) {
+			output << " to $" << std::setw(4) << anomaly.actual << " (expected $" << std::setw(4) << anomaly.expected << ")";
+		}
+
+		output << std::dec << std::setfill(' ') << std::endl;
+	}
+}
+
+void CallStack::Clear() {
+	_frames.clear();
+	_anomalies.clear();
+	_profile.clear();
+	_active.clear();
+	_folded.clear();
+	_path.clear();
+
+	_lastChange = _cpu->GetCycles();
+}
+
+void CallStack::Attribute() {
+	uint64_t const now = _cpu->GetCycles();
+	uint64_t const elapsed = now - _lastChange;
+
+	if (elapsed == 0) {
+		return;
+	}
+
+	if (!_frames.empty()) {
+		_profile[_frames.back().target].exclusiveCycles += elapsed;
+	}
+
+	_folded[_path] += elapsed;
+	_lastChange = now;
+}
+
+void CallStack::Push(CallFrame const& frame) {
+	// cycles of the call go to the caller
+	Attribute();
+
+	if (_frames.size() == MAX_CALL_FRAMES) {
+		CallFrame const& abandoned = _frames.front();
+
+		if (--_active[abandoned.target] == 0) {
+			_profile[abandoned.target].inclusiveCycles += frame.entryCycle - abandoned.entryCycle;
+		}
+
+		_frames.pop_front();
+		_path.erase(_path.begin());
+	}
+
+	_frames.push_back(frame);
+	_path.push_back(frame.target);
+
+	_profile[frame.target].calls++;
+	_active[frame.target]++;
+}
+
+void CallStack::Return(Word pc, Word address) {
+	// cycles of the return go to the callee
+	Attribute();
+
+	if (_frames.empty()) {
+		_anomalies.push_back({ CALL_ANOMALY::UNMATCHED_RETURN, pc, 0x0000, address, _cpu->GetCycles() });
+		return;
+	}
+
+	Word const expected = _frames.back().returnAddress;
+
+	// the deepest frame matching, the top one unless frames were abandoned
+	size_t depth = _frames.size();
+	while (depth > 0 && _frames[depth - 1].returnAddress != address) {
+		depth--;
+	}
+
+	if (depth == 0) {
+		_anomalies.push_back({ CALL_ANOMALY::UNMATCHED_RETURN, pc, expected, address, _cpu->GetCycles() });
+		return;
+	}
+
+	if (depth != _frames.size()) {
+		_anomalies.push_back({ CALL_ANOMALY::MISMATCHED_RETURN, pc, expected, address, _cpu->GetCycles() });
+	}
+
+	while (_frames.size() >= depth) {
+		CallFrame const& frame = _frames.back();
+
+		if (--_active[frame.target] == 0) {
+			_profile[frame.target].inclusiveCycles += _cpu->GetCycles() - frame.entryCycle;
+		}
+
+		_frames.pop_back();
+		_path.pop_back();
+	}
+}
+
+std::string CallStack::GetName(Word address) const {
+	if (_names) {
+		return _names(address);
+	}
+
+	std::ostringstream name;
+	name << "L_" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << address;
+
+	return name.str();
+}
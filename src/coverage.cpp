@@ -0,0 +1,145 @@
+#include "coverage.hpp"
+
+#include <fstream>
+#include <map>
+#include <bit>
+
+#include "opcodes.hpp"
+#include "symbols.hpp"
+
+Coverage::Coverage() {
+	Clear();
+}
+
+bool Coverage::IsMarked(COVERAGE_BIT bit, Word address) const {
+	return (_bits[(size_t) bit][address >> 6] >> (address & 0x3F)) & 1;
+}
+
+size_t Coverage::Count(COVERAGE_BIT bit) const {
+	size_t count = 0;
+
+	for (uint64_t word : _bits[(size_t) bit]) {
+		count += std::popcount(word);
+	}
+
+	return count;
+}
+
+void Coverage::Clear() {
+	for (auto& bits : _bits) {
+		bits.fill(0);
+	}
+}
+
+void Coverage::Merge(Coverage const& other) {
+	for (size_t bit = 0; bit < _bits.size(); bit++) {
+		for (size_t i = 0; i < COVERAGE_WORDS; i++) {
+			_bits[bit][i] |= other._bits[bit][i];
+		}
+	}
+}
+
+bool Coverage::Save(std::string const& filepath) const {
+	std::ofstream output(filepath, std::ios::binary);
+
+	if (!output.is_open()) {
+		return false;
+	}
+
+	uint32_t const header[2] = { COVERAGE_MAGIC, COVERAGE_VERSION };
+
+	output.write((char const*) header, sizeof(header));
+	output.write((char const*) _bits.data(), sizeof(_bits));
+
+	return output.good();
+}
+
+bool Coverage::Load(std::string const& filepath) {
+	std::ifstream input(filepath, std::ios::binary);
+
+	if (!input.is_open()) {
+		return false;
+	}
+
+	uint32_t header[2] = {};
+	input.read((char*) header, sizeof(header));
+
+	if (!input || header[0] != COVERAGE_MAGIC || header[1] != COVERAGE_VERSION) {
+		return false;
+	}
+
+	input.read((char*) _bits.data(), sizeof(_bits));
+
+	return (bool) input;
+}
+
+void Coverage::DisplayLcov(std::ostream& output, SymbolTable const& symbols, Byte const* memory, std::string const& testName, OpcodeTable const& opcodes) const {
+	struct LineCoverage {
+		bool hit = false;
+		std::vector<Word> branches;
+	};
+
+	// a line assembled more than once (macros, includes) is hit if one of its copies is
+	std::map<std::string, std::map<uint32_t, LineCoverage>> files;
+
+	for (SourceLine const& line : symbols.GetLines()) {
+		OpcodeInfo const& info = opcodes[memory[line.address]];
+
+		bool hit = false;
+		for (size_t address = line.address; address < (size_t) line.address + line.size && address < MAX_ADDRESSABLE; address++) {
+			hit = hit || IsMarked(COVERAGE_BIT::EXECUTED, (Word) address);
+		}
+
+		// lines of data never reached aren't instrumentable, a single instruction is
+		bool const instruction = info.flow != FLOW::INVALID && line.size == GetInstructionLength(info.mode);
+
+		if (!hit && !instruction) {
+			continue;
+		}
+
+		LineCoverage& coverage = files[line.file][line.line];
+		coverage.hit = coverage.hit || hit;
+
+		if (instruction && info.flow == FLOW::BRANCH) {
+			coverage.branches.push_back(line.address);
+		}
+	}
+
+	for (auto const& [file, lines] : files) {
+		output << "TN:" << testName << "\n";
+		output << "SF:" << file << "\n";
+
+		size_t linesHit = 0;
+		size_t branchesFound = 0;
+		size_t branchesHit = 0;
+
+		for (auto const& [number, coverage] : lines) {
+			output << "DA:" << number << "," << (coverage.hit ? 1 : 0) << "\n";
+			linesHit += coverage.hit;
+		}
+
+		for (auto const& [number, coverage] : lines) {
+			for (size_t block = 0; block < coverage.branches.size(); block++) {
+				Word const address = coverage.branches[block];
+				bool const executed = IsMarked(COVERAGE_BIT::EXECUTED, address);
+
+				// branch 0 is taken, 1 not taken, - when the instruction never ran
+				for (COVERAGE_BIT direction : { COVERAGE_BIT::TAKEN, COVERAGE_BIT::NOT_TAKEN }) {
+					bool const marked = IsMarked(direction, address);
+
+					output << "BRDA:" << number << "," << block << "," << (direction == COVERAGE_BIT::TAKEN ? 0 : 1) << ",";
+					output << (executed ? (marked ? "1" : "0") : "-") << "\n";
+
+					branchesFound++;
+					branchesHit += marked;
+				}
+			}
+		}
+
+		output << "BRF:" << branchesFound << "\n";
+		output << "BRH:" << branchesHit << "\n";
+		output << "LF:" << lines.size() << "\n";
+		output << "LH:" << linesHit << "\n";
+		output << "end_of_record\n";
+	}
+}
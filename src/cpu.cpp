@@ -1,68 +1,303 @@
 #include "cpu.hpp"
 
-CPU::CPU(std::vector<Byte>* ram, Word ramStart, Word ramSize, std::vector<Byte>* rom, Word romStart, Word romSize) {
-	_instructionsNames  = {
-	//  0      1      2      3      4      5      6      7     8      9      A      B      C      D      E      F
-		"BRK", "ORA", "",    "",    "",    "ORA", "ASL", "",   "PHP", "ORA", "ASL", "",    "",    "ORA", "ASL", "", // 0
-		"BPL", "ORA", "",    "",    "",    "ORA", "ASL", "",   "CLC", "ORA", "",    "",    "",    "ORA", "ASL", "", // 1
-		"JSR", "AND", "",    "",    "BIT", "AND", "ROL", "",   "PLP", "AND", "ROL", "",    "BIT", "AND", "ROL", "", // 2
-		"BMI", "AND", "",    "",    "",    "AND", "ROL", "",   "SEC", "AND", "",    "",    "",    "AND", "ROL", "", // 3
-		"RTI", "EOR", "",    "",    "",    "EOR", "LSR", "",   "PHA", "EOR", "LSR", "",    "JMP", "EOR", "LSR", "", // 4
-		"BVC", "EOR", "",    "",    "",    "EOR", "LSR", "",   "CLI", "EOR", "",    "",    "",    "EOR", "LSR", "", // 5
-		"RTS", "ADC", "",    "",    "",    "ADC", "ROR", "",   "PLA", "ADC", "ROR", "",    "JMP", "ADC", "ROR", "", // 6
-		"BVS", "ADC", "",    "",    "",    "ADC", "ROR", "",   "SEI", "ADC", "",    "",    "",    "ADC", "ROR", "", // 7
-		"",    "STA", "",    "",    "STY", "STA", "STX", "",   "DEY", "",    "TXA", "",    "STY", "STA", "STX", "", // 8
-		"BCC", "STA", "",    "",    "STY", "STA", "STX", "",   "TYA", "STA", "TXS", "",    "",    "STA", "",    "", // 9
-		"LDY", "LDA", "LDX", "",    "LDY", "LDA", "LDX", "",   "TAY", "LDA", "TAX", "",    "LDY", "LDA", "LDX", "", // A
-		"BCS", "LDA", "",    "",    "LDY", "LDA", "LDX", "",   "CLV", "LDA", "TSX", "",    "LDY", "LDA", "LDX", "", // B
-		"CPY", "CMP", "",    "",    "CPY", "CMP", "DEC", "",   "INY", "CMP", "DEX", "",    "CPY", "CMP", "DEC", "", // C
-		"BNE", "CMP", "",    "",    "",    "CMP", "DEC", "",   "CLD", "CMP", "",    "",    "",    "CMP", "DEC", "", // D
-		"CPX", "SBC", "",    "",    "CPX", "SBC", "INC", "",   "INX", "SBC", "NOP", "",    "CPX", "SBC", "INC", "", // E
-		"BEQ", "SBC", "",    "",    "",    "SBC", "INC", "",   "SED", "SBC", "",    "",    "",    "SBC", "INC", ""  // F
-	};
-	
-	_instructionsMatrix = {
-	//  0          1          2          3          4          5          6          7          8          9          A          B          C          D          E          F
-		&CPU::BRK, &CPU::ORA, nullptr,   nullptr,   nullptr,   &CPU::ORA, &CPU::ASL, nullptr,   &CPU::PHP, &CPU::ORA, &CPU::ASL, nullptr,   nullptr,   &CPU::ORA, &CPU::ASL, nullptr, // 0
-		&CPU::BPL, &CPU::ORA, nullptr,   nullptr,   nullptr,   &CPU::ORA, &CPU::ASL, nullptr,   &CPU::CLC, &CPU::ORA, nullptr,   nullptr,   nullptr,   &CPU::ORA, &CPU::ASL, nullptr, // 1
-		&CPU::JSR, &CPU::AND, nullptr,   nullptr,   &CPU::BIT, &CPU::AND, &CPU::ROL, nullptr,   &CPU::PLP, &CPU::AND, &CPU::ROL, nullptr,   &CPU::BIT, &CPU::AND, &CPU::ROL, nullptr, // 2
-		&CPU::BMI, &CPU::AND, nullptr,   nullptr,   nullptr,   &CPU::AND, &CPU::ROL, nullptr,   &CPU::SEC, &CPU::AND, nullptr,   nullptr,   nullptr,   &CPU::AND, &CPU::ROL, nullptr, // 3
-		&CPU::RTI, &CPU::EOR, nullptr,   nullptr,   nullptr,   &CPU::EOR, &CPU::LSR, nullptr,   &CPU::PHA, &CPU::EOR, &CPU::LSR, nullptr,   &CPU::JMP, &CPU::EOR, &CPU::LSR, nullptr, // 4
-		&CPU::BVC, &CPU::EOR, nullptr,   nullptr,   nullptr,   &CPU::EOR, &CPU::LSR, nullptr,   &CPU::CLI, &CPU::EOR, nullptr,   nullptr,   nullptr,   &CPU::EOR, &CPU::LSR, nullptr, // 5
-		&CPU::RTS, &CPU::ADC, nullptr,   nullptr,   nullptr,   &CPU::ADC, &CPU::ROR, nullptr,   &CPU::PLA, &CPU::ADC, &CPU::ROR, nullptr,   &CPU::JMP, &CPU::ADC, &CPU::ROR, nullptr, // 6
-		&CPU::BVS, &CPU::ADC, nullptr,   nullptr,   nullptr,   &CPU::ADC, &CPU::ROR, nullptr,   &CPU::SEI, &CPU::ADC, nullptr,   nullptr,   nullptr,   &CPU::ADC, &CPU::ROR, nullptr, // 7
-		nullptr,   &CPU::STA, nullptr,   nullptr,   &CPU::STY, &CPU::STA, &CPU::STX, nullptr,   &CPU::DEY, nullptr,   &CPU::TXA, nullptr,   &CPU::STY, &CPU::STA, &CPU::STX, nullptr, // 8
-		&CPU::BCC, &CPU::STA, nullptr,   nullptr,   &CPU::STY, &CPU::STA, &CPU::STX, nullptr,   &CPU::TYA, &CPU::STA, &CPU::TXS, nullptr,   nullptr,   &CPU::STA, nullptr,   nullptr, // 9
-		&CPU::LDY, &CPU::LDA, &CPU::LDX, nullptr,   &CPU::LDY, &CPU::LDA, &CPU::LDX, nullptr,   &CPU::TAY, &CPU::LDA, &CPU::TAX, nullptr,   &CPU::LDY, &CPU::LDA, &CPU::LDX, nullptr, // A
-		&CPU::BCS, &CPU::LDA, nullptr,   nullptr,   &CPU::LDY, &CPU::LDA, &CPU::LDX, nullptr,   &CPU::CLV, &CPU::LDA, &CPU::TSX, nullptr,   &CPU::LDY, &CPU::LDA, &CPU::LDX, nullptr, // B
-		&CPU::CPY, &CPU::CMP, nullptr,   nullptr,   &CPU::CPY, &CPU::CMP, &CPU::DEC, nullptr,   &CPU::INY, &CPU::CMP, &CPU::DEX, nullptr,   &CPU::CPY, &CPU::CMP, &CPU::DEC, nullptr, // C
-		&CPU::BNE, &CPU::CMP, nullptr,   nullptr,   nullptr,   &CPU::CMP, &CPU::DEC, nullptr,   &CPU::CLD, &CPU::CMP, nullptr,   nullptr,   nullptr,   &CPU::CMP, &CPU::DEC, nullptr, // D
-		&CPU::CPX, &CPU::SBC, nullptr,   nullptr,   &CPU::CPX, &CPU::SBC, &CPU::INC, nullptr,   &CPU::INX, &CPU::SBC, &CPU::NOP, nullptr,   &CPU::CPX, &CPU::SBC, &CPU::INC, nullptr, // E
-		&CPU::BEQ, &CPU::SBC, nullptr,   nullptr,   nullptr,   &CPU::SBC, &CPU::INC, nullptr,   &CPU::SED, &CPU::SBC, nullptr,   nullptr,   nullptr,   &CPU::SBC, &CPU::INC, nullptr  // F
-	};
-	
-	_ram = ramStart;
-	_rom = romStart;
-	
-	_ramSize = ramSize;
-	_romSize = romSize;
+#include "symbols.hpp"
+#include "heatmap.hpp"
+#include "coverage.hpp"
+
+template <typename Variant, typename Bus>
+std::vector<std::string> BasicCPU<Variant, Bus>::MakeInstructionsNames() {
+	if constexpr (Variant::CMOS) {
+		return {
+			//  0      1      2      3      4      5      6      7      8      9      A      B      C      D      E      F
+			"BRK", "ORA", "NOP", "NOP", "TSB", "ORA", "ASL", "NOP", "PHP", "ORA", "ASL", "NOP", "TSB", "ORA", "ASL", "NOP", // 0
+			"BPL", "ORA", "ORA", "NOP", "TRB", "ORA", "ASL", "NOP", "CLC", "ORA", "INC", "NOP", "TRB", "ORA", "ASL", "NOP", // 1
+			"JSR", "AND", "NOP", "NOP", "BIT", "AND", "ROL", "NOP", "PLP", "AND", "ROL", "NOP", "BIT", "AND", "ROL", "NOP", // 2
+			"BMI", "AND", "AND", "NOP", "BIT", "AND", "ROL", "NOP", "SEC", "AND", "DEC", "NOP", "BIT", "AND", "ROL", "NOP", // 3
+			"RTI", "EOR", "NOP", "NOP", "NOP", "EOR", "LSR", "NOP", "PHA", "EOR", "LSR", "NOP", "JMP", "EOR", "LSR", "NOP", // 4
+			"BVC", "EOR", "EOR", "NOP", "NOP", "EOR", "LSR", "NOP", "CLI", "EOR", "PHY", "NOP", "NOP", "EOR", "LSR", "NOP", // 5
+			"RTS", "ADC", "NOP", "NOP", "STZ", "ADC", "ROR", "NOP", "PLA", "ADC", "ROR", "NOP", "JMP", "ADC", "ROR", "NOP", // 6
+			"BVS", "ADC", "ADC", "NOP", "STZ", "ADC", "ROR", "NOP", "SEI", "ADC", "PLY", "NOP", "JMP", "ADC", "ROR", "NOP", // 7
+			"BRA", "STA", "NOP", "NOP", "STY", "STA", "STX", "NOP", "DEY", "BIT", "TXA", "NOP", "STY", "STA", "STX", "NOP", // 8
+			"BCC", "STA", "STA", "NOP", "STY", "STA", "STX", "NOP", "TYA", "STA", "TXS", "NOP", "STZ", "STA", "STZ", "NOP", // 9
+			"LDY", "LDA", "LDX", "NOP", "LDY", "LDA", "LDX", "NOP", "TAY", "LDA", "TAX", "NOP", "LDY", "LDA", "LDX", "NOP", // A
+			"BCS", "LDA", "LDA", "NOP", "LDY", "LDA", "LDX", "NOP", "CLV", "LDA", "TSX", "NOP", "LDY", "LDA", "LDX", "NOP", // B
+			"CPY", "CMP", "NOP", "NOP", "CPY", "CMP", "DEC", "NOP", "INY", "CMP", "DEX", "NOP", "CPY", "CMP", "DEC", "NOP", // C
+			"BNE", "CMP", "CMP", "NOP", "NOP", "CMP", "DEC", "NOP", "CLD", "CMP", "PHX", "NOP", "NOP", "CMP", "DEC", "NOP", // D
+			"CPX", "SBC", "NOP", "NOP", "CPX", "SBC", "INC", "NOP", "INX", "SBC", "NOP", "NOP", "CPX", "SBC", "INC", "NOP", // E
+			"BEQ", "SBC", "SBC", "NOP", "NOP", "SBC", "INC", "NOP", "SED", "SBC", "PLX", "NOP", "NOP", "SBC", "INC", "NOP"  // F
+		};
+	}
+
+	else if constexpr (Variant::UNDOCUMENTED_OPCODES) {
+		return {
+			//  0      1      2      3      4      5      6      7      8      9      A      B      C      D      E      F
+			"BRK", "ORA", "",    "SLO", "NOP", "ORA", "ASL", "SLO", "PHP", "ORA", "ASL", "ANC", "NOP", "ORA", "ASL", "SLO", // 0
+			"BPL", "ORA", "",    "SLO", "NOP", "ORA", "ASL", "SLO", "CLC", "ORA", "NOP", "SLO", "NOP", "ORA", "ASL", "SLO", // 1
+			"JSR", "AND", "",    "RLA", "BIT", "AND", "ROL", "RLA", "PLP", "AND", "ROL", "ANC", "BIT", "AND", "ROL", "RLA", // 2
+			"BMI", "AND", "",    "RLA", "NOP", "AND", "ROL", "RLA", "SEC", "AND", "NOP", "RLA", "NOP", "AND", "ROL", "RLA", // 3
+			"RTI", "EOR", "",    "SRE", "NOP", "EOR", "LSR", "SRE", "PHA", "EOR", "LSR", "ALR", "JMP", "EOR", "LSR", "SRE", // 4
+			"BVC", "EOR", "",    "SRE", "NOP", "EOR", "LSR", "SRE", "CLI", "EOR", "NOP", "SRE", "NOP", "EOR", "LSR", "SRE", // 5
+			"RTS", "ADC", "",    "RRA", "NOP", "ADC", "ROR", "RRA", "PLA", "ADC", "ROR", "ARR", "JMP", "ADC", "ROR", "RRA", // 6
+			"BVS", "ADC", "",    "RRA", "NOP", "ADC", "ROR", "RRA", "SEI", "ADC", "NOP", "RRA", "NOP", "ADC", "ROR", "RRA", // 7
+			"NOP", "STA", "NOP", "SAX", "STY", "STA", "STX", "SAX", "DEY", "NOP", "TXA", "",    "STY", "STA", "STX", "SAX", // 8
+			"BCC", "STA", "",    "",    "STY", "STA", "STX", "SAX", "TYA", "STA", "TXS", "",    "",    "STA", "",    "", // 9
+			"LDY", "LDA", "LDX", "LAX", "LDY", "LDA", "LDX", "LAX", "TAY", "LDA", "TAX", "",    "LDY", "LDA", "LDX", "LAX", // A
+			"BCS", "LDA", "",    "LAX", "LDY", "LDA", "LDX", "LAX", "CLV", "LDA", "TSX", "",    "LDY", "LDA", "LDX", "LAX", // B
+			"CPY", "CMP", "NOP", "DCP", "CPY", "CMP", "DEC", "DCP", "INY", "CMP", "DEX", "SBX", "CPY", "CMP", "DEC", "DCP", // C
+			"BNE", "CMP", "",    "DCP", "NOP", "CMP", "DEC", "DCP", "CLD", "CMP", "NOP", "DCP", "NOP", "CMP", "DEC", "DCP", // D
+			"CPX", "SBC", "NOP", "ISC", "CPX", "SBC", "INC", "ISC", "INX", "SBC", "NOP", "SBC", "CPX", "SBC", "INC", "ISC", // E
+			"BEQ", "SBC", "",    "ISC", "NOP", "SBC", "INC", "ISC", "SED", "SBC", "NOP", "ISC", "NOP", "SBC", "INC", "ISC"  // F
+		};
+	}
+
+	else {
+		return {
+			//  0      1      2      3      4      5      6      7      8      9      A      B      C      D      E      F
+			"BRK", "ORA", "",    "",    "",    "ORA", "ASL", "",    "PHP", "ORA", "ASL", "",    "",    "ORA", "ASL", "", // 0
+			"BPL", "ORA", "",    "",    "",    "ORA", "ASL", "",    "CLC", "ORA", "",    "",    "",    "ORA", "ASL", "", // 1
+			"JSR", "AND", "",    "",    "BIT", "AND", "ROL", "",    "PLP", "AND", "ROL", "",    "BIT", "AND", "ROL", "", // 2
+			"BMI", "AND", "",    "",    "",    "AND", "ROL", "",    "SEC", "AND", "",    "",    "",    "AND", "ROL", "", // 3
+			"RTI", "EOR", "",    "",    "",    "EOR", "LSR", "",    "PHA", "EOR", "LSR", "",    "JMP", "EOR", "LSR", "", // 4
+			"BVC", "EOR", "",    "",    "",    "EOR", "LSR", "",    "CLI", "EOR", "",    "",    "",    "EOR", "LSR", "", // 5
+			"RTS", "ADC", "",    "",    "",    "ADC", "ROR", "",    "PLA", "ADC", "ROR", "",    "JMP", "ADC", "ROR", "", // 6
+			"BVS", "ADC", "",    "",    "",    "ADC", "ROR", "",    "SEI", "ADC", "",    "",    "",    "ADC", "ROR", "", // 7
+			"",    "STA", "",    "",    "STY", "STA", "STX", "",    "DEY", "",    "TXA", "",    "STY", "STA", "STX", "", // 8
+			"BCC", "STA", "",    "",    "STY", "STA", "STX", "",    "TYA", "STA", "TXS", "",    "",    "STA", "",    "", // 9
+			"LDY", "LDA", "LDX", "",    "LDY", "LDA", "LDX", "",    "TAY", "LDA", "TAX", "",    "LDY", "LDA", "LDX", "", // A
+			"BCS", "LDA", "",    "",    "LDY", "LDA", "LDX", "",    "CLV", "LDA", "TSX", "",    "LDY", "LDA", "LDX", "", // B
+			"CPY", "CMP", "",    "",    "CPY", "CMP", "DEC", "",    "INY", "CMP", "DEX", "",    "CPY", "CMP", "DEC", "", // C
+			"BNE", "CMP", "",    "",    "",    "CMP", "DEC", "",    "CLD", "CMP", "",    "",    "",    "CMP", "DEC", "", // D
+			"CPX", "SBC", "",    "",    "CPX", "SBC", "INC", "",    "INX", "SBC", "NOP", "",    "CPX", "SBC", "INC", "", // E
+			"BEQ", "SBC", "",    "",    "",    "SBC", "INC", "",    "SED", "SBC", "",    "",    "",    "SBC", "INC", ""  // F
+		};
+	}
+}
+
+template <typename Variant, typename Bus>
+std::vector<typename BasicCPU<Variant, Bus>::Instruction> BasicCPU<Variant, Bus>::MakeInstructionsMatrix() {
+	if constexpr (Variant::CMOS) {
+		return {
+			//  0          1          2          3          4          5          6          7          8          9          A          B          C          D          E          F
+			&BasicCPU::BRK, &BasicCPU::ORA, &BasicCPU::DOP, &BasicCPU::NOP, &BasicCPU::TSB, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::NOP, &BasicCPU::PHP, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::NOP, &BasicCPU::TSB, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::NOP, // 0
+			&BasicCPU::BPL, &BasicCPU::ORA, &BasicCPU::ORA, &BasicCPU::NOP, &BasicCPU::TRB, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::NOP, &BasicCPU::CLC, &BasicCPU::ORA, &BasicCPU::INA, &BasicCPU::NOP, &BasicCPU::TRB, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::NOP, // 1
+			&BasicCPU::JSR, &BasicCPU::AND, &BasicCPU::DOP, &BasicCPU::NOP, &BasicCPU::BIT, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::NOP, &BasicCPU::PLP, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::NOP, &BasicCPU::BIT, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::NOP, // 2
+			&BasicCPU::BMI, &BasicCPU::AND, &BasicCPU::AND, &BasicCPU::NOP, &BasicCPU::BIT, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::NOP, &BasicCPU::SEC, &BasicCPU::AND, &BasicCPU::DEA, &BasicCPU::NOP, &BasicCPU::BIT, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::NOP, // 3
+			&BasicCPU::RTI, &BasicCPU::EOR, &BasicCPU::DOP, &BasicCPU::NOP, &BasicCPU::DOP, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::NOP, &BasicCPU::PHA, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::NOP, &BasicCPU::JMP, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::NOP, // 4
+			&BasicCPU::BVC, &BasicCPU::EOR, &BasicCPU::EOR, &BasicCPU::NOP, &BasicCPU::DOP, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::NOP, &BasicCPU::CLI, &BasicCPU::EOR, &BasicCPU::PHY, &BasicCPU::NOP, &BasicCPU::TOP, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::NOP, // 5
+			&BasicCPU::RTS, &BasicCPU::ADC, &BasicCPU::DOP, &BasicCPU::NOP, &BasicCPU::STZ, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::NOP, &BasicCPU::PLA, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::NOP, &BasicCPU::JMP, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::NOP, // 6
+			&BasicCPU::BVS, &BasicCPU::ADC, &BasicCPU::ADC, &BasicCPU::NOP, &BasicCPU::STZ, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::NOP, &BasicCPU::SEI, &BasicCPU::ADC, &BasicCPU::PLY, &BasicCPU::NOP, &BasicCPU::JMP, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::NOP, // 7
+			&BasicCPU::BRA, &BasicCPU::STA, &BasicCPU::DOP, &BasicCPU::NOP, &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, &BasicCPU::NOP, &BasicCPU::DEY, &BasicCPU::BITImmediate, &BasicCPU::TXA, &BasicCPU::NOP, &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, &BasicCPU::NOP, // 8
+			&BasicCPU::BCC, &BasicCPU::STA, &BasicCPU::STA, &BasicCPU::NOP, &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, &BasicCPU::NOP, &BasicCPU::TYA, &BasicCPU::STA, &BasicCPU::TXS, &BasicCPU::NOP, &BasicCPU::STZ, &BasicCPU::STA, &BasicCPU::STZ, &BasicCPU::NOP, // 9
+			&BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::NOP, &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::NOP, &BasicCPU::TAY, &BasicCPU::LDA, &BasicCPU::TAX, &BasicCPU::NOP, &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::NOP, // A
+			&BasicCPU::BCS, &BasicCPU::LDA, &BasicCPU::LDA, &BasicCPU::NOP, &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::NOP, &BasicCPU::CLV, &BasicCPU::LDA, &BasicCPU::TSX, &BasicCPU::NOP, &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::NOP, // B
+			&BasicCPU::CPY, &BasicCPU::CMP, &BasicCPU::DOP, &BasicCPU::NOP, &BasicCPU::CPY, &BasicCPU::CMP, &BasicCPU::DEC, &BasicCPU::NOP, &BasicCPU::INY, &BasicCPU::CMP, &BasicCPU::DEX, &BasicCPU::NOP, &BasicCPU::CPY, &BasicCPU::CMP, &BasicCPU::DEC, &BasicCPU::NOP, // C
+			&BasicCPU::BNE, &BasicCPU::CMP, &BasicCPU::CMP, &BasicCPU::NOP, &BasicCPU::DOP, &BasicCPU::CMP, &BasicCPU::DEC, &BasicCPU::NOP, &BasicCPU::CLD, &BasicCPU::CMP, &BasicCPU::PHX, &BasicCPU::NOP, &BasicCPU::TOP, &BasicCPU::CMP, &BasicCPU::DEC, &BasicCPU::NOP, // D
+			&BasicCPU::CPX, &BasicCPU::SBC, &BasicCPU::DOP, &BasicCPU::NOP, &BasicCPU::CPX, &BasicCPU::SBC, &BasicCPU::INC, &BasicCPU::NOP, &BasicCPU::INX, &BasicCPU::SBC, &BasicCPU::NOP, &BasicCPU::NOP, &BasicCPU::CPX, &BasicCPU::SBC, &BasicCPU::INC, &BasicCPU::NOP, // E
+			&BasicCPU::BEQ, &BasicCPU::SBC, &BasicCPU::SBC, &BasicCPU::NOP, &BasicCPU::DOP, &BasicCPU::SBC, &BasicCPU::INC, &BasicCPU::NOP, &BasicCPU::SED, &BasicCPU::SBC, &BasicCPU::PLX, &BasicCPU::NOP, &BasicCPU::TOP, &BasicCPU::SBC, &BasicCPU::INC, &BasicCPU::NOP  // F
+		};
+	}
+
+	else if constexpr (Variant::UNDOCUMENTED_OPCODES) {
+		return {
+			//  0          1          2          3          4          5          6          7          8          9          A          B          C          D          E          F
+			&BasicCPU::BRK, &BasicCPU::ORA, nullptr,   &BasicCPU::SLO, &BasicCPU::DOP, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::SLO, &BasicCPU::PHP, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::ANC, &BasicCPU::TOP, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::SLO, // 0
+			&BasicCPU::BPL, &BasicCPU::ORA, nullptr,   &BasicCPU::SLO, &BasicCPU::DOP, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::SLO, &BasicCPU::CLC, &BasicCPU::ORA, &BasicCPU::NOP, &BasicCPU::SLO, &BasicCPU::TOP, &BasicCPU::ORA, &BasicCPU::ASL, &BasicCPU::SLO, // 1
+			&BasicCPU::JSR, &BasicCPU::AND, nullptr,   &BasicCPU::RLA, &BasicCPU::BIT, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::RLA, &BasicCPU::PLP, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::ANC, &BasicCPU::BIT, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::RLA, // 2
+			&BasicCPU::BMI, &BasicCPU::AND, nullptr,   &BasicCPU::RLA, &BasicCPU::DOP, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::RLA, &BasicCPU::SEC, &BasicCPU::AND, &BasicCPU::NOP, &BasicCPU::RLA, &BasicCPU::TOP, &BasicCPU::AND, &BasicCPU::ROL, &BasicCPU::RLA, // 3
+			&BasicCPU::RTI, &BasicCPU::EOR, nullptr,   &BasicCPU::SRE, &BasicCPU::DOP, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::SRE, &BasicCPU::PHA, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::ALR, &BasicCPU::JMP, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::SRE, // 4
+			&BasicCPU::BVC, &BasicCPU::EOR, nullptr,   &BasicCPU::SRE, &BasicCPU::DOP, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::SRE, &BasicCPU::CLI, &BasicCPU::EOR, &BasicCPU::NOP, &BasicCPU::SRE, &BasicCPU::TOP, &BasicCPU::EOR, &BasicCPU::LSR, &BasicCPU::SRE, // 5
+			&BasicCPU::RTS, &BasicCPU::ADC, nullptr,   &BasicCPU::RRA, &BasicCPU::DOP, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::RRA, &BasicCPU::PLA, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::ARR, &BasicCPU::JMP, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::RRA, // 6
+			&BasicCPU::BVS, &BasicCPU::ADC, nullptr,   &BasicCPU::RRA, &BasicCPU::DOP, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::RRA, &BasicCPU::SEI, &BasicCPU::ADC, &BasicCPU::NOP, &BasicCPU::RRA, &BasicCPU::TOP, &BasicCPU::ADC, &BasicCPU::ROR, &BasicCPU::RRA, // 7
+			&BasicCPU::DOP, &BasicCPU::STA, &BasicCPU::DOP, &BasicCPU::SAX, &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, &BasicCPU::SAX, &BasicCPU::DEY, &BasicCPU::DOP, &BasicCPU::TXA, nullptr,   &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, &BasicCPU::SAX, // 8
+			&BasicCPU::BCC, &BasicCPU::STA, nullptr,   nullptr,   &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, &BasicCPU::SAX, &BasicCPU::TYA, &BasicCPU::STA, &BasicCPU::TXS, nullptr,   nullptr,   &BasicCPU::STA, nullptr,   nullptr,   // 9
+			&BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::LAX, &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::LAX, &BasicCPU::TAY, &BasicCPU::LDA, &BasicCPU::TAX, nullptr,   &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::LAX, // A
+			&BasicCPU::BCS, &BasicCPU::LDA, nullptr,   &BasicCPU::LAX, &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::LAX, &BasicCPU::CLV, &BasicCPU::LDA, &BasicCPU::TSX, nullptr,   &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, &BasicCPU::LAX, // B
+			&BasicCPU::CPY, &BasicCPU::CMP, &BasicCPU::DOP, &BasicCPU::DCP, &BasicCPU::CPY, &BasicCPU::CMP, &BasicCPU::DEC, &BasicCPU::DCP, &BasicCPU::INY, &BasicCPU::CMP, &BasicCPU::DEX, &BasicCPU::SBX, &BasicCPU::CPY, &BasicCPU::CMP, &BasicCPU::DEC, &BasicCPU::DCP, // C
+			&BasicCPU::BNE, &BasicCPU::CMP, nullptr,   &BasicCPU::DCP, &BasicCPU::DOP, &BasicCPU::CMP, &BasicCPU::DEC, &BasicCPU::DCP, &BasicCPU::CLD, &BasicCPU::CMP, &BasicCPU::NOP, &BasicCPU::DCP, &BasicCPU::TOP, &BasicCPU::CMP, &BasicCPU::DEC, &BasicCPU::DCP, // D
+			&BasicCPU::CPX, &BasicCPU::SBC, &BasicCPU::DOP, &BasicCPU::ISC, &BasicCPU::CPX, &BasicCPU::SBC, &BasicCPU::INC, &BasicCPU::ISC, &BasicCPU::INX, &BasicCPU::SBC, &BasicCPU::NOP, &BasicCPU::SBC, &BasicCPU::CPX, &BasicCPU::SBC, &BasicCPU::INC, &BasicCPU::ISC, // E
+			&BasicCPU::BEQ, &BasicCPU::SBC, nullptr,   &BasicCPU::ISC, &BasicCPU::DOP, &BasicCPU::SBC, &BasicCPU::INC, &BasicCPU::ISC, &BasicCPU::SED, &BasicCPU::SBC, &BasicCPU::NOP, &BasicCPU::ISC, &BasicCPU::TOP, &BasicCPU::SBC, &BasicCPU::INC, &BasicCPU::ISC  // F
+		};
+	}
+
+	else {
+		return {
+			//  0          1          2          3          4          5          6          7          8          9          A          B          C          D          E          F
+			&BasicCPU::BRK, &BasicCPU::ORA, nullptr,   nullptr,   nullptr,   &BasicCPU::ORA, &BasicCPU::ASL, nullptr,   &BasicCPU::PHP, &BasicCPU::ORA, &BasicCPU::ASL, nullptr,   nullptr,   &BasicCPU::ORA, &BasicCPU::ASL, nullptr,   // 0
+			&BasicCPU::BPL, &BasicCPU::ORA, nullptr,   nullptr,   nullptr,   &BasicCPU::ORA, &BasicCPU::ASL, nullptr,   &BasicCPU::CLC, &BasicCPU::ORA, nullptr,   nullptr,   nullptr,   &BasicCPU::ORA, &BasicCPU::ASL, nullptr,   // 1
+			&BasicCPU::JSR, &BasicCPU::AND, nullptr,   nullptr,   &BasicCPU::BIT, &BasicCPU::AND, &BasicCPU::ROL, nullptr,   &BasicCPU::PLP, &BasicCPU::AND, &BasicCPU::ROL, nullptr,   &BasicCPU::BIT, &BasicCPU::AND, &BasicCPU::ROL, nullptr,   // 2
+			&BasicCPU::BMI, &BasicCPU::AND, nullptr,   nullptr,   nullptr,   &BasicCPU::AND, &BasicCPU::ROL, nullptr,   &BasicCPU::SEC, &BasicCPU::AND, nullptr,   nullptr,   nullptr,   &BasicCPU::AND, &BasicCPU::ROL, nullptr,   // 3
+			&BasicCPU::RTI, &BasicCPU::EOR, nullptr,   nullptr,   nullptr,   &BasicCPU::EOR, &BasicCPU::LSR, nullptr,   &BasicCPU::PHA, &BasicCPU::EOR, &BasicCPU::LSR, nullptr,   &BasicCPU::JMP, &BasicCPU::EOR, &BasicCPU::LSR, nullptr,   // 4
+			&BasicCPU::BVC, &BasicCPU::EOR, nullptr,   nullptr,   nullptr,   &BasicCPU::EOR, &BasicCPU::LSR, nullptr,   &BasicCPU::CLI, &BasicCPU::EOR, nullptr,   nullptr,   nullptr,   &BasicCPU::EOR, &BasicCPU::LSR, nullptr,   // 5
+			&BasicCPU::RTS, &BasicCPU::ADC, nullptr,   nullptr,   nullptr,   &BasicCPU::ADC, &BasicCPU::ROR, nullptr,   &BasicCPU::PLA, &BasicCPU::ADC, &BasicCPU::ROR, nullptr,   &BasicCPU::JMP, &BasicCPU::ADC, &BasicCPU::ROR, nullptr,   // 6
+			&BasicCPU::BVS, &BasicCPU::ADC, nullptr,   nullptr,   nullptr,   &BasicCPU::ADC, &BasicCPU::ROR, nullptr,   &BasicCPU::SEI, &BasicCPU::ADC, nullptr,   nullptr,   nullptr,   &BasicCPU::ADC, &BasicCPU::ROR, nullptr,   // 7
+			nullptr,   &BasicCPU::STA, nullptr,   nullptr,   &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, nullptr,   &BasicCPU::DEY, nullptr,   &BasicCPU::TXA, nullptr,   &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, nullptr,   // 8
+			&BasicCPU::BCC, &BasicCPU::STA, nullptr,   nullptr,   &BasicCPU::STY, &BasicCPU::STA, &BasicCPU::STX, nullptr,   &BasicCPU::TYA, &BasicCPU::STA, &BasicCPU::TXS, nullptr,   nullptr,   &BasicCPU::STA, nullptr,   nullptr,   // 9
+			&BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, nullptr,   &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, nullptr,   &BasicCPU::TAY, &BasicCPU::LDA, &BasicCPU::TAX, nullptr,   &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, nullptr,   // A
+			&BasicCPU::BCS, &BasicCPU::LDA, nullptr,   nullptr,   &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, nullptr,   &BasicCPU::CLV, &BasicCPU::LDA, &BasicCPU::TSX, nullptr,   &BasicCPU::LDY, &BasicCPU::LDA, &BasicCPU::LDX, nullptr,   // B
+			&BasicCPU::CPY, &BasicCPU::CMP, nullptr,   nullptr,   &BasicCPU::CPY, &BasicCPU::CMP, &BasicCPU::DEC, nullptr,   &BasicCPU::INY, &BasicCPU::CMP, &BasicCPU::DEX, nullptr,   &BasicCPU::CPY, &BasicCPU::CMP, &BasicCPU::DEC, nullptr,   // C
+			&BasicCPU::BNE, &BasicCPU::CMP, nullptr,   nullptr,   nullptr,   &BasicCPU::CMP, &BasicCPU::DEC, nullptr,   &BasicCPU::CLD, &BasicCPU::CMP, nullptr,   nullptr,   nullptr,   &BasicCPU::CMP, &BasicCPU::DEC, nullptr,   // D
+			&BasicCPU::CPX, &BasicCPU::SBC, nullptr,   nullptr,   &BasicCPU::CPX, &BasicCPU::SBC, &BasicCPU::INC, nullptr,   &BasicCPU::INX, &BasicCPU::SBC, &BasicCPU::NOP, nullptr,   &BasicCPU::CPX, &BasicCPU::SBC, &BasicCPU::INC, nullptr,   // E
+			&BasicCPU::BEQ, &BasicCPU::SBC, nullptr,   nullptr,   nullptr,   &BasicCPU::SBC, &BasicCPU::INC, nullptr,   &BasicCPU::SED, &BasicCPU::SBC, nullptr,   nullptr,   nullptr,   &BasicCPU::SBC, &BasicCPU::INC, nullptr  // F
+		};
+	}
+}
+
+template <typename Variant, typename Bus>
+std::vector<Byte> BasicCPU<Variant, Bus>::MakeInstructionsCycles() {
+	if constexpr (Variant::CMOS) {
+		return {
+			//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+			7, 6, 2, 1, 5, 3, 5, 1, 3, 2, 2, 1, 6, 4, 6, 1, // 0
+			2, 5, 5, 1, 5, 4, 6, 1, 2, 4, 2, 1, 6, 4, 6, 1, // 1
+			6, 6, 2, 1, 3, 3, 5, 1, 4, 2, 2, 1, 4, 4, 6, 1, // 2
+			2, 5, 5, 1, 4, 4, 6, 1, 2, 4, 2, 1, 4, 4, 6, 1, // 3
+			6, 6, 2, 1, 3, 3, 5, 1, 3, 2, 2, 1, 3, 4, 6, 1, // 4
+			2, 5, 5, 1, 4, 4, 6, 1, 2, 4, 3, 1, 8, 4, 6, 1, // 5
+			6, 6, 2, 1, 3, 3, 5, 1, 4, 2, 2, 1, 6, 4, 6, 1, // 6
+			2, 5, 5, 1, 4, 4, 6, 1, 2, 4, 4, 1, 6, 4, 6, 1, // 7
+			2, 6, 2, 1, 3, 3, 3, 1, 2, 2, 2, 1, 4, 4, 4, 1, // 8
+			2, 6, 5, 1, 4, 4, 4, 1, 2, 5, 2, 1, 4, 5, 5, 1, // 9
+			2, 6, 2, 1, 3, 3, 3, 1, 2, 2, 2, 1, 4, 4, 4, 1, // A
+			2, 5, 5, 1, 4, 4, 4, 1, 2, 4, 2, 1, 4, 4, 4, 1, // B
+			2, 6, 2, 1, 3, 3, 5, 1, 2, 2, 2, 1, 4, 4, 6, 1, // C
+			2, 5, 5, 1, 4, 4, 6, 1, 2, 4, 3, 1, 4, 4, 7, 1, // D
+			2, 6, 2, 1, 3, 3, 5, 1, 2, 2, 2, 1, 4, 4, 6, 1, // E
+			2, 5, 5, 1, 4, 4, 6, 1, 2, 4, 4, 1, 4, 4, 7, 1  // F
+		};
+	}
 
-	_map = std::vector<Byte>(MAX_ADDRESSABLE, 0x00);
+	else if constexpr (Variant::UNDOCUMENTED_OPCODES) {
+		return {
+			//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+			7, 6, 0, 8, 3, 3, 5, 5, 3, 2, 2, 2, 4, 4, 6, 6, // 0
+			2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // 1
+			6, 6, 0, 8, 3, 3, 5, 5, 4, 2, 2, 2, 4, 4, 6, 6, // 2
+			2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // 3
+			6, 6, 0, 8, 3, 3, 5, 5, 3, 2, 2, 2, 3, 4, 6, 6, // 4
+			2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // 5
+			6, 6, 0, 8, 3, 3, 5, 5, 4, 2, 2, 2, 5, 4, 6, 6, // 6
+			2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // 7
+			2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 0, 4, 4, 4, 4, // 8
+			2, 6, 0, 0, 4, 4, 4, 4, 2, 5, 2, 0, 0, 5, 0, 0, // 9
+			2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 0, 4, 4, 4, 4, // A
+			2, 5, 0, 5, 4, 4, 4, 4, 2, 4, 2, 0, 4, 4, 4, 4, // B
+			2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6, // C
+			2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // D
+			2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6, // E
+			2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7  // F
+		};
+	}
 
-	for (int i = 0; i < ramSize; i++) {
-		_map[(Word)(ramStart + i)] = (*ram)[i];
+	else {
+		return {
+			//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+			7, 6, 0, 0, 0, 3, 5, 0, 3, 2, 2, 0, 0, 4, 6, 0, // 0
+			2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // 1
+			6, 6, 0, 0, 3, 3, 5, 0, 4, 2, 2, 0, 4, 4, 6, 0, // 2
+			2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // 3
+			6, 6, 0, 0, 0, 3, 5, 0, 3, 2, 2, 0, 3, 4, 6, 0, // 4
+			2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // 5
+			6, 6, 0, 0, 0, 3, 5, 0, 4, 2, 2, 0, 5, 4, 6, 0, // 6
+			2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // 7
+			0, 6, 0, 0, 3, 3, 3, 0, 2, 0, 2, 0, 4, 4, 4, 0, // 8
+			2, 6, 0, 0, 4, 4, 4, 0, 2, 5, 2, 0, 0, 5, 0, 0, // 9
+			2, 6, 2, 0, 3, 3, 3, 0, 2, 2, 2, 0, 4, 4, 4, 0, // A
+			2, 5, 0, 0, 4, 4, 4, 0, 2, 4, 2, 0, 4, 4, 4, 0, // B
+			2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0, // C
+			2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // D
+			2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0, // E
+			2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0  // F
+		};
 	}
+}
+
+template <typename Variant, typename Bus>
+std::vector<std::string> const BasicCPU<Variant, Bus>::_instructionsNames = MakeInstructionsNames();
 
-	for (int i = 0; i < romSize; i++) {
-		_map[(Word)(romStart + i)] = (*rom)[i];
+template <typename Variant, typename Bus>
+std::vector<typename BasicCPU<Variant, Bus>::Instruction> const BasicCPU<Variant, Bus>::_instructionsMatrix = MakeInstructionsMatrix();
+
+template <typename Variant, typename Bus>
+std::vector<Byte> const BasicCPU<Variant, Bus>::_instructionsCycles = MakeInstructionsCycles();
+
+template <typename Variant, typename Bus>
+OpcodeTable const& BasicCPU<Variant, Bus>::GetOpcodes() {
+	return ::GetOpcodes<Variant>();
+}
+
+template <typename Variant, typename Bus>
+std::vector<Byte> BasicCPU<Variant, Bus>::MakePageCrossCycles() {
+	// only the instructions reading their operand, the others always spend the cycle fixing the high byte
+	// the 65C02 shifts and rotates pay it like reads
+	std::vector<std::string> const names = MakeInstructionsNames();
+	std::vector<Byte> cycles(names.size(), 0);
+
+	for (size_t opcode = 0; opcode < names.size(); opcode++) {
+		std::string const& name = names[opcode];
+
+		bool const read = name == "LDA" || name == "LDX" || name == "LDY" || name == "LAX" || name == "ADC" || name == "SBC"
+			|| name == "AND" || name == "ORA" || name == "EOR" || name == "CMP" || name == "BIT";
+		bool const shift = name == "ASL" || name == "LSR" || name == "ROL" || name == "ROR";
+
+		cycles[opcode] = (read || (Variant::CMOS && shift)) ? 1 : 0;
 	}
 
+	return cycles;
+}
+
+template <typename Variant, typename Bus>
+std::vector<Byte> const BasicCPU<Variant, Bus>::_pageCrossCycles = MakePageCrossCycles();
+
+template <typename Variant, typename Bus>
+BasicCPU<Variant, Bus>::BasicCPU(std::vector<Byte>* ram, Word ramStart, Word ramSize, std::vector<Byte>* rom, Word romStart, Word romSize)
+	: BasicCPU(std::make_shared<MemoryImage const>(ram, ramStart, ramSize, rom, romStart, romSize)) {
+}
+
+template <typename Variant, typename Bus>
+BasicCPU<Variant, Bus>::BasicCPU(std::shared_ptr<MemoryImage const> image) : _map(image) {
+	_ram = image->GetRAMStart();
+	_rom = image->GetROMStart();
+
+	_ramSize = image->GetRAMSize();
+	_romSize = image->GetROMSize();
+
+	_devices = std::vector<Device*>(MAX_PAGES, nullptr);
+
 	_statusFlags = (Byte) STATUS_FLAG::_;
 
 	SetProgramCounterFromResetVector();
 }
 
-void CPU::DisplayStatus() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::Reset() {
+	RestorePages();
+	ResetRegisters();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::Reload(std::vector<Byte> const* ram, std::vector<Byte> const* rom) {
+	// a new image : the next Resets restore the contents reloaded, not the ones of the first load
+	auto const image = std::make_shared<MemoryImage const>(ram, _ram, _ramSize, rom, _rom, _romSize);
+
+	_dirtyPages.reset();
+
+	// pages whose contents change are reported as written (eg. code loaded over an analyzed loop)
+	for (int page = 0; page < MAX_PAGES; page++) {
+		Byte const* const current = _map.GetPage((Byte) page);
+
+		if (!std::equal(current, current + MAX_PAGE_SIZE, image->GetPage((Byte) page))) {
+			_dirtyPages.set(page);
+		}
+	}
+
+	_map.SetImage(image);
+	_writtenPages.reset();
+
+	ResetRegisters();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayStatus() const {
 	std::cout << "N V - B D I Z C" << "\n";
 
 	for (int i = sizeof(Byte) * 8 - 1; i >= 0; i--) {
@@ -72,7 +307,8 @@ void CPU::DisplayStatus() const {
 	std::cout << std::endl;
 }
 
-void CPU::DisplayStatusFlag(STATUS_FLAG flag) {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayStatusFlag(STATUS_FLAG flag) {
 	switch (flag) {
 		case STATUS_FLAG::N:
 			std::cout << "N : " << (IsSet(STATUS_FLAG::N) ? "true" : "false") << std::endl;
@@ -110,7 +346,8 @@ void CPU::DisplayStatusFlag(STATUS_FLAG flag) {
 	}
 }
 
-void CPU::DisplayAccumulator() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayAccumulator() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 	std::cout << std::hex << std::uppercase;
 
@@ -119,7 +356,8 @@ void CPU::DisplayAccumulator() const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayIndexX() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayIndexX() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 	std::cout << std::hex << std::uppercase;
 
@@ -128,7 +366,8 @@ void CPU::DisplayIndexX() const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayIndexY() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayIndexY() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 	std::cout << std::hex << std::uppercase;
 
@@ -137,13 +376,15 @@ void CPU::DisplayIndexY() const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayRegisters() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayRegisters() const {
 	DisplayAccumulator();
 	DisplayIndexX();
 	DisplayIndexY();
 }
 
-void CPU::DisplayStackPointer() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayStackPointer() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 	std::cout << std::hex << std::uppercase;
 
@@ -152,7 +393,8 @@ void CPU::DisplayStackPointer() const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayAddressBus() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayAddressBus() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 	std::cout << std::hex << std::uppercase;
 
@@ -161,7 +403,8 @@ void CPU::DisplayAddressBus() const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayDataBus() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayDataBus() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 	std::cout << std::hex << std::uppercase;
 
@@ -170,12 +413,14 @@ void CPU::DisplayDataBus() const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayBuses() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayBuses() const {
 	DisplayDataBus();
 	DisplayAddressBus();
 }
 
-void CPU::DisplayProgramCounter() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayProgramCounter() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 	std::cout << std::hex << std::uppercase;
 
@@ -184,7 +429,8 @@ void CPU::DisplayProgramCounter() const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayState() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayState() const {
 	DisplayStatus();
 	DisplayRegisters();
 	DisplayStackPointer();
@@ -192,7 +438,8 @@ void CPU::DisplayState() const {
 	DisplayProgramCounter();
 }
 
-void CPU::DisplayRAM() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayRAM() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 
 	std::cout << "\t";
@@ -217,11 +464,13 @@ void CPU::DisplayRAM() const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayZeroPage() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayZeroPage() const {
 	DisplayRAMPage(0x00);
 }
 
-void CPU::DisplayRAMPage(Byte page) const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayRAMPage(Byte page) const {
 	std::ios_base::fmtflags f(std::cout.flags());
 
 	Word const pageAddress = (Word)(page << 8);
@@ -247,11 +496,13 @@ void CPU::DisplayRAMPage(Byte page) const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayStack() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayStack() const {
 	DisplayRAMPage(0x01);
 }
 
-void CPU::DisplayROM(bool stopOnBreak) const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayROM(bool stopOnBreak) const {
 	std::ios_base::fmtflags f(std::cout.flags());
 
 	std::cout << "\t";
@@ -276,37 +527,39 @@ void CPU::DisplayROM(bool stopOnBreak) const {
 	std::cout.flags(f);
 }
 
-void CPU::DisplayInstructionAsBytes(size_t bytesN) const {
-	std::ios_base::fmtflags f(std::cout.flags());
-	std::cout << std::hex << std::uppercase;
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayInstructionAsBytes(size_t bytesN) const {
+	std::ios_base::fmtflags f(_trace->flags());
+	*_trace << std::hex << std::uppercase;
 
 	for (int i = 0; i < (bytesN - 1); i++) {
-		std::cout << std::setfill('0') << std::setw(2) << (int) _map[(Word)(GetBigEndianAddress(_programCounter) + i)] << " ";
+		*_trace << std::setfill('0') << std::setw(2) << (int) _map[(Word)(GetBigEndianAddress(_programCounter) + i)] << " ";
 	}
 
-	std::cout << std::setfill('0') << std::setw(2) << (int) _map[(Word)(GetBigEndianAddress(_programCounter) + (bytesN - 1))];
+	*_trace << std::setfill('0') << std::setw(2) << (int) _map[(Word)(GetBigEndianAddress(_programCounter) + (bytesN - 1))];
 
 	switch (bytesN) {
 		case (size_t) BYTES_USED::ONE_BYTE:
-			std::cout << "          ";
+			*_trace << "          ";
 			break;
 
 		case (size_t) BYTES_USED::TWO_BYTES:
-			std::cout << "       ";
+			*_trace << "       ";
 			break;
 
 		case (size_t) BYTES_USED::THREE_BYTES:
-			std::cout << "    ";
+			*_trace << "    ";
 			break;
 
 		default:
 			break;
 	}
 
-	std::cout.flags(f);
+	_trace->flags(f);
 }
 
-void CPU::DisplayMap() const {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DisplayMap() const {
 	std::ios_base::fmtflags f(std::cout.flags());
 
 	std::cout << "\t";
@@ -331,361 +584,833 @@ void CPU::DisplayMap() const {
 	std::cout.flags(f);
 }
 
-void CPU::Run(bool stepByStep) {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::Run(bool stepByStep) {
 	while (_map[GetBigEndianAddress(_programCounter)] != 0x00) {
-		FetchAndExecute();
+		Step();
 		if (stepByStep) {
 			char _ = getchar(); // wait for enter press
 		}
 		else {
-			std::cout << std::endl;
+			*_trace << std::endl;
 		}
 	}
 }
 
-void CPU::FetchAndExecute()  {
-	std::ios_base::fmtflags f(std::cout.flags());
-	std::cout << std::hex << std::uppercase;
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::Step() {
+	FetchAndExecute();
 
-	_readWrite = (bool)(DATA_BUS_OPERATION::READ);
-	SetDataBusFromByteAtPC(); // get opcode
+	if constexpr (Bus::CYCLE_STEPPED) {
+		_busCycles.clear();
+	}
+
+	PollRunHook();
+}
 
-	std::cout << "$" << std::setfill('0') << std::setw(4) << GetBigEndianAddress(_programCounter) << "    ";
+template <typename Variant, typename Bus>
+bool BasicCPU<Variant, Bus>::IsInterruptPending() const {
+	return _nmiPending || (_irqLine && !IsSet(STATUS_FLAG::I));
+}
 
-	if (this->_instructionsMatrix[_dataBus] != nullptr) {
-		(this->*_instructionsMatrix[_dataBus])();
+template <typename Variant, typename Bus>
+bool BasicCPU<Variant, Bus>::IsStopped() const {
+	return !IsInterruptPending() && _map[GetBigEndianAddress(_programCounter)] == 0x00;
+}
+
+template <typename Variant, typename Bus>
+uint64_t BasicCPU<Variant, Bus>::RunCycles(uint64_t cycles, std::function<void()> const& step) {
+	uint64_t const start = _cycles;
+	uint64_t const end = start + cycles;
+
+	while (_cycles < end && !IsStopped()) {
+		if (step) {
+			// the step may run instructions without Step (skipped loops, recompiled blocks)
+			step();
+			PollRunHook();
+		}
+
+		else {
+			Step();
+		}
 	}
 
-	else {
-		std::cout << "(no instruction)" << std::endl;
+	if (_runHook) {
+		_runHook(true);
 	}
 
-	std::cout.flags(f);
+	return _cycles - start;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetRunHook(std::function<void(bool)> hook, uint64_t interval) {
+	_runHook = std::move(hook);
+	_runHookInterval = _runHook ? interval : UINT64_MAX;
+	_lastRunHook = _instructions;
 }
 
-void CPU::UpdateState(Byte reg, Byte* cmpVal, ARITHMETIC_OPERATION operation) {
-	// check N and Z flag
-	if (reg == (Byte)(0x00)) {
-		UnsetFlag(STATUS_FLAG::N);
-		SetFlag(STATUS_FLAG::Z);
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PollRunHook() {
+	// a count moved back (SetState, rewind) wraps around and calls the hook at once
+	if (_instructions - _lastRunHook >= _runHookInterval && _runHook) {
+		_lastRunHook = _instructions;
+		_runHook(false);
 	}
+}
+
+template <typename Variant, typename Bus>
+BusState BasicCPU<Variant, Bus>::Tick() {
+	if constexpr (Bus::CYCLE_STEPPED) {
+		if (_busCycles.empty()) {
+			uint64_t const start = _cycles;
+
+			FetchAndExecute();
+
+			// cycles with no access logged are handed out as such, nothing is made up for them
+			while (_busCycles.size() < _cycles - start) {
+				_busCycles.push_back({ GetBigEndianAddress(_addressBus), _dataBus, _readWrite, _cycles, false });
+			}
 
-	else if (reg >= (Byte)(0x80) && reg <= (Byte)(0xFF)) {
-		SetFlag(STATUS_FLAG::N);
-		UnsetFlag(STATUS_FLAG::Z);
+			for (size_t i = 0; i < _busCycles.size(); i++) {
+				_busCycles[i].cycles = start + i;
+			}
+		}
+
+		BusState const cycle = _busCycles.front();
+		_busCycles.pop_front();
+
+		return cycle;
 	}
 
 	else {
-		UnsetFlag(STATUS_FLAG::N);
-		UnsetFlag(STATUS_FLAG::Z);
+		FetchAndExecute();
+
+		return GetBusState();
+	}
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetTraceOutput(std::ostream* output) {
+	_trace = (output != nullptr) ? output : &_silent;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetSymbols(SymbolTable const* symbols) {
+	_symbols = symbols;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetHeatmap(Heatmap* heatmap) {
+	_heatmap = heatmap;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetCoverage(Coverage* coverage) {
+	_coverage = coverage;
+}
+
+template <typename Variant, typename Bus>
+std::ostream* BasicCPU<Variant, Bus>::GetTraceOutput() const {
+	return _trace;
+}
+
+template <typename Variant, typename Bus>
+uint64_t BasicCPU<Variant, Bus>::GetCycles() const {
+	return _cycles;
+}
+
+template <typename Variant, typename Bus>
+uint64_t BasicCPU<Variant, Bus>::GetInstructions() const {
+	return _instructions;
+}
+
+template <typename Variant, typename Bus>
+uint64_t BasicCPU<Variant, Bus>::GetInterrupts() const {
+	return _interrupts;
+}
+
+template <typename Variant, typename Bus>
+CPUState BasicCPU<Variant, Bus>::GetState() const {
+	CPUState state;
+
+	state.readWrite      = _readWrite;
+	state.dataBus        = _dataBus;
+	state.addressBus     = GetBigEndianAddress(_addressBus);
+	state.irqLine        = _irqLine;
+	state.nmiPending     = _nmiPending;
+
+	state.accumulator    = _accumulator;
+	state.indexX         = _indexX;
+	state.indexY         = _indexY;
+	state.statusFlags    = _statusFlags;
+	state.stackPointer   = _stackPointer;
+	state.programCounter = GetBigEndianAddress(_programCounter);
+
+	state.cycles         = _cycles;
+	state.instructions   = _instructions;
+	state.interrupts     = _interrupts;
+
+	return state;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetState(CPUState const& state) {
+	_readWrite      = state.readWrite;
+	_dataBus        = state.dataBus;
+	_addressBus     = GetLittleEndianAddress(state.addressBus);
+	_irqLine        = state.irqLine;
+	_nmiPending     = state.nmiPending;
+
+	_accumulator    = state.accumulator;
+	_indexX         = state.indexX;
+	_indexY         = state.indexY;
+	_statusFlags    = state.statusFlags;
+	_stackPointer   = state.stackPointer;
+	_programCounter = GetLittleEndianAddress(state.programCounter);
+
+	_cycles         = state.cycles;
+	_instructions   = state.instructions;
+	_interrupts     = state.interrupts;
+}
+
+template <typename Variant, typename Bus>
+Byte const* BasicCPU<Variant, Bus>::GetPage(Byte page) const {
+	return _map.GetPage(page);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetPage(Byte page, Byte const* data) {
+	_map.SetPage(page, data);
+	_dirtyPages.set(page);
+	_writtenPages.set(page);
+}
+
+template <typename Variant, typename Bus>
+Byte* BasicCPU<Variant, Bus>::GetWritablePage(Byte page) {
+	if (_devices[page] != nullptr) {
+		return nullptr;
+	}
+
+	_dirtyPages.set(page);
+	_writtenPages.set(page);
+
+	return _map.GetWritablePage(page);
+}
+
+template <typename Variant, typename Bus>
+bool BasicCPU<Variant, Bus>::IsPageDirty(Byte page) const {
+	return _dirtyPages.test(page);
+}
+
+template <typename Variant, typename Bus>
+std::bitset<MAX_PAGES> const& BasicCPU<Variant, Bus>::GetDirtyPages() const {
+	return _dirtyPages;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ClearDirtyPages() {
+	_dirtyPages.reset();
+}
+
+template <typename Variant, typename Bus>
+std::shared_ptr<MemoryImage const> const& BasicCPU<Variant, Bus>::GetMemoryImage() const {
+	return _map.GetImage();
+}
+
+template <typename Variant, typename Bus>
+size_t BasicCPU<Variant, Bus>::GetPrivatePages() const {
+	return _map.GetPrivatePages();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::AttachDevice(Device* device, Word start, Word size) {
+	for (int page = (start >> 8); page <= ((start + size - 1) >> 8) && page < MAX_PAGES; page++) {
+		_devices[page] = device;
 	}
+}
+
+template <typename Variant, typename Bus>
+std::vector<Device*> BasicCPU<Variant, Bus>::GetDevices() const {
+	std::vector<Device*> devices;
 
-	if (cmpVal != nullptr) {
-		if (reg < *cmpVal) {
-			UnsetFlag(STATUS_FLAG::Z);
-			UnsetFlag(STATUS_FLAG::C);
-			
-			if ((reg - *cmpVal) & 0x80) SetFlag(STATUS_FLAG::N); else UnsetFlag(STATUS_FLAG::N);
+	for (Device* device : _devices) {
+		if (device != nullptr && std::find(devices.begin(), devices.end(), device) == devices.end()) {
+			devices.push_back(device);
 		}
+	}
+
+	return devices;
+}
+
+template <typename Variant, typename Bus>
+bool BasicCPU<Variant, Bus>::IsDevicePage(Byte page) const {
+	return _devices[page] != nullptr;
+}
+
+template <typename Variant, typename Bus>
+Device* BasicCPU<Variant, Bus>::GetDevice(Byte page) const {
+	return _devices[page];
+}
+
+template <typename Variant, typename Bus>
+Byte BasicCPU<Variant, Bus>::Read(Word address) {
+	return ReadMemory(address);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::Write(Word address, Byte value) {
+	WriteMemory(address, value);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::AssertIRQ() {
+	if (_replayer == nullptr) SetInterruptLine(INPUT_EVENT::IRQ_ASSERT);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ReleaseIRQ() {
+	if (_replayer == nullptr) SetInterruptLine(INPUT_EVENT::IRQ_RELEASE);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::AssertNMI() {
+	if (_replayer == nullptr) SetInterruptLine(INPUT_EVENT::NMI_ASSERT);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetInputRecorder(InputRecorder* recorder) {
+	_recorder = recorder;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetInputReplayer(InputReplayer* replayer) {
+	_replayer = replayer;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::FetchAndExecute()  {
+	std::ios_base::fmtflags f(_trace->flags());
+	*_trace << std::hex << std::uppercase;
+
+	_instructions++;
+
+	if (_replayer != nullptr) {
+		ReplayInterrupts();
+	}
 
-		else if (reg > *cmpVal) {
-			UnsetFlag(STATUS_FLAG::Z);
-			SetFlag(STATUS_FLAG::C);
+	// interrupts are only taken between two instructions
+	if (IsInterruptPending()) {
+		TraceAddress();
 
-			if ((reg - *cmpVal) & 0x80) SetFlag(STATUS_FLAG::N); else UnsetFlag(STATUS_FLAG::N);
+		if (_nmiPending) {
+			_nmiPending = false;
+			*_trace << "(NMI)";
+			ServiceInterrupt(NMI_LOW);
 		}
 
 		else {
-			SetFlag(STATUS_FLAG::Z);
-			SetFlag(STATUS_FLAG::C);
-			UnsetFlag(STATUS_FLAG::N);
+			*_trace << "(IRQ)";
+			ServiceInterrupt(IRQ_LOW);
 		}
+
+		_trace->flags(f);
+		return;
 	}
 
-	// check V flag
-	switch (operation) {
-		case ARITHMETIC_OPERATION::ADDITION:
-			// if sides of the operation are both negative
-			if (IsNegative(reg) && IsNegative(_accumulator)) {
-				// if their sum is positive
-				if (!IsNegative((Byte)(reg + _accumulator))) {
-					SetFlag(STATUS_FLAG::V);
-				}
-				else {
-					UnsetFlag(STATUS_FLAG::V);
-				}
-			}
+	_readWrite = (bool)(DATA_BUS_OPERATION::READ);
+	SetDataBusFromByteAtPC(); // get opcode
+
+	if (_heatmap != nullptr) {
+		_heatmap->Count(ACCESS_KIND::EXECUTE, GetBigEndianAddress(_programCounter));
+	}
+
+	if (_coverage != nullptr) {
+		_coverage->Mark(COVERAGE_BIT::EXECUTED, GetBigEndianAddress(_programCounter));
+	}
+
+	_cycles += _instructionsCycles[_dataBus];
+
+	// implied and accumulator instructions read the byte after the opcode anyway
+	if ((_dataBus & 0x0F) == 0x08 || (_dataBus & 0x0F) == 0x0A) {
+		DummyRead(GetBigEndianAddress(_programCounter) + 1);
+	}
+
+	TraceAddress();
+
+	if (this->_instructionsMatrix[_dataBus] != nullptr) {
+		(this->*_instructionsMatrix[_dataBus])();
+	}
+
+	else {
+		*_trace << "(no instruction)" << std::endl;
+	}
+
+	_trace->flags(f);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TraceAddress() {
+	Word const address = GetBigEndianAddress(_programCounter);
+
+	*_trace << "$" << std::setfill('0') << std::setw(4) << address << "    ";
+
+	// a silenced trace doesn't pay for the lookup
+	if (_symbols != nullptr && _trace != &_silent) {
+		std::string const label = _symbols->Format(address);
+		*_trace << label << std::string((label.size() < 20) ? 20 - label.size() : 1, ' ');
+	}
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ServiceInterrupt(Word vectorLow) {
+	EnterInterrupt(vectorLow, false);
+
+	_cycles += 7;
+	_interrupts++;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::EnterInterrupt(Word vectorLow, bool brk) {
+	Word const returnAddress = GetBigEndianAddress(_programCounter);
+
+	PushToStack((Byte)(returnAddress >> 8)); // saving return address high byte in stack for RTI
+	PushToStack((Byte) returnAddress);       // saving return address low byte in stack for RTI
+	PushToStack((_statusFlags & ~(Byte)(STATUS_FLAG::B)) | (brk ? (Byte)(STATUS_FLAG::B) : 0x00) | (Byte)(STATUS_FLAG::_));
+
+	SetFlag(STATUS_FLAG::I);
+
+	// the 65C02 leaves decimal mode when taking an interrupt
+	if constexpr (Variant::CMOS) {
+		UnsetFlag(STATUS_FLAG::D);
+	}
+
+	_readWrite = (bool) DATA_BUS_OPERATION::READ;
+
+	_dataBus = _map[vectorLow];
+	LogBusCycle(vectorLow, _dataBus, DATA_BUS_OPERATION::READ);
+	_addressBus = ((Word)(_dataBus) << 8);
+
+	_dataBus = _map[(Word)(vectorLow + 1)];
+	LogBusCycle((Word)(vectorLow + 1), _dataBus, DATA_BUS_OPERATION::READ);
+	_addressBus |= _dataBus;
+
+	_programCounter = _addressBus;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetInterruptLine(INPUT_EVENT event) {
+	if (_recorder != nullptr) {
+		_recorder->RecordInterrupt(_cycles, event);
+	}
+
+	switch (event) {
+		case INPUT_EVENT::IRQ_ASSERT:
+			_irqLine = true;
 			break;
 
-		case ARITHMETIC_OPERATION::SUBTRACTION:
-			// if sides of the operation are both negative
-			if (!IsNegative(reg) && !IsNegative(_accumulator)) {
-				// if their sum is negative
-				if (IsNegative((Byte)(reg + _accumulator))) {
-					SetFlag(STATUS_FLAG::V);
-				}
-				else {
-					UnsetFlag(STATUS_FLAG::V);
-				}
-			}
+		case INPUT_EVENT::IRQ_RELEASE:
+			_irqLine = false;
+			break;
+
+		case INPUT_EVENT::NMI_ASSERT:
+			_nmiPending = true;
 			break;
 
 		default:
-			UnsetFlag(STATUS_FLAG::V);
 			break;
 	}
 }
 
-void CPU::ADC() {
-	UseFullAddressingModeSet();
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ReplayInterrupts() {
+	INPUT_EVENT event;
+
+	while (_replayer->NextInterrupt(_cycles, event)) {
+		SetInterruptLine(event);
+	}
+}
+
+template <typename Variant, typename Bus>
+Byte BasicCPU<Variant, Bus>::ReadMemory(Word address) {
+	Byte const value = (_devices[address >> 8] != nullptr) ? ReadDevice(address) : _map[address];
+
+	LogBusCycle(address, value, DATA_BUS_OPERATION::READ);
+
+	if (_heatmap != nullptr) {
+		_heatmap->Count(ACCESS_KIND::READ, address);
+	}
+
+	return value;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::WriteMemory(Word address, Byte value) {
+	LogBusCycle(address, value, DATA_BUS_OPERATION::WRITE);
+
+	if (_heatmap != nullptr) {
+		_heatmap->Count(ACCESS_KIND::WRITE, address);
+	}
 
-	UpdateState(_dataBus, nullptr, ARITHMETIC_OPERATION::ADDITION);
+	if (_devices[address >> 8] != nullptr) {
+		_devices[address >> 8]->Write(address, value);
+		return;
+	}
+
+	_map.Write(address, value);
+	_dirtyPages.set(address >> 8);
+	_writtenPages.set(address >> 8);
+}
+
+template <typename Variant, typename Bus>
+Byte BasicCPU<Variant, Bus>::ReadDevice(Word address) {
+	Byte value;
+
+	// a diverged replay falls back to the live device
+	if (_replayer == nullptr || !_replayer->NextRead(_cycles, address, value)) {
+		value = _devices[address >> 8]->Read(address);
+	}
+
+	if (_recorder != nullptr) {
+		_recorder->RecordRead(_cycles, address, value);
+	}
 
-	_accumulator += _dataBus + ((_statusFlags & (Byte)(STATUS_FLAG::C)) ? 1 : 0);
+	return value;
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ADC() {
+	UseFullAddressingModeSet();
+
+	AddWithCarry(_dataBus);
 
 	IncrementProgramCounter();
 }
 
-void CPU::AND() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::AND() {
 	UseFullAddressingModeSet();
 
 	_accumulator &= _dataBus;
+	SetZeroAndNegative(_accumulator);
 
 	IncrementProgramCounter();
 }
 
-void CPU::ASL() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ASL() {
+	bool const accumulator = (_dataBus & ADDRESSING_MODE_MASK) == (Byte) PARTIAL_ADDRESSING_MODES_SET::ACCUMULATOR;
+
 	UsePartialAddressingModeSet(INDEX::INDEX_X);
 
-	// TODO
+	Byte value = accumulator ? _accumulator : _dataBus;
+
+	if (value & 0x80) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	value <<= 1;
+
+	SetZeroAndNegative(value);
+
+	if (accumulator) {
+		_accumulator = value;
+	}
+
+	else {
+		DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+		_dataBus = value;
+		WriteDataBusToAddressBus();
+	}
 
 	IncrementProgramCounter();
 }
 
-void CPU::BCC() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BCC() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
 
-	std::cout << "BCC $";
+	*_trace << "BCC $";
 	CheckBranching(STATUS_FLAG::C, false);
 }
 
-void CPU::BCS() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BCS() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
 
-	std::cout << "BCS $";
+	*_trace << "BCS $";
 	CheckBranching(STATUS_FLAG::C, true);
 }
 
-void CPU::BEQ() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BEQ() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
 
-	std::cout << "BEQ $";
+	*_trace << "BEQ $";
 	CheckBranching(STATUS_FLAG::Z, true);
 }
 
-void CPU::BIT() {
-	UsePartialAddressingModeSet();
-
-	_dataBus = _accumulator & _map[_addressBus];
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BIT() {
+	UsePartialAddressingModeSet(INDEX::INDEX_X); // indexed modes only exist on the 65C02
 
+	// N and V come from the operand (read through the devices), not from A & M
+	if ((_accumulator & _dataBus) == 0x00) { SetFlag(STATUS_FLAG::Z); } else { UnsetFlag(STATUS_FLAG::Z); }
 	if (_dataBus & (Byte)(STATUS_FLAG::N)) { SetFlag(STATUS_FLAG::N); } else { UnsetFlag(STATUS_FLAG::N); }
 	if (_dataBus & (Byte)(STATUS_FLAG::V)) { SetFlag(STATUS_FLAG::V); } else { UnsetFlag(STATUS_FLAG::V); }
 
 	IncrementProgramCounter();
 }
 
-void CPU::BMI() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BMI() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
 
-	std::cout << "BMI $";
+	*_trace << "BMI $";
 	CheckBranching(STATUS_FLAG::N, true);
 }
 
-void CPU::BNE() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BNE() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
 	
-	std::cout << "BNE $";
+	*_trace << "BNE $";
 	CheckBranching(STATUS_FLAG::Z, false);
 }
 
-void CPU::BPL() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BPL() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
 
-	std::cout << "BPL $";
+	*_trace << "BPL $";
 	CheckBranching(STATUS_FLAG::N, false);
 }
 
-void CPU::BRK() {
-	std::cout << "BRK";
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BRK() {
+	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	// TODO
+	*_trace << "BRK";
 
+	// the byte after BRK is read and skipped, RTI returns past it
 	IncrementProgramCounter();
+	DummyRead(GetBigEndianAddress(_programCounter));
+	IncrementProgramCounter();
+
+	EnterInterrupt(IRQ_LOW, true);
 }
 
-void CPU::BVC() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BVC() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
 
-	std::cout << "BVC $";
+	*_trace << "BVC $";
 	CheckBranching(STATUS_FLAG::V, false);
 }
 
-void CPU::BVS() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BVS() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
 	
-	std::cout << "BVS $";
+	*_trace << "BVS $";
 	CheckBranching(STATUS_FLAG::V, true);
 }
 
-void CPU::CLC() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CLC() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "CLC";
+	*_trace << "CLC";
 
 	UnsetFlag(STATUS_FLAG::C);
 
 	IncrementProgramCounter();
 }
 
-void CPU::CLD() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CLD() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "CLD";
+	*_trace << "CLD";
 
 	UnsetFlag(STATUS_FLAG::D);
 
 	IncrementProgramCounter();
 }
 
-void CPU::CLI() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CLI() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "CLI";
+	*_trace << "CLI";
 
 	UnsetFlag(STATUS_FLAG::I);
 
 	IncrementProgramCounter();
 }
 
-void CPU::CLV() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CLV() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "CLV";
+	*_trace << "CLV";
 
 	UnsetFlag(STATUS_FLAG::V);
 
 	IncrementProgramCounter();
 }
 
-void CPU::CMP() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CMP() {
 	UseFullAddressingModeSet();
 
-	_dataBus = _accumulator - _dataBus;
+	Compare(_accumulator, _dataBus);
 
 	IncrementProgramCounter();
 }
 
-void CPU::CPX() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CPX() {
 	UsePartialAddressingModeSet();
 
-	_dataBus = _indexX - _dataBus;
-
-	UpdateState(_dataBus);
+	Compare(_indexX, _dataBus);
 
 	IncrementProgramCounter();
 }
 
-void CPU::CPY() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CPY() {
 	UsePartialAddressingModeSet();
 
-	_dataBus = _indexY - _dataBus;
-
-	UpdateState(_dataBus);
+	Compare(_indexY, _dataBus);
 
 	IncrementProgramCounter();
 }
 
-void CPU::DEC() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DEC() {
 	UsePartialAddressingModeSet(INDEX::INDEX_X);
 
-	// TODO
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	--_dataBus;
+	SetZeroAndNegative(_dataBus);
+
+	WriteDataBusToAddressBus();
 
 	IncrementProgramCounter();
 }
 
-void CPU::DEX() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DEX() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "DEX";
+	*_trace << "DEX";
 
 	--_indexX;
+	SetZeroAndNegative(_indexX);
 
 	IncrementProgramCounter();
 }
 
-void CPU::DEY() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DEY() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "DEY";
+	*_trace << "DEY";
 	
 	--_indexY;
+	SetZeroAndNegative(_indexY);
 
 	IncrementProgramCounter();
 }
 
-void CPU::EOR() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::EOR() {
 	UseFullAddressingModeSet();
 
 	_accumulator ^= _dataBus;
+	SetZeroAndNegative(_accumulator);
 
 	IncrementProgramCounter();
 }
 
-void CPU::INC() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::INC() {
 	UsePartialAddressingModeSet(INDEX::INDEX_X);
 
-	++_map[_addressBus];
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	++_dataBus;
+	SetZeroAndNegative(_dataBus);
+
+	WriteDataBusToAddressBus();
 
 	IncrementProgramCounter();
 }
 
-void CPU::INX() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::INX() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "INX";
+	*_trace << "INX";
 
 	++_indexX;
+	SetZeroAndNegative(_indexX);
 
 	IncrementProgramCounter();
 }
 
-void CPU::INY() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::INY() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "INY";
+	*_trace << "INY";
 
 	++_indexY;
+	SetZeroAndNegative(_indexY);
 
 	IncrementProgramCounter();
 }
 
-void CPU::JMP() {
-	std::ios_base::fmtflags f(std::cout.flags());
-	std::cout << std::hex << std::uppercase;
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::JMP() {
+	std::ios_base::fmtflags f(_trace->flags());
+	*_trace << std::hex << std::uppercase;
 
 	DisplayInstructionAsBytes((size_t) BYTES_USED::THREE_BYTES);
 
 	switch (_dataBus) {
 		case (Byte) JMP_ADDRESSING_MODES::ABSOLUTE:
 			SetAddressBusFromTwoNextBytesInROM();
-			std::cout << "JMP $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus));
+			*_trace << "JMP $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus));
+			break;
+
+		case (Byte) JMP_ADDRESSING_MODES::INDIRECT: {
+			SetAddressBusFromTwoNextBytesInROM();
+			*_trace << "JMP ($" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus)) << ")";
+
+			Word const pointer = GetBigEndianAddress(_addressBus);
+			Word highPointer = (Word)(pointer + 1);
+
+			// NMOS doesn't carry into the high byte of the pointer : JMP ($xxFF) reads $xx00
+			if constexpr (!Variant::CMOS) {
+				highPointer = (pointer & 0xFF00) | (Byte)(pointer + 1);
+			}
+
+			_addressBus = (Word)(ReadMemory(pointer) << 8);
+			_addressBus |= ReadMemory(highPointer);
 			break;
+		}
 
-		case (Byte) JMP_ADDRESSING_MODES::INDIRECT:
+		// only decoded by the 65C02
+		case (Byte) JMP_ADDRESSING_MODES::INDEXED_INDIRECT: {
 			SetAddressBusFromTwoNextBytesInROM();
-			std::cout << "JMP ($" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus)) << ")";
-			
+			*_trace << "JMP ($" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus)) << ", X)";
+
+			Word const pointer = GetBigEndianAddress(_addressBus) + _indexX;
+
+			_addressBus = (Word)(ReadMemory(pointer) << 8);
+			_addressBus |= ReadMemory((Word)(pointer + 1));
 			break;
+		}
 
 		default:
 			break;
@@ -693,18 +1418,22 @@ void CPU::JMP() {
 
 	_programCounter = _addressBus;
 	
-	std::cout.flags(f);
+	_trace->flags(f);
 }
 
-void CPU::JSR() {
-	std::ios_base::fmtflags f(std::cout.flags());
-	std::cout << std::hex << std::uppercase;
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::JSR() {
+	std::ios_base::fmtflags f(_trace->flags());
+	*_trace << std::hex << std::uppercase;
 
 	DisplayInstructionAsBytes((size_t) BYTES_USED::THREE_BYTES);
 
 	/// BEGIN INSTRUCTION
-	PushToStack((Byte)GetLittleEndianAddress(GetBigEndianAddress(_programCounter) + 3)); // saving next address high byte in stack for RTS
-	PushToStack((Byte)(GetBigEndianAddress(_programCounter) + 3)); // saving next address low byte in stack for RTS
+	// the address of the last byte of JSR, RTS adds 1
+	Word const returnAddress = (Word)(GetBigEndianAddress(_programCounter) + 2);
+
+	PushToStack((Byte)(returnAddress >> 8)); // saving return address high byte in stack for RTS
+	PushToStack((Byte) returnAddress);       // saving return address low byte in stack for RTS
 
 	IncrementProgramCounter();
 	SetDataBusFromByteAtPC(); // get operand low byte
@@ -717,306 +1446,825 @@ void CPU::JSR() {
 	_programCounter = _addressBus;
 	/// END INSTRUCTION
 
-	std::cout << "JSR $" << std::setfill('0') << std::setw(4) << (int)GetBigEndianAddress(_addressBus);
+	*_trace << "JSR $" << std::setfill('0') << std::setw(4) << (int)GetBigEndianAddress(_addressBus);
 
-	std::cout.flags(f);
+	_trace->flags(f);
 }
 
-void CPU::LDA() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::LDA() {
 	UseFullAddressingModeSet();
 
 	_accumulator = _dataBus;
-
-	UpdateState(_accumulator);
+	SetZeroAndNegative(_accumulator);
 
 	IncrementProgramCounter();
 }
 
-void CPU::LDX() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::LDX() {
 	UsePartialAddressingModeSet(INDEX::INDEX_Y);
 
 	_indexX = _dataBus;
-
-	UpdateState(_indexX);
+	SetZeroAndNegative(_indexX);
 
 	IncrementProgramCounter();
 }
 
-void CPU::LDY() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::LDY() {
 	UsePartialAddressingModeSet(INDEX::INDEX_X);
 
 	_indexY = _dataBus;
-
-	UpdateState(_indexY);
+	SetZeroAndNegative(_indexY);
 
 	IncrementProgramCounter();
 }
 
-void CPU::LSR() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::LSR() {
+	bool const accumulator = (_dataBus & ADDRESSING_MODE_MASK) == (Byte) PARTIAL_ADDRESSING_MODES_SET::ACCUMULATOR;
+
 	UsePartialAddressingModeSet(INDEX::INDEX_X);
-	
-	// TODO
+
+	Byte value = accumulator ? _accumulator : _dataBus;
+
+	if (value & 0x01) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	value >>= 1;
+
+	SetZeroAndNegative(value);
+
+	if (accumulator) {
+		_accumulator = value;
+	}
+
+	else {
+		DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+		_dataBus = value;
+		WriteDataBusToAddressBus();
+	}
 
 	IncrementProgramCounter();
 }
 
-void CPU::NOP() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::NOP() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "NOP";
+	*_trace << "NOP";
 
 	IncrementProgramCounter();
 }
 
-void CPU::ORA() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ORA() {
 	UseFullAddressingModeSet();
 
-	// TODO
+	_accumulator |= _dataBus;
+	SetZeroAndNegative(_accumulator);
 
 	IncrementProgramCounter();
 }
 
-void CPU::PHA() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PHA() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "PHA";
-
-	_addressBus = (Word) _stackPointer;
-	_map[(Word)(_stack + _addressBus)] = _accumulator;
+	*_trace << "PHA";
 
-	_stackPointer--;
+	PushToStack(_accumulator);
 
 	IncrementProgramCounter();
 }
 
-void CPU::PHP() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PHP() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "PHP";
+	*_trace << "PHP";
 
-	_addressBus = (Word) _stackPointer;
-	_map[(Word)(_stack + _addressBus)] = _statusFlags;
-
-	_stackPointer--;
+	PushToStack(_statusFlags | (Byte)(STATUS_FLAG::B) | (Byte)(STATUS_FLAG::_)); // B and the unused bit only exist on the stack
 
 	IncrementProgramCounter();
 }
 
-void CPU::PLA() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PLA() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "PLA";
-	
-	_stackPointer++;
-	
-	_addressBus = (Word) _stackPointer;
-	_accumulator = _map[(Word)(_stack + _addressBus)];
+	*_trace << "PLA";
+
+	DummyRead((Word)(_stack + _stackPointer));
+	_accumulator = PullFromStack();
+	SetZeroAndNegative(_accumulator);
 
 	IncrementProgramCounter();
 }
 
-void CPU::PLP() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PLP() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "PLP";
-
-	_stackPointer++;
+	*_trace << "PLP";
 
-	_addressBus = (Word) _stackPointer;
-	_statusFlags = _map[(Word)(_stack + _addressBus)];
+	DummyRead((Word)(_stack + _stackPointer));
+	_statusFlags = PullFromStack() | (Byte)(STATUS_FLAG::_);
 
 	IncrementProgramCounter();
 }
 
-void CPU::ROL() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ROL() {
+	bool const accumulator = (_dataBus & ADDRESSING_MODE_MASK) == (Byte) PARTIAL_ADDRESSING_MODES_SET::ACCUMULATOR;
+
 	UsePartialAddressingModeSet(INDEX::INDEX_X);
 
-	// TODO
+	Byte value = accumulator ? _accumulator : _dataBus;
+
+	Byte const carry = IsSet(STATUS_FLAG::C) ? 0x01 : 0x00;
+
+	if (value & 0x80) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	value = (Byte)(value << 1) | carry;
+
+	SetZeroAndNegative(value);
+
+	if (accumulator) {
+		_accumulator = value;
+	}
+
+	else {
+		DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+		_dataBus = value;
+		WriteDataBusToAddressBus();
+	}
 
 	IncrementProgramCounter();
 }
 
-void CPU::ROR() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ROR() {
+	bool const accumulator = (_dataBus & ADDRESSING_MODE_MASK) == (Byte) PARTIAL_ADDRESSING_MODES_SET::ACCUMULATOR;
+
 	UsePartialAddressingModeSet(INDEX::INDEX_X);
 
-	// TODO
+	Byte value = accumulator ? _accumulator : _dataBus;
+
+	Byte const carry = IsSet(STATUS_FLAG::C) ? 0x80 : 0x00;
+
+	if (value & 0x01) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	value = (Byte)(value >> 1) | carry;
+
+	SetZeroAndNegative(value);
+
+	if (accumulator) {
+		_accumulator = value;
+	}
+
+	else {
+		DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+		_dataBus = value;
+		WriteDataBusToAddressBus();
+	}
 
 	IncrementProgramCounter();
 }
 
-void CPU::RTI() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::RTI() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	// TODO
+	*_trace << "RTI";
+
+	DummyRead((Word)(_stack + _stackPointer));
+	_statusFlags = PullFromStack() | (Byte)(STATUS_FLAG::_);
+
+	_addressBus = PullFromStack() << 8;
+	_addressBus |= PullFromStack();
 
-	std::cout << "RTI";
+	_programCounter = _addressBus;
 }
 
-void CPU::RTS() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::RTS() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "RTS";
+	*_trace << "RTS";
 
+	DummyRead((Word)(_stack + _stackPointer));
 	_addressBus = PullFromStack() << 8;
 	_addressBus |= PullFromStack();
 
-	_programCounter = _addressBus;
+	// JSR pushed the address of its last byte
+	_programCounter = GetLittleEndianAddress(GetBigEndianAddress(_addressBus) + 1);
 }
 
-void CPU::SBC() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SBC() {
 	UseFullAddressingModeSet();
 
-	_accumulator -= _dataBus - ((_statusFlags & (Byte)(STATUS_FLAG::C)) ? 1 : 0);
-	UpdateState(_accumulator, nullptr, ARITHMETIC_OPERATION::SUBTRACTION);
+	SubtractWithBorrow(_dataBus);
 
 	IncrementProgramCounter();
 }
 
-void CPU::SEC() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SEC() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "SEC";
+	*_trace << "SEC";
 
 	SetFlag(STATUS_FLAG::C);
 
 	IncrementProgramCounter();
 }
 
-void CPU::SED() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SED() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "SED";
+	*_trace << "SED";
 
 	SetFlag(STATUS_FLAG::D);
 
 	IncrementProgramCounter();
 }
 
-void CPU::SEI() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SEI() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "SEI";
+	*_trace << "SEI";
 
 	SetFlag(STATUS_FLAG::I);
 
 	IncrementProgramCounter();
 }
 
-void CPU::STA() {
-	UseFullAddressingModeSet(); // exception
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::STA() {
+	UseFullAddressingModeSet(DATA_BUS_OPERATION::WRITE); // exception
 
-	_indexY = _map[_addressBus];
+	_dataBus = _accumulator;
+	WriteDataBusToAddressBus();
 
 	IncrementProgramCounter();
 }
 
-void CPU::STX() {
-	UsePartialAddressingModeSet(INDEX::INDEX_Y);
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::STX() {
+	UsePartialAddressingModeSet(INDEX::INDEX_Y, DATA_BUS_OPERATION::WRITE);
 
-	_indexX = _map[_addressBus];
+	_dataBus = _indexX;
+	WriteDataBusToAddressBus();
 
 	IncrementProgramCounter();
 }
 
-void CPU::STY() {
-	UsePartialAddressingModeSet(INDEX::INDEX_X);
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::STY() {
+	UsePartialAddressingModeSet(INDEX::INDEX_X, DATA_BUS_OPERATION::WRITE);
 
-	_indexY = _map[_addressBus];
+	_dataBus = _indexY;
+	WriteDataBusToAddressBus();
 
 	IncrementProgramCounter();
 }
 
-void CPU::TAX() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TAX() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "TAX";
+	*_trace << "TAX";
 
 	_indexX = _accumulator;
+	SetZeroAndNegative(_indexX);
 
 	IncrementProgramCounter();
 }
 
-void CPU::TAY() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TAY() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "TAY";
+	*_trace << "TAY";
 
 	_indexY = _accumulator;
+	SetZeroAndNegative(_indexY);
 
 	IncrementProgramCounter();
 }
 
-void CPU::TSX() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TSX() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "TSX";
+	*_trace << "TSX";
 	
 	_indexX = _stackPointer;
+	SetZeroAndNegative(_indexX);
 
 	IncrementProgramCounter();
 }
 
-void CPU::TXA() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TXA() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "TXA";
+	*_trace << "TXA";
 
 	_accumulator = _indexX;
+	SetZeroAndNegative(_accumulator);
 
 	IncrementProgramCounter();
 }
 
-void CPU::TXS() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TXS() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "TXS";
+	*_trace << "TXS";
 
 	_stackPointer = _indexX;
 
 	IncrementProgramCounter();
 }
 
-void CPU::TYA() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TYA() {
 	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
 
-	std::cout << "TYA";
+	*_trace << "TYA";
 
 	_accumulator = _indexY;
+	SetZeroAndNegative(_accumulator);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ANC() {
+	UseFullAddressingMode(FULL_ADDRESSING_MODES_SET::IMMEDIATE);
+
+	_accumulator &= _dataBus;
+	SetZeroAndNegative(_accumulator);
+
+	if (IsSet(STATUS_FLAG::N)) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ALR() {
+	UseFullAddressingMode(FULL_ADDRESSING_MODES_SET::IMMEDIATE);
+
+	_accumulator &= _dataBus;
+
+	if (_accumulator & 0x01) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	_accumulator >>= 1;
+
+	SetZeroAndNegative(_accumulator);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ARR() {
+	UseFullAddressingMode(FULL_ADDRESSING_MODES_SET::IMMEDIATE);
+
+	Byte const carry = IsSet(STATUS_FLAG::C) ? 0x80 : 0x00;
+
+	_accumulator = (Byte)((_accumulator & _dataBus) >> 1) | carry;
+	SetZeroAndNegative(_accumulator);
+
+	// C is bit 6 of the result, V is bit 6 XOR bit 5
+	if (_accumulator & 0x40) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	if (((_accumulator >> 6) ^ (_accumulator >> 5)) & 0x01) SetFlag(STATUS_FLAG::V); else UnsetFlag(STATUS_FLAG::V);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DCP() {
+	UseFullAddressingModeSet();
+
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	--_dataBus;
+	Compare(_accumulator, _dataBus);
+
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ISC() {
+	UseFullAddressingModeSet();
+
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	++_dataBus;
+	SubtractWithBorrow(_dataBus);
+
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::LAX() {
+	// $B7 and $BF index with Y where the full set would use X
+	if (_dataBus == 0xB7) UsePartialAddressingMode(PARTIAL_ADDRESSING_MODES_SET::ZEROPAGE_INDEXED, INDEX::INDEX_Y);
+	else if (_dataBus == 0xBF) UseFullAddressingMode(FULL_ADDRESSING_MODES_SET::ABSOLUTE_Y);
+	else UseFullAddressingModeSet();
+
+	_accumulator = _dataBus;
+	_indexX = _dataBus;
+
+	SetZeroAndNegative(_accumulator);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::RLA() {
+	UseFullAddressingModeSet();
+
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	Byte const carry = IsSet(STATUS_FLAG::C) ? 0x01 : 0x00;
+
+	if (_dataBus & 0x80) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	_dataBus = (Byte)(_dataBus << 1) | carry;
+
+	_accumulator &= _dataBus;
+	SetZeroAndNegative(_accumulator);
+
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::RRA() {
+	UseFullAddressingModeSet();
+
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	Byte const carry = IsSet(STATUS_FLAG::C) ? 0x80 : 0x00;
+
+	if (_dataBus & 0x01) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	_dataBus = (Byte)(_dataBus >> 1) | carry;
+
+	AddWithCarry(_dataBus);
+
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SAX() {
+	// $97 indexes with Y where the full set would use X
+	if (_dataBus == 0x97) UsePartialAddressingMode(PARTIAL_ADDRESSING_MODES_SET::ZEROPAGE_INDEXED, INDEX::INDEX_Y, DATA_BUS_OPERATION::WRITE);
+	else UseFullAddressingModeSet(DATA_BUS_OPERATION::WRITE);
+
+	_dataBus = _accumulator & _indexX;
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SBX() {
+	UseFullAddressingMode(FULL_ADDRESSING_MODES_SET::IMMEDIATE);
+
+	Byte const value = _accumulator & _indexX;
+
+	Compare(value, _dataBus);
+	_indexX = (Byte)(value - _dataBus);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SLO() {
+	UseFullAddressingModeSet();
+
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	if (_dataBus & 0x80) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	_dataBus <<= 1;
+
+	_accumulator |= _dataBus;
+	SetZeroAndNegative(_accumulator);
+
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SRE() {
+	UseFullAddressingModeSet();
+
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	if (_dataBus & 0x01) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	_dataBus >>= 1;
+
+	_accumulator ^= _dataBus;
+	SetZeroAndNegative(_accumulator);
+
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DOP() {
+	UseFullAddressingMode(FULL_ADDRESSING_MODES_SET::IMMEDIATE);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TOP() {
+	UseFullAddressingMode(FULL_ADDRESSING_MODES_SET::ABSOLUTE);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BITImmediate() {
+	UseFullAddressingMode(FULL_ADDRESSING_MODES_SET::IMMEDIATE);
+
+	// only Z is affected in immediate mode
+	if ((_accumulator & _dataBus) == 0x00) SetFlag(STATUS_FLAG::Z); else UnsetFlag(STATUS_FLAG::Z);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::BRA() {
+	DisplayInstructionAsBytes((size_t)(BYTES_USED::TWO_BYTES));
+
+	*_trace << "BRA $";
+	CheckBranching(true);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::DEA() {
+	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
+
+	*_trace << "DEC A";
+
+	--_accumulator;
+	SetZeroAndNegative(_accumulator);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::INA() {
+	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
+
+	*_trace << "INC A";
+
+	++_accumulator;
+	SetZeroAndNegative(_accumulator);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PHX() {
+	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
+
+	*_trace << "PHX";
+
+	PushToStack(_indexX);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PHY() {
+	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
+
+	*_trace << "PHY";
+
+	PushToStack(_indexY);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PLX() {
+	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
+
+	*_trace << "PLX";
+
+	DummyRead((Word)(_stack + _stackPointer));
+	_indexX = PullFromStack();
+	SetZeroAndNegative(_indexX);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PLY() {
+	DisplayInstructionAsBytes((size_t)(BYTES_USED::ONE_BYTE));
+
+	*_trace << "PLY";
+
+	DummyRead((Word)(_stack + _stackPointer));
+	_indexY = PullFromStack();
+	SetZeroAndNegative(_indexY);
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::STZ() {
+	// $9C is absolute where the partial set would index it
+	if (_dataBus == 0x9C) UsePartialAddressingMode(PARTIAL_ADDRESSING_MODES_SET::ABSOLUTE, INDEX::UNUSED, DATA_BUS_OPERATION::WRITE);
+	else UsePartialAddressingModeSet(INDEX::INDEX_X, DATA_BUS_OPERATION::WRITE);
+
+	_dataBus = 0x00;
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TRB() {
+	// only zero page and absolute, bit 3 of the opcode picks one
+	UsePartialAddressingMode((_dataBus & 0x08) ? PARTIAL_ADDRESSING_MODES_SET::ABSOLUTE : PARTIAL_ADDRESSING_MODES_SET::ZEROPAGE);
+
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	if ((_accumulator & _dataBus) == 0x00) SetFlag(STATUS_FLAG::Z); else UnsetFlag(STATUS_FLAG::Z);
+
+	_dataBus &= ~_accumulator;
+	WriteDataBusToAddressBus();
 
 	IncrementProgramCounter();
 }
 
-void CPU::SetFlag(STATUS_FLAG flag) {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::TSB() {
+	// only zero page and absolute, bit 3 of the opcode picks one
+	UsePartialAddressingMode((_dataBus & 0x08) ? PARTIAL_ADDRESSING_MODES_SET::ABSOLUTE : PARTIAL_ADDRESSING_MODES_SET::ZEROPAGE);
+
+	DummyWrite(); // read-modify-write instructions write the unmodified value back first
+
+	if ((_accumulator & _dataBus) == 0x00) SetFlag(STATUS_FLAG::Z); else UnsetFlag(STATUS_FLAG::Z);
+
+	_dataBus |= _accumulator;
+	WriteDataBusToAddressBus();
+
+	IncrementProgramCounter();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetFlag(STATUS_FLAG flag) {
 	_statusFlags |= (Byte)(flag);
 }
 
-void CPU::UnsetFlag(STATUS_FLAG flag) {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::UnsetFlag(STATUS_FLAG flag) {
 	_statusFlags &= ~((Byte)(flag));
 }
 
-bool CPU::IsSet(STATUS_FLAG flag) const {
+template <typename Variant, typename Bus>
+bool BasicCPU<Variant, Bus>::IsSet(STATUS_FLAG flag) const {
 	return _statusFlags & (Byte)(flag);
 }
 
-bool CPU::IsNegative(Byte value) const {
+template <typename Variant, typename Bus>
+bool BasicCPU<Variant, Bus>::IsNegative(Byte value) const {
 	return value & 0x80; // check bit 8 is 1
 }
 
-void CPU::UseFullAddressingModeSet() {
-	std::ios_base::fmtflags f(std::cout.flags());
-	std::cout << std::hex << std::uppercase;
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetZeroAndNegative(Byte value) {
+	if (value == 0x00) SetFlag(STATUS_FLAG::Z); else UnsetFlag(STATUS_FLAG::Z);
+	if (IsNegative(value)) SetFlag(STATUS_FLAG::N); else UnsetFlag(STATUS_FLAG::N);
+}
 
-	std::string const instructionName = _instructionsNames[_dataBus];
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::AddWithCarry(Byte value) {
+	int const carry = IsSet(STATUS_FLAG::C) ? 1 : 0;
+	Word const sum = _accumulator + value + carry;
+
+	if (!IsSet(STATUS_FLAG::D)) {
+		// overflow when both operands have the same sign and the result another one
+		if (~(_accumulator ^ value) & (_accumulator ^ sum) & 0x80) SetFlag(STATUS_FLAG::V); else UnsetFlag(STATUS_FLAG::V);
+		if (sum > 0xFF) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+
+		_accumulator = (Byte) sum;
+		SetZeroAndNegative(_accumulator);
+		return;
+	}
+
+	// decimal : each nibble is adjusted past 9, N and V come from the half-adjusted result, Z from the binary sum
+	int low = (_accumulator & 0x0F) + (value & 0x0F) + carry;
+	if (low > 0x09) low += 0x06;
+
+	int high = (_accumulator >> 4) + (value >> 4) + (low > 0x0F ? 1 : 0);
+
+	if ((Byte) sum == 0x00) SetFlag(STATUS_FLAG::Z); else UnsetFlag(STATUS_FLAG::Z);
+	if (high & 0x08) SetFlag(STATUS_FLAG::N); else UnsetFlag(STATUS_FLAG::N);
+	if (~(_accumulator ^ value) & (_accumulator ^ (high << 4)) & 0x80) SetFlag(STATUS_FLAG::V); else UnsetFlag(STATUS_FLAG::V);
+
+	if (high > 0x09) high += 0x06;
+	if (high > 0x0F) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+
+	_accumulator = (Byte)((high << 4) | (low & 0x0F));
+
+	// the 65C02 fixed N and Z
+	if constexpr (Variant::CMOS) {
+		SetZeroAndNegative(_accumulator);
+	}
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SubtractWithBorrow(Byte value) {
+	int const borrow = IsSet(STATUS_FLAG::C) ? 0 : 1;
+	int const difference = _accumulator - value - borrow;
+
+	// the flags are the binary ones in decimal mode too
+	if ((_accumulator ^ value) & (_accumulator ^ difference) & 0x80) SetFlag(STATUS_FLAG::V); else UnsetFlag(STATUS_FLAG::V);
+	if (difference >= 0) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	SetZeroAndNegative((Byte) difference);
+
+	if (!IsSet(STATUS_FLAG::D)) {
+		_accumulator = (Byte) difference;
+		return;
+	}
+
+	int low = (_accumulator & 0x0F) - (value & 0x0F) - borrow;
+	int high = (_accumulator >> 4) - (value >> 4);
 
-	switch (_dataBus & ADDRESSING_MODE_MASK) {
-		case (Byte) FULL_ADDRESSING_MODES_SET::ZEROPAGE_PRE_X: // TODO
+	if (low & 0x10) {
+		low -= 0x06;
+		high--;
+	}
+
+	if (high & 0x10) high -= 0x06;
+
+	_accumulator = (Byte)((high << 4) | (low & 0x0F));
+
+	if constexpr (Variant::CMOS) {
+		SetZeroAndNegative(_accumulator);
+	}
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::Compare(Byte reg, Byte value) {
+	if (reg >= value) SetFlag(STATUS_FLAG::C); else UnsetFlag(STATUS_FLAG::C);
+	SetZeroAndNegative((Byte)(reg - value));
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::UseFullAddressingModeSet(DATA_BUS_OPERATION operation) {
+	// 65C02 uses the unused bbb = 100, cc = 10 slot for (zp)
+	if constexpr (Variant::CMOS) {
+		if ((_dataBus & 0x1F) == 0x12) {
+			UseZeroPageIndirect(operation);
+			return;
+		}
+	}
+
+	UseFullAddressingMode((FULL_ADDRESSING_MODES_SET)(_dataBus & ADDRESSING_MODE_MASK), operation);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::UseFullAddressingMode(FULL_ADDRESSING_MODES_SET mode, DATA_BUS_OPERATION operation) {
+	std::ios_base::fmtflags f(_trace->flags());
+	*_trace << std::hex << std::uppercase;
+
+	Byte const opcode = _dataBus;
+	std::string const instructionName = _instructionsNames[opcode];
+
+	switch ((Byte) mode) {
+		case (Byte) FULL_ADDRESSING_MODES_SET::ZEROPAGE_PRE_X: {
 			DisplayInstructionAsBytes((size_t) BYTES_USED::TWO_BYTES);
 
 			IncrementProgramCounter();
 			SetDataBusFromByteAtPC(); // get operand
 
-			std::cout << instructionName << " ($" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ", X)";
+			*_trace << instructionName << " ($" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ", X)";
+
+			// the pointer wraps inside the zero page
+			Byte const pointer = (Byte)(_dataBus + _indexX);
+			UseEffectiveAddress((Word)(ReadMemory(pointer) | (ReadMemory((Byte)(pointer + 1)) << 8)), operation);
 			break;
+		}
 
 		case (Byte) FULL_ADDRESSING_MODES_SET::ZEROPAGE:
 			DisplayInstructionAsBytes((size_t) BYTES_USED::TWO_BYTES);
@@ -1024,10 +2272,9 @@ void CPU::UseFullAddressingModeSet() {
 			IncrementProgramCounter();
 			SetDataBusFromByteAtPC(); // get operand
 
-			std::cout << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus);
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus);
 
-			_addressBus = _dataBus;
-			SetDataBusFromAddressBus();
+			UseEffectiveAddress(_dataBus, operation);
 			break;
 
 		case (Byte) FULL_ADDRESSING_MODES_SET::IMMEDIATE:
@@ -1036,7 +2283,7 @@ void CPU::UseFullAddressingModeSet() {
 			IncrementProgramCounter();
 			SetDataBusFromByteAtPC(); // get operand
 
-			std::cout << instructionName << " #$" << std::setfill('0') << std::setw(2) << (int)(_dataBus);
+			*_trace << instructionName << " #$" << std::setfill('0') << std::setw(2) << (int)(_dataBus);
 			break;
 
 		case (Byte) FULL_ADDRESSING_MODES_SET::ABSOLUTE:
@@ -1044,74 +2291,84 @@ void CPU::UseFullAddressingModeSet() {
 
 			SetAddressBusFromTwoNextBytesInROM();
 
-			_dataBus = _map[GetBigEndianAddress(_addressBus)];
+			UseEffectiveAddress(GetBigEndianAddress(_addressBus), operation);
 
-			std::cout << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus));
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus));
 			break;
 
-		case (Byte) FULL_ADDRESSING_MODES_SET::ZEROPAGE_POST_Y: // TODO
+		case (Byte) FULL_ADDRESSING_MODES_SET::ZEROPAGE_POST_Y: {
 			DisplayInstructionAsBytes((size_t) BYTES_USED::TWO_BYTES);
 
 			IncrementProgramCounter();
 			SetDataBusFromByteAtPC(); // get operand
 
-			std::cout << instructionName << " ($" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << "), X";
+			*_trace << instructionName << " ($" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << "), Y";
+
+			// the pointer wraps inside the zero page, Y is added to the address it holds
+			Byte const pointer = _dataBus;
+			UseIndexedAddress(opcode, (Word)(ReadMemory(pointer) | (ReadMemory((Byte)(pointer + 1)) << 8)), _indexY, operation);
 			break;
+		}
 
-		case (Byte) FULL_ADDRESSING_MODES_SET::ZEROPAGE_X: // TODO
+		case (Byte) FULL_ADDRESSING_MODES_SET::ZEROPAGE_X:
 			DisplayInstructionAsBytes((size_t) BYTES_USED::TWO_BYTES);
 
 			IncrementProgramCounter();
 			SetDataBusFromByteAtPC(); // get operand
 
-			std::cout << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ", X";
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ", X";
+
+			UseEffectiveAddress((Byte)(_dataBus + _indexX), operation);
 			break;
 
 		case (Byte) FULL_ADDRESSING_MODES_SET::ABSOLUTE_Y:
 			DisplayInstructionAsBytes((size_t) BYTES_USED::THREE_BYTES);
 
-			SetDataBusFromByteAtPC(); // get operand low byte
-
 			SetAddressBusFromTwoNextBytesInROM();
 
-			std::cout << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus)) << ", Y";
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus)) << ", Y";
 
-			_addressBus = GetLittleEndianAddress(GetBigEndianAddress(_addressBus) + _indexY);
+			UseIndexedAddress(opcode, GetBigEndianAddress(_addressBus), _indexY, operation);
 			break;
 
 		case (Byte) FULL_ADDRESSING_MODES_SET::ABSOLUTE_X:
 			DisplayInstructionAsBytes((size_t) BYTES_USED::THREE_BYTES);
 
-			SetDataBusFromByteAtPC(); // get operand low byte
-
 			SetAddressBusFromTwoNextBytesInROM();
 
-			std::cout << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus)) << ", X";
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus)) << ", X";
 
-			_addressBus = GetLittleEndianAddress(GetBigEndianAddress(_addressBus) + _indexX);
+			UseIndexedAddress(opcode, GetBigEndianAddress(_addressBus), _indexX, operation);
 			break;
 
 		default:
 			break;
 	}
 
-	std::cout.flags(f);
+	_trace->flags(f);
 }
 
-void CPU::UsePartialAddressingModeSet(INDEX index) {
-	std::ios_base::fmtflags f(std::cout.flags());
-	std::cout << std::hex << std::uppercase;
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::UsePartialAddressingModeSet(INDEX index, DATA_BUS_OPERATION operation) {
+	UsePartialAddressingMode((PARTIAL_ADDRESSING_MODES_SET)(_dataBus & ADDRESSING_MODE_MASK), index, operation);
+}
 
-	std::string const instructionName = _instructionsNames[_dataBus];
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::UsePartialAddressingMode(PARTIAL_ADDRESSING_MODES_SET mode, INDEX index, DATA_BUS_OPERATION operation) {
+	std::ios_base::fmtflags f(_trace->flags());
+	*_trace << std::hex << std::uppercase;
+
+	Byte const opcode = _dataBus;
+	std::string const instructionName = _instructionsNames[opcode];
 
-	switch (_dataBus & ADDRESSING_MODE_MASK) {
+	switch ((Byte) mode) {
 		case (Byte) PARTIAL_ADDRESSING_MODES_SET::IMMEDIATE:
 			DisplayInstructionAsBytes((size_t) BYTES_USED::TWO_BYTES);
 
 			IncrementProgramCounter();
 			SetDataBusFromByteAtPC(); // get operand
 
-			std::cout << instructionName << " #$" << std::setfill('0') << std::setw(2) << (int)(_dataBus);
+			*_trace << instructionName << " #$" << std::setfill('0') << std::setw(2) << (int)(_dataBus);
 			break;
 
 		case (Byte) PARTIAL_ADDRESSING_MODES_SET::ZEROPAGE:
@@ -1120,16 +2377,15 @@ void CPU::UsePartialAddressingModeSet(INDEX index) {
 			IncrementProgramCounter();
 			SetDataBusFromByteAtPC(); // get operand
 
-			std::cout << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus);
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus);
 
-			_addressBus = _dataBus;
-			SetDataBusFromAddressBus();
+			UseEffectiveAddress(_dataBus, operation);
 			break;
 
 		case (Byte) PARTIAL_ADDRESSING_MODES_SET::ACCUMULATOR:
 			DisplayInstructionAsBytes((size_t) BYTES_USED::ONE_BYTE);
 
-			std::cout << instructionName << ", A";
+			*_trace << instructionName << ", A";
 			break;
 
 		case (Byte) PARTIAL_ADDRESSING_MODES_SET::ABSOLUTE:
@@ -1137,9 +2393,9 @@ void CPU::UsePartialAddressingModeSet(INDEX index) {
 
 			SetAddressBusFromTwoNextBytesInROM();
 
-			_dataBus = _map[GetBigEndianAddress(_addressBus)];
+			UseEffectiveAddress(GetBigEndianAddress(_addressBus), operation);
 
-			std::cout << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(_addressBus);
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus));
 			break;
 
 		case (Byte) PARTIAL_ADDRESSING_MODES_SET::ZEROPAGE_INDEXED:
@@ -1148,63 +2404,107 @@ void CPU::UsePartialAddressingModeSet(INDEX index) {
 			IncrementProgramCounter();
 			SetDataBusFromByteAtPC(); // get operand
 
-			switch (index) {
-				case INDEX::INDEX_X:
-					std::cout << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ", X";
-					break;
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ((index == INDEX::INDEX_Y) ? ", Y" : ", X");
 
-				case INDEX::INDEX_Y:
-					std::cout << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ", Y";
-					break;
-
-				default:
-					break;
-			}
+			// the index wraps inside the zero page
+			UseEffectiveAddress((Byte)(_dataBus + ((index == INDEX::INDEX_Y) ? _indexY : _indexX)), operation);
 			break;
 
 		case (Byte) PARTIAL_ADDRESSING_MODES_SET::ABSOLUTE_INDEXED:
 			DisplayInstructionAsBytes((size_t) BYTES_USED::THREE_BYTES);
 
-			SetDataBusFromByteAtPC(); // get operand low byte
-
 			SetAddressBusFromTwoNextBytesInROM();
 
-			switch (index) {
-				case INDEX::INDEX_X:
-					std::cout << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ", X";
-					break;
-
-				case INDEX::INDEX_Y:
-					std::cout << instructionName << " $" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ", Y";
-					break;
-
-				default:
-					break;
-			}
+			*_trace << instructionName << " $" << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_addressBus)) << ((index == INDEX::INDEX_Y) ? ", Y" : ", X");
 
-			_addressBus = GetLittleEndianAddress(GetBigEndianAddress(_addressBus) + _indexX);
+			UseIndexedAddress(opcode, GetBigEndianAddress(_addressBus), (index == INDEX::INDEX_Y) ? _indexY : _indexX, operation);
 			break;
 
 		default:
 			break;
 	}
 
-	std::cout.flags(f);
+	_trace->flags(f);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::UseZeroPageIndirect(DATA_BUS_OPERATION operation) {
+	std::ios_base::fmtflags f(_trace->flags());
+	*_trace << std::hex << std::uppercase;
+
+	std::string const instructionName = _instructionsNames[_dataBus];
+
+	DisplayInstructionAsBytes((size_t) BYTES_USED::TWO_BYTES);
+
+	IncrementProgramCounter();
+	SetDataBusFromByteAtPC(); // get pointer
+
+	*_trace << instructionName << " ($" << std::setfill('0') << std::setw(2) << (int)(_dataBus) << ")";
+
+	Byte const pointer = _dataBus;
+
+	// the pointer wraps inside the zero page
+	UseEffectiveAddress((Word)(ReadMemory(pointer) | (ReadMemory((Byte)(pointer + 1)) << 8)), operation);
+
+	_trace->flags(f);
 }
 
-void CPU::IncrementProgramCounter() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::UseEffectiveAddress(Word address, DATA_BUS_OPERATION operation) {
+	// the address bus is kept in the same byte order as the program counter for every mode
+	_addressBus = GetLittleEndianAddress(address);
+
+	if (operation == DATA_BUS_OPERATION::READ) {
+		SetDataBusFromAddressBus();
+	}
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::UseIndexedAddress(Byte opcode, Word base, Byte index, DATA_BUS_OPERATION operation) {
+	Word const address = (Word)(base + index);
+
+	// a read carrying into the high byte takes one more cycle, reading before the carry is added
+	// (the 65C02 reads the last byte of the instruction again instead)
+	if (((base ^ address) & 0xFF00) && _pageCrossCycles[opcode]) {
+		_cycles++;
+
+		if constexpr (Variant::CMOS) {
+			DummyRead(GetBigEndianAddress(_programCounter));
+		}
+
+		else {
+			DummyRead((Word)((base & 0xFF00) | (address & 0x00FF)));
+		}
+	}
+
+	UseEffectiveAddress(address, operation);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::IncrementProgramCounter() {
 	_programCounter = GetLittleEndianAddress(GetBigEndianAddress(_programCounter) + (Word)(0x01));
 }
 
-inline void CPU::SetDataBusFromByteAtPC() {
+template <typename Variant, typename Bus>
+inline void BasicCPU<Variant, Bus>::SetDataBusFromByteAtPC() {
 	_dataBus = _map[GetBigEndianAddress(_programCounter)];
+
+	LogBusCycle(GetBigEndianAddress(_programCounter), _dataBus, DATA_BUS_OPERATION::READ);
 }
 
-inline void CPU::SetDataBusFromAddressBus() {
-	_dataBus = _map[GetBigEndianAddress(_addressBus)];
+template <typename Variant, typename Bus>
+inline void BasicCPU<Variant, Bus>::SetDataBusFromAddressBus() {
+	_dataBus = ReadMemory(GetBigEndianAddress(_addressBus));
 }
 
-void CPU::SetAddressBusFromTwoNextBytesInROM() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::WriteDataBusToAddressBus() {
+	_readWrite = (bool) DATA_BUS_OPERATION::WRITE;
+	WriteMemory(GetBigEndianAddress(_addressBus), _dataBus);
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetAddressBusFromTwoNextBytesInROM() {
 	IncrementProgramCounter();
 	SetDataBusFromByteAtPC(); // get operand low byte
 	_addressBus = ((Word)(_dataBus) << 8);
@@ -1214,54 +2514,98 @@ void CPU::SetAddressBusFromTwoNextBytesInROM() {
 	_addressBus |= _dataBus;
 }
 
-void CPU::PushToStack(Byte value) {
-	_map[(Word)(_stack + _stackPointer)] = value; // set value to the stack
-	_stackPointer--;                              // decrement stack pointer
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::PushToStack(Byte value) {
+	LogBusCycle((Word)(_stack + _stackPointer), value, DATA_BUS_OPERATION::WRITE);
+
+	if (_heatmap != nullptr) {
+		_heatmap->Count(ACCESS_KIND::WRITE, (Word)(_stack + _stackPointer));
+	}
+
+	_map.Write((Word)(_stack + _stackPointer), value); // set value to the stack
+	_dirtyPages.set(_stack >> 8);                      // mark stack page as dirty
+	_writtenPages.set(_stack >> 8);
+	_stackPointer--;                                   // decrement stack pointer
+}
+
+template <typename Variant, typename Bus>
+Byte BasicCPU<Variant, Bus>::PullFromStack() {
+	_stackPointer++;                                   // increment stack pointer
+
+	Byte const value = _map[(Word)(_stack + _stackPointer)];
+	LogBusCycle((Word)(_stack + _stackPointer), value, DATA_BUS_OPERATION::READ);
+
+	if (_heatmap != nullptr) {
+		_heatmap->Count(ACCESS_KIND::READ, (Word)(_stack + _stackPointer));
+	}
+
+	return value;                                      // return value from the stack
+}
+
+template <typename Variant, typename Bus>
+inline void BasicCPU<Variant, Bus>::LogBusCycle(Word address, Byte data, DATA_BUS_OPERATION operation) {
+	if constexpr (Bus::CYCLE_STEPPED) {
+		_busCycles.push_back({ address, data, (bool) operation, _cycles });
+	}
 }
 
-Byte CPU::PullFromStack() {
-	_stackPointer++;                             // increment stack pointer
-	return _map[(Word)(_stack + _stackPointer)]; // return value from the stack
+template <typename Variant, typename Bus>
+inline void BasicCPU<Variant, Bus>::DummyRead(Word address) {
+	if constexpr (Bus::CYCLE_STEPPED) {
+		ReadMemory(address);
+	}
 }
 
-void CPU::CheckBranching(STATUS_FLAG flag, bool checkSet) {	
-	// get operand
-	IncrementProgramCounter();
-	SetDataBusFromByteAtPC();
+template <typename Variant, typename Bus>
+inline void BasicCPU<Variant, Bus>::DummyWrite() {
+	if constexpr (Bus::CYCLE_STEPPED) {
+		WriteDataBusToAddressBus();
+	}
+}
 
+template <typename Variant, typename Bus>
+BusState BasicCPU<Variant, Bus>::GetBusState() const {
+	return { GetBigEndianAddress(_addressBus), _dataBus, _readWrite, _cycles };
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CheckBranching(STATUS_FLAG flag, bool checkSet) {	
 	// particularly ugly but works : if we check for a flag to be set (eg. BCS) check isSet(flag). Else check !isSet(flag)
-	if (checkSet ? IsSet(flag) : !IsSet(flag)) {
-		UpdateState(_accumulator, &_dataBus);
-		IncrementProgramCounter();
+	CheckBranching(checkSet ? IsSet(flag) : !IsSet(flag));
+}
 
-		if (IsSet(STATUS_FLAG::N)) {
-			_programCounter = GetLittleEndianAddress(GetBigEndianAddress(_programCounter) - (Byte)(0xFF - _dataBus) - (Word)(BYTES_USED::ONE_BYTE));
-		}
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::CheckBranching(bool taken) {
+	if (_coverage != nullptr) {
+		_coverage->Mark(taken ? COVERAGE_BIT::TAKEN : COVERAGE_BIT::NOT_TAKEN, GetBigEndianAddress(_programCounter));
+	}
 
-		else {
-			_programCounter = GetLittleEndianAddress(GetBigEndianAddress(_programCounter) + (Byte)(_dataBus));
-		}
+	// get operand
+	IncrementProgramCounter();
+	SetDataBusFromByteAtPC();
+	IncrementProgramCounter();
 
-		std::cout << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_programCounter));
-	}
+	// the offset is signed and relative to the next instruction
+	Word const target = (Word)(GetBigEndianAddress(_programCounter) + (int8_t) _dataBus);
 
-	else {
-		UpdateState(_accumulator, &_dataBus);
-		IncrementProgramCounter();
+	if (taken) {
+		_cycles++; // branch taken
 
-		if (IsSet(STATUS_FLAG::N)) {
-			std::cout << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_programCounter) - (Byte)(0xFF - _dataBus) - (Word)(BYTES_USED::ONE_BYTE));
+		// and one more to fix the high byte when the target is on another page than the next instruction
+		if ((target ^ GetBigEndianAddress(_programCounter)) & 0xFF00) {
+			_cycles++;
 		}
 
-		else {
-			std::cout << std::setfill('0') << std::setw(4) << (int)(GetBigEndianAddress(_programCounter) + _dataBus);
-		}
+		_programCounter = GetLittleEndianAddress(target);
 	}
 
-	//std::cout << "    -> $" << std::setfill('0') << std::setw(4) << (int) GetBigEndianAddress(_programCounter);
+	*_trace << std::setfill('0') << std::setw(4) << (int) target;
+
+	//*_trace << "    -> $" << std::setfill('0') << std::setw(4) << (int) GetBigEndianAddress(_programCounter);
 }
 
-void CPU::SetProgramCounterFromResetVector() {
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::SetProgramCounterFromResetVector() {
 	_readWrite = (bool) DATA_BUS_OPERATION::READ;
 
 	_dataBus = _map[RESET_LOW];
@@ -1274,3 +2618,53 @@ void CPU::SetProgramCounterFromResetVector() {
 
 	_programCounter = _addressBus;
 }
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::RestorePages() {
+	MemoryImage const& image = *_map.GetImage();
+
+	for (int page = 0; page < MAX_PAGES; page++) {
+		if (_writtenPages[page]) {
+			_map.SetPage((Byte) page, image.GetPage((Byte) page));
+		}
+	}
+
+	// the pages copied back changed : observers of the dirty pages see them as written
+	_dirtyPages |= _writtenPages;
+	_writtenPages.reset();
+}
+
+template <typename Variant, typename Bus>
+void BasicCPU<Variant, Bus>::ResetRegisters() {
+	_readWrite = (bool) DATA_BUS_OPERATION::READ;
+	_dataBus = 0x00;
+	_addressBus = 0x0000;
+	_nmiPending = false;
+
+	_accumulator = 0x00;
+	_indexX = 0x00;
+	_indexY = 0x00;
+	_statusFlags = (Byte) STATUS_FLAG::_;
+	_stackPointer = 0x00;
+
+	_cycles = 0;
+	_instructions = 0;
+	_interrupts = 0;
+
+	_busCycles.clear();
+
+	// reset sequence : three stack accesses with writes inhibited, then the vector
+	_stackPointer -= 3;
+	SetFlag(STATUS_FLAG::I);
+
+	SetProgramCounterFromResetVector();
+
+	_cycles += 7;
+}
+
+template class BasicCPU<MOS6502, InstructionStepped>;
+template class BasicCPU<MOS6502, CycleStepped>;
+template class BasicCPU<MOS6502Undocumented, InstructionStepped>;
+template class BasicCPU<MOS6502Undocumented, CycleStepped>;
+template class BasicCPU<CMOS65C02, InstructionStepped>;
+template class BasicCPU<CMOS65C02, CycleStepped>;
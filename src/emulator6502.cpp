@@ -0,0 +1,321 @@
+#include "emulator6502.h"
+
+#include <memory>
+#include <vector>
+#include <bitset>
+
+#include "cpu.hpp"
+#include "opcodes.hpp"
+
+// MMIO pages routed to the callbacks of the embedder
+class CallbackDevice : public Device {
+	public:
+		CallbackDevice(Emulator6502ReadCallback read, Emulator6502WriteCallback write, void* user) {
+			_read = read;
+			_write = write;
+			_user = user;
+		}
+
+		Byte Read(Word address) override {
+			return _read(_user, address);
+		}
+
+		void Write(Word address, Byte value) override {
+			if (_write != nullptr) _write(_user, address, value);
+		}
+
+	private:
+		Emulator6502ReadCallback _read;
+		Emulator6502WriteCallback _write;
+		void* _user;
+};
+
+struct Emulator6502 {
+	struct Mapping {
+		std::unique_ptr<CallbackDevice> device;
+		Word start;
+		Word size;
+	};
+
+	std::unique_ptr<CPU> cpu;
+
+	// Contents and layout of the last image loaded
+	std::vector<Byte> ram;
+	std::vector<Byte> rom;
+
+	Word ramStart = 0x0000;
+	Word ramSize = 0x0000;
+	Word romStart = 0x0000;
+	Word romSize = 0x0000;
+
+	std::vector<Mapping> mappings;
+	std::bitset<MAX_ADDRESSABLE> breakpoints;
+
+	bool stop = false;
+};
+
+uint32_t Emulator6502Version(void) {
+	return EMULATOR6502_ABI_VERSION;
+}
+
+Emulator6502* Emulator6502Create(void) {
+	return new Emulator6502();
+}
+
+void Emulator6502Destroy(Emulator6502* emulator) {
+	delete emulator;
+}
+
+int Emulator6502Load(Emulator6502* emulator, uint8_t const* ram, uint16_t ramStart, uint32_t ramSize, uint8_t const* rom, uint16_t romStart, uint32_t romSize) {
+	if (emulator == nullptr || (ram == nullptr && ramSize > 0) || (rom == nullptr && romSize > 0)) {
+		return EMULATOR6502_ERROR_ARGUMENT;
+	}
+
+	if (ramStart + ramSize > MAX_ADDRESSABLE || romStart + romSize > MAX_ADDRESSABLE || ramSize >= MAX_ADDRESSABLE || romSize >= MAX_ADDRESSABLE
+		|| (ramStart < romStart + romSize && romStart < ramStart + ramSize)) {
+		return EMULATOR6502_ERROR_LAYOUT;
+	}
+
+	emulator->ram.assign(ram, ram + ramSize);
+	emulator->rom.assign(rom, rom + romSize);
+
+	// same layout : the CPU is kept with its devices, only the image is rebuilt
+	if (emulator->cpu != nullptr && emulator->ramStart == ramStart && emulator->ramSize == ramSize && emulator->romStart == romStart && emulator->romSize == romSize) {
+		emulator->cpu->Reload(&emulator->ram, &emulator->rom);
+		return EMULATOR6502_OK;
+	}
+
+	emulator->cpu = std::make_unique<CPU>(std::make_shared<MemoryImage const>(&emulator->ram, ramStart, (Word) ramSize, &emulator->rom, romStart, (Word) romSize));
+	emulator->cpu->SetTraceOutput(nullptr);
+
+	emulator->ramStart = ramStart;
+	emulator->ramSize = (Word) ramSize;
+	emulator->romStart = romStart;
+	emulator->romSize = (Word) romSize;
+
+	for (Emulator6502::Mapping const& mapping : emulator->mappings) {
+		emulator->cpu->AttachDevice(mapping.device.get(), mapping.start, mapping.size);
+	}
+
+	emulator->cpu->Reset();
+
+	return EMULATOR6502_OK;
+}
+
+int Emulator6502Reset(Emulator6502* emulator) {
+	if (emulator == nullptr || emulator->cpu == nullptr) {
+		return EMULATOR6502_ERROR_NOT_LOADED;
+	}
+
+	emulator->cpu->Reset();
+
+	return EMULATOR6502_OK;
+}
+
+size_t Emulator6502Run(Emulator6502* emulator, uint64_t instructions, Emulator6502Event* events, size_t capacity) {
+	if (emulator == nullptr || emulator->cpu == nullptr || events == nullptr || capacity == 0) {
+		return 0;
+	}
+
+	CPU& cpu = *emulator->cpu;
+	size_t count = 0;
+
+	auto const emit = [&](Emulator6502EventKind kind, Word address) {
+		Byte const opcode = cpu.GetPage(address >> 8)[address & 0xFF];
+		events[count++] = { (uint32_t) kind, address, opcode, 0, cpu.GetCycles() };
+	};
+
+	uint64_t const end = cpu.GetInstructions() + instructions;
+	bool first = true;
+
+	emulator->stop = false;
+
+	while (true) {
+		CPUState const state = cpu.GetState();
+		Word const pc = state.programCounter;
+		bool const interrupt = cpu.IsInterruptPending();
+		FLOW const flow = cpu.GetOpcodes()[cpu.GetPage(pc >> 8)[pc & 0xFF]].flow;
+
+		if (state.instructions >= end) {
+			emit(EMULATOR6502_EVENT_BUDGET, pc);
+			break;
+		}
+
+		if (emulator->stop) {
+			emit(EMULATOR6502_EVENT_STOP, pc);
+			break;
+		}
+
+		// a run started on a breakpoint leaves it
+		if (!first && emulator->breakpoints[pc]) {
+			emit(EMULATOR6502_EVENT_BREAKPOINT, pc);
+			break;
+		}
+
+		if (interrupt && count + 1 >= capacity) {
+			emit(EMULATOR6502_EVENT_FULL, pc);
+			break;
+		}
+
+		if (!interrupt && flow == FLOW::STOP) {
+			emit(EMULATOR6502_EVENT_BRK, pc);
+			break;
+		}
+
+		if (!interrupt && flow == FLOW::INVALID) {
+			emit(EMULATOR6502_EVENT_ILLEGAL, pc);
+			break;
+		}
+
+		first = false;
+		cpu.Step();
+
+		if (interrupt) {
+			emit(EMULATOR6502_EVENT_INTERRUPT, cpu.GetState().programCounter);
+		}
+	}
+
+	return count;
+}
+
+void Emulator6502Stop(Emulator6502* emulator) {
+	if (emulator != nullptr) emulator->stop = true;
+}
+
+int Emulator6502GetRegisters(Emulator6502 const* emulator, Emulator6502Registers* registers) {
+	if (emulator == nullptr || emulator->cpu == nullptr) {
+		return EMULATOR6502_ERROR_NOT_LOADED;
+	}
+
+	if (registers == nullptr) {
+		return EMULATOR6502_ERROR_ARGUMENT;
+	}
+
+	CPUState const state = emulator->cpu->GetState();
+
+	*registers = { state.accumulator, state.indexX, state.indexY, state.statusFlags, state.stackPointer, state.programCounter, state.cycles, state.instructions };
+
+	return EMULATOR6502_OK;
+}
+
+int Emulator6502SetRegisters(Emulator6502* emulator, Emulator6502Registers const* registers) {
+	if (emulator == nullptr || emulator->cpu == nullptr) {
+		return EMULATOR6502_ERROR_NOT_LOADED;
+	}
+
+	if (registers == nullptr) {
+		return EMULATOR6502_ERROR_ARGUMENT;
+	}
+
+	CPUState state = emulator->cpu->GetState();
+
+	state.accumulator = registers->a;
+	state.indexX = registers->x;
+	state.indexY = registers->y;
+	state.statusFlags = registers->p;
+	state.stackPointer = registers->sp;
+	state.programCounter = registers->pc;
+	state.cycles = registers->cycles;
+	state.instructions = registers->instructions;
+
+	emulator->cpu->SetState(state);
+
+	return EMULATOR6502_OK;
+}
+
+size_t Emulator6502ReadMemory(Emulator6502 const* emulator, uint16_t address, uint8_t* data, size_t size) {
+	if (emulator == nullptr || emulator->cpu == nullptr || data == nullptr) {
+		return 0;
+	}
+
+	size = std::min<size_t>(size, MAX_ADDRESSABLE - address);
+
+	for (size_t copied = 0, chunk = 0; copied < size; copied += chunk) {
+		Word const current = (Word)(address + copied);
+		Byte const* const page = emulator->cpu->GetPage(current >> 8);
+
+		chunk = std::min<size_t>(size - copied, MAX_PAGE_SIZE - (current & 0xFF));
+		std::copy(page + (current & 0xFF), page + (current & 0xFF) + chunk, data + copied);
+	}
+
+	return size;
+}
+
+size_t Emulator6502WriteMemory(Emulator6502* emulator, uint16_t address, uint8_t const* data, size_t size) {
+	if (emulator == nullptr || emulator->cpu == nullptr || data == nullptr) {
+		return 0;
+	}
+
+	size = std::min<size_t>(size, MAX_ADDRESSABLE - address);
+
+	size_t copied = 0;
+
+	for (size_t chunk = 0; copied < size; copied += chunk) {
+		Word const current = (Word)(address + copied);
+		Byte* const page = emulator->cpu->GetWritablePage(current >> 8);
+
+		if (page == nullptr) {
+			break;
+		}
+
+		chunk = std::min<size_t>(size - copied, MAX_PAGE_SIZE - (current & 0xFF));
+		std::copy(data + copied, data + copied + chunk, page + (current & 0xFF));
+	}
+
+	return copied;
+}
+
+int Emulator6502MapIO(Emulator6502* emulator, uint16_t start, uint32_t size, Emulator6502ReadCallback read, Emulator6502WriteCallback write, void* user) {
+	if (emulator == nullptr || read == nullptr || size == 0 || size >= MAX_ADDRESSABLE) {
+		return EMULATOR6502_ERROR_ARGUMENT;
+	}
+
+	if (start + size > MAX_ADDRESSABLE) {
+		return EMULATOR6502_ERROR_LAYOUT;
+	}
+
+	emulator->mappings.push_back({ std::make_unique<CallbackDevice>(read, write, user), start, (Word) size });
+
+	// kept to be attached again to the CPU of the next image with another layout
+	if (emulator->cpu != nullptr) {
+		emulator->cpu->AttachDevice(emulator->mappings.back().device.get(), start, (Word) size);
+	}
+
+	return EMULATOR6502_OK;
+}
+
+int Emulator6502SetBreakpoint(Emulator6502* emulator, uint16_t address, int enabled) {
+	if (emulator == nullptr) {
+		return EMULATOR6502_ERROR_ARGUMENT;
+	}
+
+	emulator->breakpoints[address] = enabled != 0;
+
+	return EMULATOR6502_OK;
+}
+
+int Emulator6502SetIRQ(Emulator6502* emulator, int asserted) {
+	if (emulator == nullptr || emulator->cpu == nullptr) {
+		return EMULATOR6502_ERROR_NOT_LOADED;
+	}
+
+	if (asserted) {
+		emulator->cpu->AssertIRQ();
+	}
+
+	else {
+		emulator->cpu->ReleaseIRQ();
+	}
+
+	return EMULATOR6502_OK;
+}
+
+int Emulator6502TriggerNMI(Emulator6502* emulator) {
+	if (emulator == nullptr || emulator->cpu == nullptr) {
+		return EMULATOR6502_ERROR_NOT_LOADED;
+	}
+
+	emulator->cpu->AssertNMI();
+
+	return EMULATOR6502_OK;
+}
@@ -0,0 +1,146 @@
+#include "heatmap.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include "symbols.hpp"
+
+Heatmap::Heatmap() {
+	Clear();
+}
+
+uint32_t Heatmap::Get(ACCESS_KIND kind, Word address) const {
+	return _counters[(size_t) kind][address];
+}
+
+void Heatmap::Clear() {
+	for (std::vector<uint32_t>& counters : _counters) {
+		counters.assign(MAX_ADDRESSABLE, 0);
+	}
+}
+
+void Heatmap::DisplayCSV(std::ostream& output) const {
+	output << "address,reads,writes,executes" << std::endl;
+
+	for (size_t address = 0; address < MAX_ADDRESSABLE; address++) {
+		uint32_t const reads = _counters[(size_t) ACCESS_KIND::READ][address];
+		uint32_t const writes = _counters[(size_t) ACCESS_KIND::WRITE][address];
+		uint32_t const executes = _counters[(size_t) ACCESS_KIND::EXECUTE][address];
+
+		if (reads == 0 && writes == 0 && executes == 0) {
+			continue;
+		}
+
+		output << "$" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << address << std::dec << std::setfill(' ')
+			<< "," << reads << "," << writes << "," << executes << std::endl;
+	}
+}
+
+bool Heatmap::SavePGM(std::string const& filepath, ACCESS_KIND kind) const {
+	std::ofstream output(filepath, std::ios::binary);
+
+	if (!output.is_open()) {
+		return false;
+	}
+
+	std::vector<Byte> const pixels = Scale(kind);
+
+	output << "P5\n256 256\n255\n";
+	output.write((char const*) pixels.data(), pixels.size());
+
+	return output.good();
+}
+
+bool Heatmap::SavePPM(std::string const& filepath) const {
+	std::ofstream output(filepath, std::ios::binary);
+
+	if (!output.is_open()) {
+		return false;
+	}
+
+	std::vector<Byte> const red = Scale(ACCESS_KIND::WRITE);
+	std::vector<Byte> const green = Scale(ACCESS_KIND::READ);
+	std::vector<Byte> const blue = Scale(ACCESS_KIND::EXECUTE);
+
+	std::vector<Byte> pixels(MAX_ADDRESSABLE * 3);
+
+	for (size_t address = 0; address < MAX_ADDRESSABLE; address++) {
+		pixels[address * 3 + 0] = red[address];
+		pixels[address * 3 + 1] = green[address];
+		pixels[address * 3 + 2] = blue[address];
+	}
+
+	output << "P6\n256 256\n255\n";
+	output.write((char const*) pixels.data(), pixels.size());
+
+	return output.good();
+}
+
+void Heatmap::DisplayHottest(std::ostream& output, size_t count, SymbolTable const* symbols) const {
+	std::vector<uint64_t> totals(MAX_ADDRESSABLE, 0);
+
+	for (std::vector<uint32_t> const& counters : _counters) {
+		for (size_t address = 0; address < MAX_ADDRESSABLE; address++) {
+			totals[address] += counters[address];
+		}
+	}
+
+	std::vector<Word> addresses(MAX_ADDRESSABLE);
+	std::iota(addresses.begin(), addresses.end(), 0);
+
+	count = std::min(count, (size_t) std::count_if(totals.begin(), totals.end(), [](uint64_t total) { return total != 0; }));
+
+	std::partial_sort(addresses.begin(), addresses.begin() + count, addresses.end(), [&](Word a, Word b) {
+		return (totals[a] != totals[b]) ? totals[a] > totals[b] : a < b;
+	});
+
+	addresses.resize(count);
+
+	// one batch for the names
+	std::vector<int32_t> indices(count, -1);
+
+	if (symbols != nullptr) {
+		symbols->FindAll(addresses.data(), count, indices.data());
+	}
+
+	output << std::left << std::setw(8) << "address" << std::setw(24) << "symbol" << std::right
+		<< std::setw(12) << "reads" << std::setw(12) << "writes" << std::setw(12) << "executes" << std::endl;
+
+	for (size_t i = 0; i < count; i++) {
+		Word const address = addresses[i];
+
+		std::ostringstream hex;
+		hex << "$" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << address;
+
+		output << std::left << std::setw(8) << hex.str() << std::setw(24) << ((indices[i] >= 0) ? symbols->Format(address) : "") << std::right
+			<< std::setw(12) << _counters[(size_t) ACCESS_KIND::READ][address]
+			<< std::setw(12) << _counters[(size_t) ACCESS_KIND::WRITE][address]
+			<< std::setw(12) << _counters[(size_t) ACCESS_KIND::EXECUTE][address] << std::endl;
+	}
+}
+
+std::vector<Byte> Heatmap::Scale(ACCESS_KIND kind) const {
+	std::vector<uint32_t> const& counters = _counters[(size_t) kind];
+	uint32_t const highest = *std::max_element(counters.begin(), counters.end());
+
+	std::vector<Byte> scaled(MAX_ADDRESSABLE, 0);
+
+	if (highest == 0) {
+		return scaled;
+	}
+
+	// a single access stays visible next to millions
+	double const range = std::log1p((double) highest);
+
+	for (size_t address = 0; address < MAX_ADDRESSABLE; address++) {
+		if (counters[address] != 0) {
+			scaled[address] = (Byte) std::max(1.0, std::round(255.0 * std::log1p((double) counters[address]) / range));
+		}
+	}
+
+	return scaled;
+}
@@ -0,0 +1,301 @@
+#include "idle.hpp"
+
+#include <string>
+
+IdleSkipper::IdleSkipper(CPU* cpu) {
+	_cpu = cpu;
+}
+
+uint64_t IdleSkipper::Run(uint64_t cycles) {
+	uint64_t const end = _cpu->GetCycles() + cycles;
+
+	return _cpu->RunCycles(cycles, [&]() {
+		Word const pc = _cpu->GetState().programCounter;
+		Byte const bytes[3] = { Peek(pc), Peek((Word)(pc + 1)), Peek((Word)(pc + 2)) };
+
+		// backward branch or JMP closing a short loop
+		OpcodeInfo const& info = _cpu->GetOpcodes()[bytes[0]];
+		Word target = pc;
+
+		if (info.flow == FLOW::BRANCH) {
+			target = GetBranchTarget(pc, bytes[1]);
+		}
+
+		else if (info.flow == FLOW::JUMP) {
+			target = (Word)(bytes[1] | (bytes[2] << 8));
+		}
+
+		_cpu->Step();
+
+		if (target < pc && pc - target <= MAX_IDLE_LOOP_BYTES && _cpu->GetState().programCounter == target) {
+			TrySkip(target, pc, end);
+		}
+	});
+}
+
+uint64_t IdleSkipper::GetSkippedCycles() const {
+	return _skippedCycles;
+}
+
+uint64_t IdleSkipper::GetSkippedLoops() const {
+	return _skippedLoops;
+}
+
+IdleSkipper::Loop const& IdleSkipper::GetLoop(Word head, Word tail) {
+	auto found = _loops.find(tail);
+
+	// the body may have been rewritten since, pages written are checked again
+	if (found == _loops.end() || _cpu->IsPageDirty(head >> 8) || _cpu->IsPageDirty(tail >> 8)) {
+		found = _loops.insert_or_assign(tail, Analyze(head, tail)).first;
+	}
+
+	return found->second;
+}
+
+IdleSkipper::Loop IdleSkipper::Analyze(Word head, Word tail) const {
+	Loop loop;
+	Word address = head;
+
+	while (address < tail) {
+		Byte const opcode = Peek(address);
+		OpcodeInfo const& info = _cpu->GetOpcodes()[opcode];
+
+		if (info.flow != FLOW::NEXT && info.flow != FLOW::BRANCH) {
+			return loop;
+		}
+
+		// no store, read-modify-write or stack access (undocumented and 65C02 ones included)
+		static char const* const IMPURE[] = {
+			"STA", "STX", "STY", "INC", "DEC", "PHA", "PHP", "PLA", "PLP",
+			"STZ", "TSB", "TRB", "PHX", "PHY", "PLX", "PLY",
+			"SAX", "SLO", "RLA", "SRE", "RRA", "DCP", "ISC"
+		};
+
+		for (char const* name : IMPURE) {
+			if (info.name == name) {
+				return loop;
+			}
+		}
+
+		bool const shift = info.name == "ASL" || info.name == "LSR" || info.name == "ROL" || info.name == "ROR";
+
+		if (shift && info.mode != OPERAND_MODE::ACCUMULATOR) {
+			return loop;
+		}
+
+		Word const operand = (Word)(Peek((Word)(address + 1)) | (Peek((Word)(address + 2)) << 8));
+
+		switch (info.mode) {
+			case OPERAND_MODE::ZEROPAGE:
+			case OPERAND_MODE::ZEROPAGE_X:
+			case OPERAND_MODE::ZEROPAGE_Y:
+			case OPERAND_MODE::INDEXED_INDIRECT:
+			case OPERAND_MODE::INDIRECT_INDEXED:
+			case OPERAND_MODE::ZEROPAGE_INDIRECT:
+				loop.reads.push_back({ info.mode, (Word)(operand & 0xFF) });
+				break;
+
+			case OPERAND_MODE::ABSOLUTE:
+			case OPERAND_MODE::ABSOLUTE_X:
+			case OPERAND_MODE::ABSOLUTE_Y:
+				loop.reads.push_back({ info.mode, operand });
+				break;
+
+			default:
+				break;
+		}
+
+		// counters and other uses of the index registers
+		std::string const name = info.name;
+
+		if (name == "INX") loop.countX++;
+		else if (name == "DEX") loop.countX--;
+		else if (name == "INY") loop.countY++;
+		else if (name == "DEY") loop.countY--;
+
+		loop.usesX |= name == "LDX" || name == "CPX" || name == "TXA" || name == "TXS" || name == "TAX" || name == "TSX"
+			|| info.mode == OPERAND_MODE::ZEROPAGE_X || info.mode == OPERAND_MODE::ABSOLUTE_X || info.mode == OPERAND_MODE::INDEXED_INDIRECT;
+		loop.usesY |= name == "LDY" || name == "CPY" || name == "TYA" || name == "TAY"
+			|| info.mode == OPERAND_MODE::ZEROPAGE_Y || info.mode == OPERAND_MODE::ABSOLUTE_Y || info.mode == OPERAND_MODE::INDIRECT_INDEXED;
+
+		loop.instructions++;
+		address += GetInstructionLength(info.mode);
+	}
+
+	// the instructions must lead exactly to the closing one
+	if (address != tail) {
+		return loop;
+	}
+
+	loop.instructions++;
+	loop.suitable = true;
+
+	return loop;
+}
+
+void IdleSkipper::TrySkip(Word head, Word tail, uint64_t end) {
+	Loop const& loop = GetLoop(head, tail);
+
+	if (!loop.suitable) {
+		return;
+	}
+
+	// three observations at the head, two iterations apart
+	CPUState const s0 = _cpu->GetState();
+
+	if (!StepIteration(head, tail, loop.instructions)) {
+		return;
+	}
+
+	CPUState const s1 = _cpu->GetState();
+
+	if (!StepIteration(head, tail, loop.instructions)) {
+		return;
+	}
+
+	CPUState state = _cpu->GetState();
+
+	uint64_t const cycles = state.cycles - s1.cycles;
+	uint64_t const instructions = state.instructions - s1.instructions;
+
+	if (cycles == 0 || cycles != s1.cycles - s0.cycles || instructions != s1.instructions - s0.instructions || state.cycles >= end) {
+		return;
+	}
+
+	bool const sameA = state.accumulator == s1.accumulator;
+	bool const sameX = state.indexX == s1.indexX;
+	bool const sameY = state.indexY == s1.indexY;
+	bool const sameP = state.statusFlags == s1.statusFlags && s1.statusFlags == s0.statusFlags;
+	bool const sameSP = state.stackPointer == s1.stackPointer;
+
+	uint64_t skipped = 0;
+
+	// polling : nothing changes until a device read may return another value
+	if (sameA && sameX && sameY && sameSP && state.statusFlags == s1.statusFlags) {
+		uint64_t limit = end;
+
+		for (Read const& read : loop.reads) {
+			Word const address = ResolveAddress(read, state);
+			Device const* const device = _cpu->GetDevice(address >> 8);
+
+			if (device != nullptr) {
+				limit = std::min(limit, device->GetStableUntil(address, state.cycles));
+			}
+
+			// pointers of the indirect modes
+			bool const indirect = read.mode == OPERAND_MODE::INDEXED_INDIRECT || read.mode == OPERAND_MODE::INDIRECT_INDEXED || read.mode == OPERAND_MODE::ZEROPAGE_INDIRECT;
+
+			if (indirect && _cpu->GetDevice(0x00) != nullptr) {
+				limit = state.cycles;
+			}
+		}
+
+		skipped = (limit > state.cycles) ? (limit - state.cycles) / cycles : 0;
+	}
+
+	// counting : X or Y moves by one while keeping the same N/Z flags, the rest of the body doesn't depend on it
+	else if (sameA && sameP && sameSP && sameX != sameY) {
+		for (Read const& read : loop.reads) {
+			if (_cpu->GetDevice(ResolveAddress(read, state) >> 8) != nullptr) {
+				return;
+			}
+		}
+
+		bool const countingX = !sameX;
+		Byte& counter = countingX ? state.indexX : state.indexY;
+		int const step = countingX ? loop.countX : loop.countY;
+
+		if ((countingX ? loop.usesX : loop.usesY) || (step != 1 && step != -1)) {
+			return;
+		}
+
+		Byte const previous = countingX ? s1.indexX : s1.indexY;
+		Byte const first = countingX ? s0.indexX : s0.indexY;
+
+		if ((Byte)(counter - previous) != (Byte) step || (Byte)(previous - first) != (Byte) step || counter == 0x00) {
+			return;
+		}
+
+		// last value of the class (negative or positive non zero) the counter is in
+		Byte const last = (step < 0) ? ((counter >= 0x80) ? 0x80 : 0x01) : ((counter >= 0x80) ? 0xFF : 0x7F);
+
+		skipped = (step < 0) ? counter - last : last - counter;
+		skipped = std::min<uint64_t>(skipped, (end - state.cycles) / cycles);
+
+		counter = (Byte)(counter + step * (int) skipped);
+	}
+
+	if (skipped == 0) {
+		return;
+	}
+
+	state.cycles += skipped * cycles;
+	state.instructions += skipped * instructions;
+
+	_cpu->SetState(state);
+
+	_skippedCycles += skipped * cycles;
+	_skippedLoops++;
+}
+
+bool IdleSkipper::StepIteration(Word head, Word tail, size_t maxInstructions) {
+	for (size_t i = 0; i < maxInstructions; i++) {
+		if (_cpu->IsInterruptPending()) {
+			return false;
+		}
+
+		_cpu->Step();
+
+		Word const pc = _cpu->GetState().programCounter;
+
+		if (pc == head) {
+			return true;
+		}
+
+		if (pc < head || pc > tail) {
+			return false;
+		}
+	}
+
+	return false;
+}
+
+Byte IdleSkipper::Peek(Word address) const {
+	Byte const* const page = _cpu->GetPage(address >> 8);
+
+	return (page != nullptr) ? page[address & 0xFF] : 0x00;
+}
+
+Word IdleSkipper::ResolveAddress(Read const& read, CPUState const& state) const {
+	switch (read.mode) {
+		case OPERAND_MODE::ZEROPAGE_X:
+			return (Byte)(read.operand + state.indexX);
+
+		case OPERAND_MODE::ZEROPAGE_Y:
+			return (Byte)(read.operand + state.indexY);
+
+		case OPERAND_MODE::ABSOLUTE_X:
+			return (Word)(read.operand + state.indexX);
+
+		case OPERAND_MODE::ABSOLUTE_Y:
+			return (Word)(read.operand + state.indexY);
+
+		case OPERAND_MODE::INDEXED_INDIRECT: {
+			Byte const pointer = (Byte)(read.operand + state.indexX);
+			return (Word)(Peek(pointer) | (Peek((Byte)(pointer + 1)) << 8));
+		}
+
+		case OPERAND_MODE::INDIRECT_INDEXED: {
+			Byte const pointer = (Byte) read.operand;
+			return (Word)((Peek(pointer) | (Peek((Byte)(pointer + 1)) << 8)) + state.indexY);
+		}
+
+		case OPERAND_MODE::ZEROPAGE_INDIRECT: {
+			Byte const pointer = (Byte) read.operand;
+			return (Word)(Peek(pointer) | (Peek((Byte)(pointer + 1)) << 8));
+		}
+
+		default:
+			return read.operand;
+	}
+}
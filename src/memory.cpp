@@ -0,0 +1,89 @@
+#include "memory.hpp"
+
+#include <algorithm>
+
+MemoryImage::MemoryImage(std::vector<Byte> const* ram, Word ramStart, Word ramSize, std::vector<Byte> const* rom, Word romStart, Word romSize) {
+	_ram = ramStart;
+	_rom = romStart;
+
+	_ramSize = ramSize;
+	_romSize = romSize;
+
+	_map = std::vector<Byte>(MAX_ADDRESSABLE, 0x00);
+
+	std::copy(ram->begin(), ram->begin() + std::min<int>({ ramSize, MAX_ADDRESSABLE - ramStart, (int) ram->size() }), _map.begin() + ramStart);
+	std::copy(rom->begin(), rom->begin() + std::min<int>({ romSize, MAX_ADDRESSABLE - romStart, (int) rom->size() }), _map.begin() + romStart);
+}
+
+Byte const* MemoryImage::GetPage(Byte page) const {
+	return &_map[(Word)(page << 8)];
+}
+
+Word MemoryImage::GetRAMStart() const {
+	return _ram;
+}
+
+Word MemoryImage::GetRAMSize() const {
+	return _ramSize;
+}
+
+Word MemoryImage::GetROMStart() const {
+	return _rom;
+}
+
+Word MemoryImage::GetROMSize() const {
+	return _romSize;
+}
+
+PagedMemory::PagedMemory(std::shared_ptr<MemoryImage const> image) {
+	SetImage(image);
+}
+
+Byte const* PagedMemory::GetPage(Byte page) const {
+	return _readPages[page];
+}
+
+void PagedMemory::SetPage(Byte page, Byte const* data) {
+	Byte* destination = _writePages[page];
+
+	if (destination == nullptr) {
+		destination = CopyPage(page);
+	}
+
+	std::copy(data, data + MAX_PAGE_SIZE, destination);
+}
+
+Byte* PagedMemory::GetWritablePage(Byte page) {
+	return (_writePages[page] != nullptr) ? _writePages[page] : CopyPage(page);
+}
+
+std::shared_ptr<MemoryImage const> const& PagedMemory::GetImage() const {
+	return _image;
+}
+
+void PagedMemory::SetImage(std::shared_ptr<MemoryImage const> image) {
+	_image = image;
+
+	for (int page = 0; page < MAX_PAGES; page++) {
+		_readPages[page] = _image->GetPage((Byte) page);
+		_writePages[page] = nullptr;
+	}
+
+	_privatePages.clear();
+}
+
+size_t PagedMemory::GetPrivatePages() const {
+	return _privatePages.size();
+}
+
+Byte* PagedMemory::CopyPage(Byte page) {
+	_privatePages.emplace_back(new Byte[MAX_PAGE_SIZE]);
+
+	Byte* const copy = _privatePages.back().get();
+	std::copy(_readPages[page], _readPages[page] + MAX_PAGE_SIZE, copy);
+
+	_readPages[page] = copy;
+	_writePages[page] = copy;
+
+	return copy;
+}
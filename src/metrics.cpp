@@ -0,0 +1,180 @@
+#include "metrics.hpp"
+
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+char const* GetStopReasonName(STOP_REASON reason) {
+	switch (reason) {
+		case STOP_REASON::BRK:        return "brk";
+		case STOP_REASON::BUDGET:     return "budget";
+		case STOP_REASON::BREAKPOINT: return "breakpoint";
+		case STOP_REASON::ILLEGAL:    return "illegal";
+		case STOP_REASON::REQUESTED:  return "requested";
+		default:                      return "none";
+	}
+}
+
+MetricsBlock* MapMetrics(std::string const& filepath, bool writable) {
+	void* data = nullptr;
+
+#ifndef _WIN32
+	int const file = open(filepath.c_str(), writable ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+
+	if (file < 0) {
+		return nullptr;
+	}
+
+	if (!writable && lseek(file, 0, SEEK_END) < (off_t) sizeof(MetricsBlock)) {
+		close(file);
+		return nullptr;
+	}
+
+	if (writable && ftruncate(file, sizeof(MetricsBlock)) != 0) {
+		close(file);
+		return nullptr;
+	}
+
+	data = mmap(nullptr, sizeof(MetricsBlock), writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+
+	if (data == MAP_FAILED) {
+		return nullptr;
+	}
+#else
+	HANDLE const file = CreateFileA(filepath.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		nullptr, writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+
+	HANDLE const mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, sizeof(MetricsBlock), nullptr);
+	CloseHandle(file);
+
+	if (mapping == nullptr) {
+		return nullptr;
+	}
+
+	data = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, sizeof(MetricsBlock));
+	CloseHandle(mapping);
+
+	if (data == nullptr) {
+		return nullptr;
+	}
+#endif
+
+	if (writable) {
+		MetricsBlock* const block = new (data) MetricsBlock();
+
+		block->magic = METRICS_MAGIC;
+		block->version = METRICS_VERSION;
+		block->lastStop.store((uint64_t) STOP_REASON::COUNT, std::memory_order_relaxed);
+
+		return block;
+	}
+
+	MetricsBlock* const block = static_cast<MetricsBlock*>(data);
+
+	if (block->magic != METRICS_MAGIC || block->version != METRICS_VERSION) {
+		UnmapMetrics(block);
+		return nullptr;
+	}
+
+	return block;
+}
+
+void UnmapMetrics(MetricsBlock* block) {
+	if (block == nullptr) {
+		return;
+	}
+
+#ifndef _WIN32
+	munmap(block, sizeof(MetricsBlock));
+#else
+	UnmapViewOfFile(block);
+#endif
+}
+
+Metrics::Metrics(CPU* cpu) {
+	_cpu = cpu;
+}
+
+Metrics::~Metrics() {
+	if (_block != nullptr) {
+		_cpu->SetRunHook(nullptr, 0);
+
+		Publish();
+		UnmapMetrics(_block);
+	}
+}
+
+bool Metrics::Open(std::string const& filepath) {
+	UnmapMetrics(_block);
+
+	_block = MapMetrics(filepath, true);
+
+	_lastInstructions = _cpu->GetInstructions();
+	_lastTime = std::chrono::steady_clock::now();
+
+	if (_block == nullptr) {
+		_cpu->SetRunHook(nullptr, 0);
+		return false;
+	}
+
+	_cpu->SetRunHook([this](bool stopped) {
+		if (stopped) {
+			RecordStop(_cpu->IsStopped() ? STOP_REASON::BRK : STOP_REASON::BUDGET);
+		}
+
+		else {
+			Publish();
+		}
+	}, METRICS_INTERVAL);
+
+	return true;
+}
+
+bool Metrics::IsOpen() const {
+	return _block != nullptr;
+}
+
+void Metrics::RecordStop(STOP_REASON reason) {
+	if (_block != nullptr) {
+		_block->stops[(size_t) reason].fetch_add(1, std::memory_order_relaxed);
+		_block->lastStop.store((uint64_t) reason, std::memory_order_relaxed);
+	}
+
+	Publish();
+}
+
+void Metrics::Publish() {
+	uint64_t const instructions = _cpu->GetInstructions();
+
+	if (_block == nullptr) {
+		return;
+	}
+
+	auto const now = std::chrono::steady_clock::now();
+	double const elapsed = std::chrono::duration<double>(now - _lastTime).count();
+
+	// short intervals (stops right after a publication) keep the previous rate
+	if (elapsed >= 0.01) {
+		_block->instructionsPerSecond.store((uint64_t)((instructions - _lastInstructions) / elapsed), std::memory_order_relaxed);
+
+		_lastInstructions = instructions;
+		_lastTime = now;
+	}
+
+	_block->instructions.store(instructions, std::memory_order_relaxed);
+	_block->cycles.store(_cpu->GetCycles(), std::memory_order_relaxed);
+	_block->interrupts.store(_cpu->GetInterrupts(), std::memory_order_relaxed);
+	_block->programCounter.store(_cpu->GetState().programCounter, std::memory_order_relaxed);
+	_block->updates.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,173 @@
+#include "opcodes.hpp"
+#include "cpu.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+// Mode of an opcode, from its aaabbbcc bits like the CPU addressing mode helpers
+static OPERAND_MODE DecodeMode(Byte opcode, std::string const& name, bool cmos) {
+	static OPERAND_MODE const FULL_SET[8] = {
+		OPERAND_MODE::INDEXED_INDIRECT, OPERAND_MODE::ZEROPAGE, OPERAND_MODE::IMMEDIATE, OPERAND_MODE::ABSOLUTE,
+		OPERAND_MODE::INDIRECT_INDEXED, OPERAND_MODE::ZEROPAGE_X, OPERAND_MODE::ABSOLUTE_Y, OPERAND_MODE::ABSOLUTE_X
+	};
+
+	Byte const bbb = (opcode >> 2) & 0x07;
+	Byte const cc = opcode & 0x03;
+
+	bool const shift = name == "ASL" || name == "LSR" || name == "ROL" || name == "ROR" || name == "INC" || name == "DEC";
+	bool const indexY = name == "LDX" || name == "STX" || name == "LAX" || name == "SAX";
+
+	// opcodes not following the pattern of their group
+	if (name.empty() || name == "BRK" || name == "RTI" || name == "RTS") return OPERAND_MODE::IMPLIED;
+	if (name == "JSR") return OPERAND_MODE::ABSOLUTE;
+	if (name == "BRA") return OPERAND_MODE::RELATIVE;
+	if (opcode == 0x6C) return OPERAND_MODE::INDIRECT;
+	if (opcode == 0x7C && cmos) return OPERAND_MODE::ABSOLUTE_INDEXED_INDIRECT;
+
+	// 65C02 : TRB $xx, TRB and STZ $xxxx, and the NOPs reading an absolute address
+	if (cmos && opcode == 0x14) return OPERAND_MODE::ZEROPAGE;
+	if (cmos && (opcode == 0x1C || opcode == 0x9C || opcode == 0x5C || opcode == 0xDC || opcode == 0xFC)) return OPERAND_MODE::ABSOLUTE;
+
+	switch (cc) {
+		case 0x00:
+			switch (bbb) {
+				case 0x00: return OPERAND_MODE::IMMEDIATE;
+				case 0x01: return OPERAND_MODE::ZEROPAGE;
+				case 0x03: return OPERAND_MODE::ABSOLUTE;
+				case 0x04: return OPERAND_MODE::RELATIVE;
+				case 0x05: return OPERAND_MODE::ZEROPAGE_X;
+				case 0x07: return OPERAND_MODE::ABSOLUTE_X;
+				default:   return OPERAND_MODE::IMPLIED;
+			}
+
+		case 0x02:
+			switch (bbb) {
+				case 0x00: return OPERAND_MODE::IMMEDIATE;
+				case 0x01: return OPERAND_MODE::ZEROPAGE;
+				case 0x02: return shift ? OPERAND_MODE::ACCUMULATOR : OPERAND_MODE::IMPLIED;
+				case 0x03: return OPERAND_MODE::ABSOLUTE;
+				case 0x04: return cmos ? OPERAND_MODE::ZEROPAGE_INDIRECT : OPERAND_MODE::IMPLIED;
+				case 0x05: return indexY ? OPERAND_MODE::ZEROPAGE_Y : OPERAND_MODE::ZEROPAGE_X;
+				case 0x06: return shift ? OPERAND_MODE::ACCUMULATOR : OPERAND_MODE::IMPLIED; // 65C02 INC A and DEC A
+				default:   return indexY ? OPERAND_MODE::ABSOLUTE_Y : OPERAND_MODE::ABSOLUTE_X;
+			}
+
+		case 0x03:
+			// single byte NOPs on the 65C02, LAX and SAX index with Y where the others use X
+			if (cmos) return OPERAND_MODE::IMPLIED;
+			if (indexY && FULL_SET[bbb] == OPERAND_MODE::ZEROPAGE_X) return OPERAND_MODE::ZEROPAGE_Y;
+			if (indexY && FULL_SET[bbb] == OPERAND_MODE::ABSOLUTE_X) return OPERAND_MODE::ABSOLUTE_Y;
+			return FULL_SET[bbb];
+
+		default:
+			return FULL_SET[bbb];
+	}
+}
+
+static FLOW DecodeFlow(std::string const& name, OPERAND_MODE mode) {
+	if (name.empty()) return FLOW::INVALID;
+	if (name == "BRK") return FLOW::STOP;
+	if (name == "JSR") return FLOW::CALL;
+	if (name == "RTS" || name == "RTI") return FLOW::RETURN;
+	if (name == "JMP") return (mode == OPERAND_MODE::ABSOLUTE) ? FLOW::JUMP : FLOW::JUMP_INDIRECT;
+	if (mode == OPERAND_MODE::RELATIVE) return FLOW::BRANCH;
+	return FLOW::NEXT;
+}
+
+static int8_t DecodeStack(std::string const& name) {
+	if (name == "PHA" || name == "PHP" || name == "PHX" || name == "PHY") return 1;
+	if (name == "PLA" || name == "PLP" || name == "PLX" || name == "PLY") return -1;
+	if (name == "JSR") return 2;
+	if (name == "RTS") return -2;
+	if (name == "BRK") return 3;
+	if (name == "RTI") return -3;
+	return 0;
+}
+
+template <typename Variant>
+OpcodeTable const& GetOpcodes() {
+	static OpcodeTable const opcodes = []() {
+		std::vector<std::string> const names = BasicCPU<Variant, InstructionStepped>::MakeInstructionsNames();
+		std::vector<Byte> const cycles = BasicCPU<Variant, InstructionStepped>::MakeInstructionsCycles();
+
+		OpcodeTable table;
+
+		for (size_t opcode = 0; opcode < table.size(); opcode++) {
+			OPERAND_MODE const mode = DecodeMode((Byte) opcode, names[opcode], Variant::CMOS);
+			table[opcode] = { names[opcode], mode, DecodeFlow(names[opcode], mode), cycles[opcode], DecodeStack(names[opcode]) };
+		}
+
+		return table;
+	}();
+
+	return opcodes;
+}
+
+template OpcodeTable const& GetOpcodes<MOS6502>();
+template OpcodeTable const& GetOpcodes<MOS6502Undocumented>();
+template OpcodeTable const& GetOpcodes<CMOS65C02>();
+
+OpcodeTable const* GetOpcodes(std::string const& variant) {
+	if (variant == "6502")  return &GetOpcodes<MOS6502>();
+	if (variant == "6502u") return &GetOpcodes<MOS6502Undocumented>();
+	if (variant == "65c02") return &GetOpcodes<CMOS65C02>();
+	return nullptr;
+}
+
+Byte GetInstructionLength(OPERAND_MODE mode) {
+	switch (mode) {
+		case OPERAND_MODE::IMPLIED:
+		case OPERAND_MODE::ACCUMULATOR:
+			return 1;
+
+		case OPERAND_MODE::ABSOLUTE:
+		case OPERAND_MODE::ABSOLUTE_X:
+		case OPERAND_MODE::ABSOLUTE_Y:
+		case OPERAND_MODE::INDIRECT:
+		case OPERAND_MODE::ABSOLUTE_INDEXED_INDIRECT:
+			return 3;
+
+		default:
+			return 2;
+	}
+}
+
+Word GetBranchTarget(Word address, Byte offset) {
+	return (Word)(address + 2 + (int8_t) offset);
+}
+
+std::string Disassemble(Word address, Byte const* bytes, OpcodeTable const& opcodes) {
+	OpcodeInfo const& info = opcodes[bytes[0]];
+
+	std::ostringstream text;
+	text << std::hex << std::uppercase << std::setfill('0');
+
+	if (info.flow == FLOW::INVALID) {
+		text << ".BYTE $" << std::setw(2) << (int) bytes[0];
+		return text.str();
+	}
+
+	Word const operand = (Word)(bytes[1] | (bytes[2] << 8));
+
+	text << info.name;
+
+	switch (info.mode) {
+		case OPERAND_MODE::IMPLIED:                   break;
+		case OPERAND_MODE::ACCUMULATOR:               text << " A"; break;
+		case OPERAND_MODE::IMMEDIATE:                 text << " #$" << std::setw(2) << (int) bytes[1]; break;
+		case OPERAND_MODE::ZEROPAGE:                  text << " $" << std::setw(2) << (int) bytes[1]; break;
+		case OPERAND_MODE::ZEROPAGE_X:                text << " $" << std::setw(2) << (int) bytes[1] << ", X"; break;
+		case OPERAND_MODE::ZEROPAGE_Y:                text << " $" << std::setw(2) << (int) bytes[1] << ", Y"; break;
+		case OPERAND_MODE::ABSOLUTE:                  text << " $" << std::setw(4) << (int) operand; break;
+		case OPERAND_MODE::ABSOLUTE_X:                text << " $" << std::setw(4) << (int) operand << ", X"; break;
+		case OPERAND_MODE::ABSOLUTE_Y:                text << " $" << std::setw(4) << (int) operand << ", Y"; break;
+		case OPERAND_MODE::INDIRECT:                  text << " ($" << std::setw(4) << (int) operand << ")"; break;
+		case OPERAND_MODE::INDEXED_INDIRECT:          text << " ($" << std::setw(2) << (int) bytes[1] << ", X)"; break;
+		case OPERAND_MODE::INDIRECT_INDEXED:          text << " ($" << std::setw(2) << (int) bytes[1] << "), Y"; break;
+		case OPERAND_MODE::RELATIVE:                  text << " $" << std::setw(4) << (int) GetBranchTarget(address, bytes[1]); break;
+		case OPERAND_MODE::ZEROPAGE_INDIRECT:         text << " ($" << std::setw(2) << (int) bytes[1] << ")"; break;
+		case OPERAND_MODE::ABSOLUTE_INDEXED_INDIRECT: text << " ($" << std::setw(4) << (int) operand << ", X)"; break;
+	}
+
+	return text.str();
+}
@@ -0,0 +1,195 @@
+#include "pacing.hpp"
+
+#include <chrono>
+#include <thread>
+#include <cmath>
+
+#ifdef __linux__
+#include <ctime>
+#include <cerrno>
+#endif
+
+Pacer::Pacer(CPU* cpu, double clock) {
+	_cpu = cpu;
+	_clock = clock;
+}
+
+void Pacer::SetClock(double clock) {
+	_clock = clock;
+	_anchored = false;
+}
+
+double Pacer::GetClock() const {
+	return _clock;
+}
+
+void Pacer::SetTurbo(double ratio) {
+	_turbo = std::max(ratio, 0.0);
+	_anchored = false;
+}
+
+double Pacer::GetTurbo() const {
+	return _turbo;
+}
+
+void Pacer::SetSlice(uint64_t cycles) {
+	_slice = cycles;
+}
+
+uint64_t Pacer::GetSlice() const {
+	if (_slice != 0) {
+		return _slice;
+	}
+
+	return std::max<uint64_t>(1, (uint64_t)(_clock * DEFAULT_SLICE_NANOSECONDS / 1e9));
+}
+
+void Pacer::SetSpin(int64_t nanoseconds) {
+	_spin = std::max<int64_t>(nanoseconds, 0);
+}
+
+void Pacer::SetMaxLateness(int64_t nanoseconds) {
+	_maxLateness = nanoseconds;
+}
+
+void Pacer::SetRunner(std::function<uint64_t(uint64_t)> runner) {
+	_runner = runner;
+}
+
+uint64_t Pacer::Run(uint64_t cycles) {
+	uint64_t const start = _cpu->GetCycles();
+	uint64_t const end = start + cycles;
+
+	// unpaced : a single slice, no clock read
+	if (_turbo == 0.0) {
+		return _runner ? _runner(cycles) : _cpu->RunCycles(cycles);
+	}
+
+	// a Reset or Reload since the last run restarts the cycles below the anchor
+	if (!_anchored || _cpu->GetCycles() < _anchorCycles) {
+		Resync();
+	}
+
+	uint64_t const slice = GetSlice();
+
+	while (_cpu->GetCycles() < end) {
+		uint64_t const size = std::min(slice, end - _cpu->GetCycles());
+		uint64_t const elapsed = _runner ? _runner(size) : _cpu->RunCycles(size);
+
+		_stats.slices++;
+
+		// the time of the cycles run is still waited for, a stop doesn't make the clock run faster
+		WaitDeadline();
+
+		if (elapsed < size) {
+			break;
+		}
+	}
+
+	return _cpu->GetCycles() - start;
+}
+
+void Pacer::Resync() {
+	_anchored = true;
+	_anchorTime = Now();
+	_anchorCycles = _cpu->GetCycles();
+}
+
+PacingStats const& Pacer::GetStats() const {
+	return _stats;
+}
+
+void Pacer::ClearStats() {
+	_stats = PacingStats();
+}
+
+void Pacer::DisplayStats(std::ostream& output) const {
+	output << "clock " << (uint64_t) _clock << " Hz, ";
+
+	if (_turbo == 0.0) {
+		output << "unpaced";
+	}
+
+	else {
+		output << "x" << _turbo;
+	}
+
+	output << ", slice " << GetSlice() << " cycles" << std::endl;
+	output << _stats.slices << " slices, " << _stats.lateSlices << " late (max " << _stats.maxLateness / 1000 << " us), " << _stats.resyncs << " resyncs" << std::endl;
+
+	if (_stats.sleeps > 0) {
+		output << "drift at wake up : mean " << _stats.totalDrift / (int64_t) _stats.sleeps / 1000 << " us, max " << _stats.maxDrift / 1000 << " us" << std::endl;
+	}
+
+	output << "slept " << _stats.sleptNanoseconds / 1000000 << " ms" << std::endl;
+}
+
+void Pacer::WaitDeadline() {
+	// the CPU was reset during the slice (eg. by the runner) : no deadline to wait for, the anchor restarts
+	if (_cpu->GetCycles() < _anchorCycles) {
+		Resync();
+		return;
+	}
+
+	// from the anchor every time, rounding doesn't accumulate
+	double const seconds = (double)(_cpu->GetCycles() - _anchorCycles) / (_clock * _turbo);
+	int64_t const deadline = _anchorTime + (int64_t) std::llround(seconds * 1e9);
+
+	int64_t const now = Now();
+
+	if (now > deadline) {
+		int64_t const lateness = now - deadline;
+
+		_stats.lateSlices++;
+		_stats.maxLateness = std::max(_stats.maxLateness, lateness);
+
+		if (lateness > _maxLateness) {
+			_stats.resyncs++;
+			Resync();
+		}
+
+		return;
+	}
+
+	if (deadline - now > _spin) {
+		SleepUntil(deadline - _spin);
+	}
+
+	int64_t woken = Now();
+
+	while (woken < deadline) {
+		woken = Now();
+	}
+
+	int64_t const drift = woken - deadline;
+
+	_stats.sleeps++;
+	_stats.totalDrift += drift;
+	_stats.maxDrift = std::max(_stats.maxDrift, drift);
+	_stats.sleptNanoseconds += woken - now;
+}
+
+// Monotonic nanoseconds
+int64_t Pacer::Now() {
+#ifdef __linux__
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void Pacer::SleepUntil(int64_t time) {
+#ifdef __linux__
+	timespec deadline;
+	deadline.tv_sec = time / 1000000000;
+	deadline.tv_nsec = time % 1000000000;
+
+	// signals interrupt the sleep, not the deadline
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR);
+#else
+	std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(time)));
+#endif
+}
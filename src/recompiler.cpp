@@ -0,0 +1,601 @@
+#include "recompiler.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#else
+#include <windows.h>
+#endif
+
+// The translation only knows the NMOS instructions, like the CPU the recompiled ROM runs on
+static OpcodeTable const& RECOMPILED_OPCODES = GetOpcodes<MOS6502>();
+
+static std::string Hex(int value, int width) {
+	std::ostringstream text;
+	text << "0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(width) << value;
+
+	return text.str();
+}
+
+// Expression of the effective address of a memory operand
+static std::string AddressOf(OPERAND_MODE mode, Byte low, Byte high) {
+	Word const operand = (Word)(low | (high << 8));
+
+	switch (mode) {
+		case OPERAND_MODE::ZEROPAGE:         return Hex(low, 2);
+		case OPERAND_MODE::ZEROPAGE_X:       return "(Byte)(" + Hex(low, 2) + " + c->x)";
+		case OPERAND_MODE::ZEROPAGE_Y:       return "(Byte)(" + Hex(low, 2) + " + c->y)";
+		case OPERAND_MODE::ABSOLUTE:         return Hex(operand, 4);
+		case OPERAND_MODE::ABSOLUTE_X:       return "(Word)(" + Hex(operand, 4) + " + c->x)";
+		case OPERAND_MODE::ABSOLUTE_Y:       return "(Word)(" + Hex(operand, 4) + " + c->y)";
+		case OPERAND_MODE::INDEXED_INDIRECT: return "RecompiledReadPointer(c, (Byte)(" + Hex(low, 2) + " + c->x))";
+		case OPERAND_MODE::INDIRECT_INDEXED: return "(Word)(RecompiledReadPointer(c, " + Hex(low, 2) + ") + c->y)";
+		default:                             return "";
+	}
+}
+
+// Expression of the value of a read operand
+static std::string ValueOf(OPERAND_MODE mode, Byte low, Byte high) {
+	if (mode == OPERAND_MODE::IMMEDIATE) {
+		return Hex(low, 2);
+	}
+
+	// indexed reads count the page crossing cycle
+	switch (mode) {
+		case OPERAND_MODE::ABSOLUTE_X:       return "RecompiledReadIndexed(c, " + Hex(low | (high << 8), 4) + ", c->x)";
+		case OPERAND_MODE::ABSOLUTE_Y:       return "RecompiledReadIndexed(c, " + Hex(low | (high << 8), 4) + ", c->y)";
+		case OPERAND_MODE::INDIRECT_INDEXED: return "RecompiledReadIndexed(c, RecompiledReadPointer(c, " + Hex(low, 2) + "), c->y)";
+		default:                             break;
+	}
+
+	return "RecompiledRead(c, " + AddressOf(mode, low, high) + ")";
+}
+
+// Statements of an instruction which doesn't end the block, empty if it has no translation
+static std::string Translate(std::string const& name, OPERAND_MODE mode, Byte low, Byte high) {
+	std::string const value = ValueOf(mode, low, high);
+	std::string const address = AddressOf(mode, low, high);
+
+	if (name == "LDA") return "c->a = " + value + "; RecompiledSetZeroAndNegative(c, c->a);";
+	if (name == "LDX") return "c->x = " + value + "; RecompiledSetZeroAndNegative(c, c->x);";
+	if (name == "LDY") return "c->y = " + value + "; RecompiledSetZeroAndNegative(c, c->y);";
+	if (name == "STA") return "c->write(c, " + address + ", c->a);";
+	if (name == "STX") return "c->write(c, " + address + ", c->x);";
+	if (name == "STY") return "c->write(c, " + address + ", c->y);";
+
+	if (name == "ADC") return "RecompiledADC(c, " + value + ");";
+	if (name == "SBC") return "RecompiledSBC(c, " + value + ");";
+	if (name == "AND") return "c->a &= " + value + "; RecompiledSetZeroAndNegative(c, c->a);";
+	if (name == "ORA") return "c->a |= " + value + "; RecompiledSetZeroAndNegative(c, c->a);";
+	if (name == "EOR") return "c->a ^= " + value + "; RecompiledSetZeroAndNegative(c, c->a);";
+	if (name == "CMP") return "RecompiledCompare(c, c->a, " + value + ");";
+	if (name == "CPX") return "RecompiledCompare(c, c->x, " + value + ");";
+	if (name == "CPY") return "RecompiledCompare(c, c->y, " + value + ");";
+	if (name == "BIT") return "RecompiledBIT(c, " + value + ");";
+
+	if (name == "ASL" || name == "LSR" || name == "ROL" || name == "ROR") {
+		if (mode == OPERAND_MODE::ACCUMULATOR) {
+			return "c->a = Recompiled" + name + "(c, c->a);";
+		}
+
+		return "{ Word const address = " + address + "; c->write(c, address, Recompiled" + name + "(c, RecompiledRead(c, address))); }";
+	}
+
+	if (name == "INC" || name == "DEC") {
+		return "{ Word const address = " + address + "; Byte const value = (Byte)(RecompiledRead(c, address) " + (name == "INC" ? "+" : "-") + " 1); c->write(c, address, value); RecompiledSetZeroAndNegative(c, value); }";
+	}
+
+	if (name == "INX") return "c->x++; RecompiledSetZeroAndNegative(c, c->x);";
+	if (name == "INY") return "c->y++; RecompiledSetZeroAndNegative(c, c->y);";
+	if (name == "DEX") return "c->x--; RecompiledSetZeroAndNegative(c, c->x);";
+	if (name == "DEY") return "c->y--; RecompiledSetZeroAndNegative(c, c->y);";
+	if (name == "TAX") return "c->x = c->a; RecompiledSetZeroAndNegative(c, c->x);";
+	if (name == "TAY") return "c->y = c->a; RecompiledSetZeroAndNegative(c, c->y);";
+	if (name == "TXA") return "c->a = c->x; RecompiledSetZeroAndNegative(c, c->a);";
+	if (name == "TYA") return "c->a = c->y; RecompiledSetZeroAndNegative(c, c->a);";
+	if (name == "TSX") return "c->x = c->sp; RecompiledSetZeroAndNegative(c, c->x);";
+	if (name == "TXS") return "c->sp = c->x;";
+
+	if (name == "CLC") return "RecompiledSetFlag(c, STATUS_FLAG::C, false);";
+	if (name == "SEC") return "RecompiledSetFlag(c, STATUS_FLAG::C, true);";
+	if (name == "CLI") return "RecompiledSetFlag(c, STATUS_FLAG::I, false);";
+	if (name == "SEI") return "RecompiledSetFlag(c, STATUS_FLAG::I, true);";
+	if (name == "CLD") return "RecompiledSetFlag(c, STATUS_FLAG::D, false);";
+	if (name == "SED") return "RecompiledSetFlag(c, STATUS_FLAG::D, true);";
+	if (name == "CLV") return "RecompiledSetFlag(c, STATUS_FLAG::V, false);";
+
+	if (name == "PHA") return "RecompiledPush(c, c->a);";
+	if (name == "PHP") return "RecompiledPush(c, c->p | (Byte) STATUS_FLAG::B | (Byte) STATUS_FLAG::_);";
+	if (name == "PLA") return "c->a = RecompiledPull(c); RecompiledSetZeroAndNegative(c, c->a);";
+	if (name == "PLP") return "c->p = RecompiledPull(c) | (Byte) STATUS_FLAG::_;";
+	if (name == "NOP") return ";";
+
+	return "";
+}
+
+static std::string BranchCondition(std::string const& name) {
+	if (name == "BPL") return "!RecompiledIsSet(c, STATUS_FLAG::N)";
+	if (name == "BMI") return "RecompiledIsSet(c, STATUS_FLAG::N)";
+	if (name == "BVC") return "!RecompiledIsSet(c, STATUS_FLAG::V)";
+	if (name == "BVS") return "RecompiledIsSet(c, STATUS_FLAG::V)";
+	if (name == "BCC") return "!RecompiledIsSet(c, STATUS_FLAG::C)";
+	if (name == "BCS") return "RecompiledIsSet(c, STATUS_FLAG::C)";
+	if (name == "BNE") return "!RecompiledIsSet(c, STATUS_FLAG::Z)";
+	return "RecompiledIsSet(c, STATUS_FLAG::Z)"; // BEQ
+}
+
+// Copy, fill or compare loop starting a block
+struct BulkLoop {
+	RECOMPILED_BULK operation;
+	std::string source;      // addresses before indexing
+	std::string destination;
+	char index;              // 'x' or 'y'
+	int step;
+	Byte end;                // value of the index ending the loop
+	int cycles;              // of an iteration going round
+	int instructions;
+};
+
+// Expression of the address an indexed operand is based on, empty if it isn't indexed by index
+static std::string BaseOf(OPERAND_MODE mode, Byte low, Byte high, char index) {
+	if (mode == OPERAND_MODE::ABSOLUTE_X && index == 'x') return Hex(low | (high << 8), 4);
+	if (mode == OPERAND_MODE::ABSOLUTE_Y && index == 'y') return Hex(low | (high << 8), 4);
+	if (mode == OPERAND_MODE::INDIRECT_INDEXED && index == 'y') return "RecompiledReadPointer(c, " + Hex(low, 2) + ")";
+	return "";
+}
+
+// Recognizes, from start :
+// LDA source / STA destination / INc or DEc / [CPc #end] / BNE start
+// STA destination / INc or DEc / [CPc #end] / BNE start
+// LDA source / CMP destination / BNE out / INc or DEc / [CPc #end] / BNE start
+// with the operands indexed by the counter
+template <typename ByteAt>
+static bool RecognizeBulkLoop(Word start, ByteAt const& byteAt, BulkLoop& loop) {
+	struct Decoded {
+		std::string name;
+		OPERAND_MODE mode;
+		Byte low;
+		Byte high;
+		Word address;
+	};
+
+	std::vector<Decoded> code;
+	Word pc = start;
+
+	for (int i = 0; i < 6; i++) {
+		OpcodeInfo const& info = RECOMPILED_OPCODES[byteAt(pc)];
+		code.push_back({ info.name, info.mode, byteAt((Word)(pc + 1)), byteAt((Word)(pc + 2)), pc });
+		pc = (Word)(pc + GetInstructionLength(info.mode));
+	}
+
+	size_t i = 0;
+
+	if (code[0].name == "LDA" && code[1].name == "STA") {
+		loop.operation = RECOMPILED_BULK::COPY;
+		i = 2;
+	}
+
+	else if (code[0].name == "STA") {
+		loop.operation = RECOMPILED_BULK::FILL;
+		i = 1;
+	}
+
+	else if (code[0].name == "LDA" && code[1].name == "CMP" && code[2].name == "BNE" && GetBranchTarget(code[2].address, code[2].low) > code[2].address) {
+		loop.operation = RECOMPILED_BULK::COMPARE;
+		i = 3;
+	}
+
+	else {
+		return false;
+	}
+
+	std::string const& counter = code[i].name;
+
+	if (counter != "INX" && counter != "DEX" && counter != "INY" && counter != "DEY") {
+		return false;
+	}
+
+	loop.index = (counter[2] == 'X') ? 'x' : 'y';
+	loop.step = (counter[0] == 'I') ? 1 : -1;
+	loop.end = 0x00;
+	i++;
+
+	if (code[i].name == std::string("CP") + counter[2] && code[i].mode == OPERAND_MODE::IMMEDIATE) {
+		loop.end = code[i].low;
+		i++;
+	}
+
+	if (code[i].name != "BNE" || GetBranchTarget(code[i].address, code[i].low) != start) {
+		return false;
+	}
+
+	Decoded const& destination = (loop.operation == RECOMPILED_BULK::FILL) ? code[0] : code[1];
+	loop.destination = BaseOf(destination.mode, destination.low, destination.high, loop.index);
+	loop.source = (loop.operation == RECOMPILED_BULK::FILL) ? Hex(0, 4) : BaseOf(code[0].mode, code[0].low, code[0].high, loop.index);
+
+	if (loop.destination.empty() || loop.source.empty()) {
+		return false;
+	}
+
+	// the out branch isn't taken while going round, the closing one is (crossing a page back to start or not)
+	loop.cycles = 1 + ((((code[i].address + 2) ^ start) & 0xFF00) ? 1 : 0);
+	loop.instructions = (int) i + 1;
+
+	for (size_t j = 0; j <= i; j++) {
+		loop.cycles += RECOMPILED_OPCODES[byteAt(code[j].address)].cycles;
+	}
+
+	return true;
+}
+
+static std::string Exit(int cycles, int instructions, std::string const& pc) {
+	return "c->cycles += " + std::to_string(cycles) + "; c->instructions += " + std::to_string(instructions) + "; c->pc = " + pc + "; return;";
+}
+
+void WriteRecompiledSource(ROMAnalysis const& analysis, std::vector<Byte> const& rom, Word romStart, std::ostream& output) {
+	auto const byteAt = [&](Word address) -> Byte {
+		return analysis.IsInROM(address) ? rom[address - romStart] : (Byte) 0x00;
+	};
+
+	output << "// Recompiled from a " << rom.size() << " bytes ROM at " << Hex(romStart, 4) << ", do not edit" << std::endl;
+	output << std::endl;
+	output << "#include \"recompiled.hpp\"" << std::endl;
+
+	std::vector<std::pair<Word, Word>> emitted; // start, end
+
+	for (auto const& [start, block] : analysis.GetBlocks()) {
+		// nothing to win on a block starting with an instruction left to the interpreter
+		if (RECOMPILED_OPCODES[byteAt(start)].flow == FLOW::STOP) {
+			continue;
+		}
+
+		output << std::endl << "static void Block_" << Hex(start, 4).substr(2) << "(RecompiledContext* c) {" << std::endl;
+
+		// all the iterations but the last one at once, the code below runs it and sets the flags
+		BulkLoop bulk;
+
+		if (RecognizeBulkLoop(start, byteAt, bulk)) {
+			static char const* const OPERATIONS[] = { "COPY", "FILL", "COMPARE" };
+			std::string const index = std::string("c->") + bulk.index;
+			std::string const step = std::to_string(bulk.step);
+
+			output << "\t{" << std::endl;
+			output << "\t\tWord const source = " << bulk.source << "; Word const destination = " << bulk.destination << ";" << std::endl;
+			output << "\t\tint const count = RecompiledBulk(c, RECOMPILED_BULK::" << OPERATIONS[(int) bulk.operation] << ", source, destination, "
+				<< index << ", " << step << ", RecompiledBulkIterations(" << index << ", " << step << ", " << Hex(bulk.end, 2) << "));" << std::endl;
+			output << "\t\tc->cycles += (uint64_t) count * " << bulk.cycles << "; c->instructions += (uint64_t) count * " << bulk.instructions << ";" << std::endl;
+
+			// the reads crossing a page : LDA source, and CMP destination
+			if (bulk.operation != RECOMPILED_BULK::FILL) {
+				output << "\t\tc->cycles += RecompiledBulkPageCrossings(source, " << index << ", " << step << ", count);" << std::endl;
+			}
+
+			if (bulk.operation == RECOMPILED_BULK::COMPARE) {
+				output << "\t\tc->cycles += RecompiledBulkPageCrossings(destination, " << index << ", " << step << ", count);" << std::endl;
+			}
+
+			output << "\t\t" << index << " = (Byte)(" << index << (bulk.step > 0 ? " + " : " - ") << "count);" << std::endl;
+			output << "\t}" << std::endl;
+		}
+
+		int cycles = 0;
+		int instructions = 0;
+		Word pc = start;
+
+		while (true) {
+			OpcodeInfo const& info = RECOMPILED_OPCODES[byteAt(pc)];
+			std::string const name = info.name;
+
+			Byte const low = byteAt((Word)(pc + 1));
+			Byte const high = byteAt((Word)(pc + 2));
+			Word const next = (Word)(pc + GetInstructionLength(info.mode));
+			Word const operand = (Word)(low | (high << 8));
+
+			Byte const bytes[3] = { byteAt(pc), low, high };
+			output << "\t// $" << Hex(pc, 4).substr(2) << " " << Disassemble(pc, bytes) << std::endl;
+
+			cycles += info.cycles;
+			instructions++;
+
+			if (info.flow == FLOW::NEXT) {
+				std::string const statements = Translate(name, info.mode, low, high);
+
+				output << "\t" << statements << std::endl;
+
+				// stores may have overwritten the code of this block
+				if (statements.find("c->write") != std::string::npos) {
+					output << "\tif (c->exit) { " << Exit(cycles, instructions, Hex(next, 4)) << " }" << std::endl;
+				}
+
+				if (pc == block.last) {
+					output << "\t" << Exit(cycles, instructions, Hex(next, 4)) << std::endl;
+					break;
+				}
+
+				pc = next;
+				continue;
+			}
+
+			switch (info.flow) {
+				case FLOW::BRANCH: {
+					// taken, and one more cycle when the target is on another page than the next instruction
+					Word const target = GetBranchTarget(pc, low);
+					int const taken = 1 + (((target ^ next) & 0xFF00) ? 1 : 0);
+
+					output << "\tif (" << BranchCondition(name) << ") { " << Exit(cycles + taken, instructions, Hex(target, 4)) << " }" << std::endl;
+					output << "\t" << Exit(cycles, instructions, Hex(next, 4)) << std::endl;
+					break;
+				}
+
+				case FLOW::JUMP:
+					output << "\t" << Exit(cycles, instructions, Hex(operand, 4)) << std::endl;
+					break;
+
+				case FLOW::JUMP_INDIRECT:
+					// NMOS doesn't carry into the high byte of the pointer
+					output << "\t" << Exit(cycles, instructions, "(Word)(RecompiledRead(c, " + Hex(operand, 4) + ") | (RecompiledRead(c, " + Hex((operand & 0xFF00) | (Byte)(operand + 1), 4) + ") << 8))") << std::endl;
+					break;
+
+				case FLOW::CALL:
+					// the address of the last byte of JSR, high byte first
+					output << "\tRecompiledPush(c, " << Hex((Word)(next - 1) >> 8, 2) << ");" << std::endl;
+					output << "\tRecompiledPush(c, " << Hex((Word)(next - 1) & 0xFF, 2) << ");" << std::endl;
+					output << "\t" << Exit(cycles, instructions, Hex(operand, 4)) << std::endl;
+					break;
+
+				case FLOW::RETURN:
+					if (name == "RTI") {
+						output << "\tc->p = RecompiledPull(c) | (Byte) STATUS_FLAG::_;" << std::endl;
+					}
+
+					// RTI pulls the return address itself, RTS the address of the last byte of JSR
+					output << "\t{ Byte const low = RecompiledPull(c); Byte const high = RecompiledPull(c); " << Exit(cycles, instructions, (name == "RTI") ? "(Word)(low | (high << 8))" : "(Word)((low | (high << 8)) + 1)") << " }" << std::endl;
+					break;
+
+				default:
+					// BRK is left to the interpreter
+					output << "\t" << Exit(cycles - info.cycles, instructions - 1, Hex(pc, 4)) << std::endl;
+					break;
+			}
+
+			break;
+		}
+
+		output << "}" << std::endl;
+
+		emitted.push_back({ start, block.end });
+	}
+
+	uint32_t const hash = HashRecompiledROM(rom.data(), rom.size());
+
+	output << std::endl << "static RecompiledEntry const BLOCKS[] = {" << std::endl;
+
+	for (auto const& [start, end] : emitted) {
+		output << "\t{ " << Hex(start, 4) << ", " << Hex(end, 4) << ", Block_" << Hex(start, 4).substr(2) << " }," << std::endl;
+	}
+
+	output << "\t{ 0x0000, 0x0000, nullptr }" << std::endl;
+	output << "};" << std::endl;
+
+	output << std::endl << "extern \"C\" RecompiledInfo " << RECOMPILED_INFO_SYMBOL << "() {" << std::endl;
+	output << "\treturn { " << Hex(RECOMPILED_ABI_VERSION, 2) << ", " << Hex(hash, 8) << ", " << Hex(romStart, 4) << ", " << rom.size() << " };" << std::endl;
+	output << "}" << std::endl;
+
+	output << std::endl << "extern \"C\" RecompiledEntry const* " << RECOMPILED_BLOCKS_SYMBOL << "(size_t* count) {" << std::endl;
+	output << "\t*count = " << emitted.size() << ";" << std::endl;
+	output << "\treturn BLOCKS;" << std::endl;
+	output << "}" << std::endl;
+}
+
+RecompiledROM::RecompiledROM(CPU* cpu) {
+	_cpu = cpu;
+
+	_context.read = &RecompiledROM::ReadCallback;
+	_context.write = &RecompiledROM::WriteCallback;
+	_context.writable = &RecompiledROM::WritableCallback;
+	_context.user = this;
+}
+
+RecompiledROM::~RecompiledROM() {
+	Unload();
+}
+
+bool RecompiledROM::Load(std::string const& filepath) {
+	Unload();
+
+#ifndef _WIN32
+	_library = dlopen(filepath.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+	if (_library == nullptr) {
+		return false;
+	}
+
+	auto const info = reinterpret_cast<RecompiledInfoFunction>(dlsym(_library, RECOMPILED_INFO_SYMBOL));
+	auto const blocks = reinterpret_cast<RecompiledBlocksFunction>(dlsym(_library, RECOMPILED_BLOCKS_SYMBOL));
+#else
+	_library = LoadLibraryA(filepath.c_str());
+
+	if (_library == nullptr) {
+		return false;
+	}
+
+	auto const info = reinterpret_cast<RecompiledInfoFunction>(GetProcAddress((HMODULE) _library, RECOMPILED_INFO_SYMBOL));
+	auto const blocks = reinterpret_cast<RecompiledBlocksFunction>(GetProcAddress((HMODULE) _library, RECOMPILED_BLOCKS_SYMBOL));
+#endif
+
+	if (info == nullptr || blocks == nullptr) {
+		Unload();
+		return false;
+	}
+
+	_info = info();
+
+	if (_info.abiVersion != RECOMPILED_ABI_VERSION || _info.romStart + _info.romSize > MAX_ADDRESSABLE) {
+		Unload();
+		return false;
+	}
+
+	// the blocks are only valid for the exact image they were built from
+	std::vector<Byte> rom(_info.romSize);
+
+	for (uint32_t i = 0; i < _info.romSize; i++) {
+		Word const address = (Word)(_info.romStart + i);
+		rom[i] = _cpu->GetPage(address >> 8)[address & 0xFF];
+	}
+
+	if (HashRecompiledROM(rom.data(), rom.size()) != _info.romHash) {
+		Unload();
+		return false;
+	}
+
+	_entries = blocks(&_entriesCount);
+
+	_blocks.assign(MAX_ADDRESSABLE, nullptr);
+
+	for (size_t i = 0; i < _entriesCount; i++) {
+		_blocks[_entries[i].address] = _entries[i].block;
+	}
+
+	_blocksRun = 0;
+	_interpretedSteps = 0;
+
+	return true;
+}
+
+bool RecompiledROM::IsLoaded() const {
+	return _library != nullptr;
+}
+
+uint64_t RecompiledROM::Run(uint64_t cycles) {
+	// an interpreted step may give a page a private copy
+	bool pagesLoaded = false;
+
+	return _cpu->RunCycles(cycles, [&]() {
+		CPUState const state = _cpu->GetState();
+		RecompiledBlock const block = _blocks.empty() ? nullptr : _blocks[state.programCounter];
+
+		// interrupt lines may have been changed by a device during the previous block
+		if (block == nullptr || _cpu->IsInterruptPending()) {
+			_cpu->Step();
+			_interpretedSteps++;
+
+			pagesLoaded = false;
+			return;
+		}
+
+		if (!pagesLoaded) {
+			LoadPages();
+			pagesLoaded = true;
+		}
+
+		LoadContext(state);
+
+		_context.exit = false;
+		block(&_context);
+
+		StoreContext();
+		_blocksRun++;
+	});
+}
+
+uint64_t RecompiledROM::GetBlocksRun() const {
+	return _blocksRun;
+}
+
+uint64_t RecompiledROM::GetInterpretedSteps() const {
+	return _interpretedSteps;
+}
+
+Byte RecompiledROM::ReadCallback(RecompiledContext* context, Word address) {
+	return static_cast<RecompiledROM*>(context->user)->_cpu->Read(address);
+}
+
+void RecompiledROM::WriteCallback(RecompiledContext* context, Word address, Byte value) {
+	RecompiledROM* const self = static_cast<RecompiledROM*>(context->user);
+	Byte const page = address >> 8;
+
+	self->_cpu->Write(address, value);
+
+	// the first write to a shared page gives it a private copy
+	context->pages[page] = self->_cpu->IsDevicePage(page) ? nullptr : self->_cpu->GetPage(page);
+
+	if (address < self->_info.romStart || (uint32_t)(address - self->_info.romStart) >= self->_info.romSize) {
+		return;
+	}
+
+	// self-modifying code : the blocks built over address are dropped
+	for (size_t i = 0; i < self->_entriesCount; i++) {
+		RecompiledEntry const& entry = self->_entries[i];
+
+		if (address >= entry.address && address < entry.end) {
+			self->_blocks[entry.address] = nullptr;
+		}
+	}
+
+	context->exit = true;
+}
+
+Byte* RecompiledROM::WritableCallback(RecompiledContext* context, Byte page) {
+	RecompiledROM* const self = static_cast<RecompiledROM*>(context->user);
+
+	// stores over recompiled code must go through WriteCallback
+	Word const address = (Word)(page << 8);
+
+	if (address + MAX_PAGE_SIZE > self->_info.romStart && address < self->_info.romStart + self->_info.romSize) {
+		return nullptr;
+	}
+
+	Byte* const data = self->_cpu->GetWritablePage(page);
+	context->pages[page] = data;
+
+	return data;
+}
+
+void RecompiledROM::LoadContext(CPUState const& state) {
+	_context.a = state.accumulator;
+	_context.x = state.indexX;
+	_context.y = state.indexY;
+	_context.p = state.statusFlags;
+	_context.sp = state.stackPointer;
+	_context.pc = state.programCounter;
+	_context.cycles = state.cycles;
+	_context.instructions = state.instructions;
+}
+
+void RecompiledROM::LoadPages() {
+	for (int page = 0; page < MAX_PAGES; page++) {
+		_context.pages[page] = _cpu->IsDevicePage((Byte) page) ? nullptr : _cpu->GetPage((Byte) page);
+	}
+}
+
+void RecompiledROM::StoreContext() {
+	CPUState state = _cpu->GetState();
+
+	state.accumulator = _context.a;
+	state.indexX = _context.x;
+	state.indexY = _context.y;
+	state.statusFlags = _context.p;
+	state.stackPointer = _context.sp;
+	state.programCounter = _context.pc;
+	state.cycles = _context.cycles;
+	state.instructions = _context.instructions;
+
+	_cpu->SetState(state);
+}
+
+void RecompiledROM::Unload() {
+	if (_library != nullptr) {
+#ifndef _WIN32
+		dlclose(_library);
+#else
+		FreeLibrary((HMODULE) _library);
+#endif
+	}
+
+	_library = nullptr;
+	_entries = nullptr;
+	_entriesCount = 0;
+	_blocks.clear();
+}
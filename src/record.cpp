@@ -0,0 +1,130 @@
+#include "record.hpp"
+
+static char const RECORD_MAGIC[] = "6502REC";
+
+InputRecorder::InputRecorder(std::ostream* output) {
+	_output = output;
+
+	_output->write(RECORD_MAGIC, sizeof(RECORD_MAGIC) - 1);
+	_output->put((char) RECORD_VERSION);
+}
+
+void InputRecorder::RecordRead(uint64_t cycle, Word address, Byte value) {
+	WriteEvent(INPUT_EVENT::MMIO_READ, cycle);
+
+	_output->put((char)(Byte) address);
+	_output->put((char)(Byte)(address >> 8));
+	_output->put((char) value);
+}
+
+void InputRecorder::RecordInterrupt(uint64_t cycle, INPUT_EVENT event) {
+	WriteEvent(event, cycle);
+}
+
+void InputRecorder::Finish() {
+	_output->put((char) INPUT_EVENT::END);
+	_output->flush();
+}
+
+void InputRecorder::WriteEvent(INPUT_EVENT event, uint64_t cycle) {
+	uint64_t delta = cycle - _lastCycle;
+	_lastCycle = cycle;
+
+	_output->put((char) event);
+
+	// LEB128 : 7 bits per byte, high bit set while more bytes follow
+	do {
+		Byte chunk = (Byte)(delta & 0x7F);
+		delta >>= 7;
+
+		if (delta != 0) chunk |= 0x80;
+
+		_output->put((char) chunk);
+	} while (delta != 0);
+}
+
+InputReplayer::InputReplayer(std::istream* input) {
+	_input = input;
+
+	char header[sizeof(RECORD_MAGIC)] = {};
+	_input->read(header, sizeof(header));
+
+	_valid = _input->good()
+		&& std::char_traits<char>::compare(header, RECORD_MAGIC, sizeof(RECORD_MAGIC) - 1) == 0
+		&& (Byte) header[sizeof(RECORD_MAGIC) - 1] == RECORD_VERSION;
+
+	if (_valid) {
+		ReadEvent();
+	}
+}
+
+bool InputReplayer::IsValid() const {
+	return _valid;
+}
+
+bool InputReplayer::IsDiverged() const {
+	return _diverged;
+}
+
+bool InputReplayer::NextInterrupt(uint64_t cycle, INPUT_EVENT& event) {
+	if (_event == INPUT_EVENT::END || _event == INPUT_EVENT::MMIO_READ || _cycle > cycle) {
+		return false;
+	}
+
+	event = _event;
+	ReadEvent();
+
+	return true;
+}
+
+bool InputReplayer::NextRead(uint64_t cycle, Word address, Byte& value) {
+	if (_event != INPUT_EVENT::MMIO_READ || _address != address || _cycle != cycle) {
+		_diverged = true;
+		return false;
+	}
+
+	value = _value;
+	ReadEvent();
+
+	return true;
+}
+
+void InputReplayer::ReadEvent() {
+	int const kind = _input->get();
+
+	if (kind == std::char_traits<char>::eof()) {
+		_event = INPUT_EVENT::END;
+		return;
+	}
+
+	_event = (INPUT_EVENT) kind;
+
+	if (_event == INPUT_EVENT::END) {
+		return;
+	}
+
+	uint64_t delta = 0;
+	int shift = 0;
+	int chunk = 0;
+
+	do {
+		chunk = _input->get();
+		if (chunk == std::char_traits<char>::eof()) {
+			_event = INPUT_EVENT::END;
+			return;
+		}
+
+		delta |= (uint64_t)(chunk & 0x7F) << shift;
+		shift += 7;
+	} while (chunk & 0x80);
+
+	_cycle += delta;
+
+	if (_event == INPUT_EVENT::MMIO_READ) {
+		Byte bytes[3] = {};
+		_input->read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+
+		_address = (Word)(bytes[0] | (bytes[1] << 8));
+		_value = bytes[2];
+	}
+}
@@ -0,0 +1,151 @@
+#include "rewind.hpp"
+
+Rewind::Rewind(CPU* cpu, uint64_t keyframeInterval, size_t deltaFrames, size_t maxBytes) {
+	_cpu = cpu;
+
+	_keyframeInterval = keyframeInterval;
+	_deltaFrames = deltaFrames;
+	_maxBytes = maxBytes;
+
+	_frameInterval = std::max<uint64_t>(keyframeInterval / (deltaFrames + 1), 1);
+
+	_nextCapture = _cpu->GetCycles();
+}
+
+void Rewind::Step() {
+	if (_cpu->GetCycles() >= _nextCapture) {
+		Capture();
+	}
+
+	_cpu->Step();
+}
+
+bool Rewind::StepBack(uint64_t n) {
+	uint64_t const current = _cpu->GetInstructions();
+
+	if (n > current) {
+		return false;
+	}
+
+	uint64_t const target = current - n;
+
+	// nearest frame not after the target
+	size_t index = _frames.size();
+	while (index > 0 && _frames[index - 1].state.instructions > target) {
+		index--;
+	}
+
+	if (index == 0) {
+		return false;
+	}
+
+	Restore(index - 1);
+
+	// execute forward up to the target, without tracing what was already traced
+	std::ostream* const trace = _cpu->GetTraceOutput();
+	_cpu->SetTraceOutput(nullptr);
+
+	while (_cpu->GetInstructions() < target) {
+		Step();
+	}
+
+	_cpu->SetTraceOutput(trace);
+
+	return true;
+}
+
+size_t Rewind::GetSize() const {
+	return _size;
+}
+
+void Rewind::Clear() {
+	_frames.clear();
+	_size = 0;
+
+	_framesSinceKeyframe = 0;
+	_nextCapture = _cpu->GetCycles();
+}
+
+void Rewind::Capture() {
+	Frame frame;
+
+	frame.keyframe = _frames.empty() || _framesSinceKeyframe >= _deltaFrames;
+	frame.state = _cpu->GetState();
+
+	for (int page = 0; page < MAX_PAGES; page++) {
+		if (frame.keyframe || _cpu->IsPageDirty((Byte) page)) {
+			Byte const* const data = _cpu->GetPage((Byte) page);
+
+			frame.pages.push_back((Byte) page);
+			frame.data.insert(frame.data.end(), data, data + MAX_PAGE_SIZE);
+		}
+	}
+
+	// the next delta holds the pages written from now on
+	_cpu->ClearDirtyPages();
+
+	_framesSinceKeyframe = frame.keyframe ? 0 : _framesSinceKeyframe + 1;
+
+	_size += GetFrameSize(frame);
+	_frames.push_back(std::move(frame));
+
+	while (_size > _maxBytes) {
+		size_t const before = _size;
+
+		DropOldest();
+
+		// the current keyframe is always kept
+		if (_size == before) break;
+	}
+
+	_nextCapture = _cpu->GetCycles() + _frameInterval;
+}
+
+void Rewind::Restore(size_t index) {
+	size_t keyframe = index;
+	while (!_frames[keyframe].keyframe) {
+		keyframe--;
+	}
+
+	for (size_t i = keyframe; i <= index; i++) {
+		Frame const& frame = _frames[i];
+
+		for (size_t j = 0; j < frame.pages.size(); j++) {
+			_cpu->SetPage(frame.pages[j], &frame.data[j * MAX_PAGE_SIZE]);
+		}
+	}
+
+	// memory is the frame's again, nothing was written since
+	_cpu->ClearDirtyPages();
+	_cpu->SetState(_frames[index].state);
+
+	// frames after the restored one describe a future which is about to be executed again
+	while (_frames.size() > index + 1) {
+		_size -= GetFrameSize(_frames.back());
+		_frames.pop_back();
+	}
+
+	_framesSinceKeyframe = index - keyframe;
+	_nextCapture = _frames[index].state.cycles + _frameInterval;
+}
+
+void Rewind::DropOldest() {
+	// the oldest keyframe can only go with its deltas, once a newer keyframe exists
+	size_t next = 1;
+	while (next < _frames.size() && !_frames[next].keyframe) {
+		next++;
+	}
+
+	if (next == _frames.size()) {
+		return;
+	}
+
+	for (size_t i = 0; i < next; i++) {
+		_size -= GetFrameSize(_frames.front());
+		_frames.pop_front();
+	}
+}
+
+size_t Rewind::GetFrameSize(Frame const& frame) const {
+	return sizeof(Frame) + frame.pages.size() + frame.data.size();
+}
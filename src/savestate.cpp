@@ -0,0 +1,321 @@
+#include "savestate.hpp"
+
+#include <fstream>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static char const SAVESTATE_MAGIC[] = "6502SAV";
+
+constexpr size_t SAVESTATE_STATE_OFFSET = 0x0010;
+constexpr size_t SAVESTATE_STATE_SIZE   = 0x0028;
+constexpr size_t SAVESTATE_VARIANT_OFFSET = 0x0038;
+constexpr size_t SAVESTATE_PAGES_OFFSET = 0x0040;
+constexpr size_t SAVESTATE_DATA_OFFSET  = 0x0500;
+
+static void Put16(std::vector<Byte>& out, size_t offset, Word value) {
+	out[offset]     = (Byte) value;
+	out[offset + 1] = (Byte)(value >> 8);
+}
+
+static void Put32(std::vector<Byte>& out, size_t offset, uint32_t value) {
+	for (int i = 0; i < 4; i++) out[offset + i] = (Byte)(value >> (8 * i));
+}
+
+static void Put64(std::vector<Byte>& out, size_t offset, uint64_t value) {
+	for (int i = 0; i < 8; i++) out[offset + i] = (Byte)(value >> (8 * i));
+}
+
+static Word Get16(Byte const* in) {
+	return (Word)(in[0] | (in[1] << 8));
+}
+
+static uint32_t Get32(Byte const* in) {
+	uint32_t value = 0;
+	for (int i = 0; i < 4; i++) value |= (uint32_t)(in[i]) << (8 * i);
+	return value;
+}
+
+static uint64_t Get64(Byte const* in) {
+	uint64_t value = 0;
+	for (int i = 0; i < 8; i++) value |= (uint64_t)(in[i]) << (8 * i);
+	return value;
+}
+
+static void WriteState(std::vector<Byte>& out, CPUState const& state) {
+	size_t const o = SAVESTATE_STATE_OFFSET;
+
+	out[o + 0x00] = (Byte) state.readWrite;
+	out[o + 0x01] = state.dataBus;
+	Put16(out, o + 0x02, state.addressBus);
+	out[o + 0x04] = (Byte) state.irqLine;
+	out[o + 0x05] = (Byte) state.nmiPending;
+
+	out[o + 0x06] = state.accumulator;
+	out[o + 0x07] = state.indexX;
+	out[o + 0x08] = state.indexY;
+	out[o + 0x09] = state.statusFlags;
+	out[o + 0x0A] = state.stackPointer;
+	Put16(out, o + 0x0C, state.programCounter);
+
+	Put64(out, o + 0x10, state.cycles);
+	Put64(out, o + 0x18, state.instructions);
+	Put64(out, o + 0x20, state.interrupts);
+}
+
+static CPUState ReadState(Byte const* in) {
+	CPUState state;
+
+	state.readWrite      = in[0x00] != 0;
+	state.dataBus        = in[0x01];
+	state.addressBus     = Get16(in + 0x02);
+	state.irqLine        = in[0x04] != 0;
+	state.nmiPending     = in[0x05] != 0;
+
+	state.accumulator    = in[0x06];
+	state.indexX         = in[0x07];
+	state.indexY         = in[0x08];
+	state.statusFlags    = in[0x09];
+	state.stackPointer   = in[0x0A];
+	state.programCounter = Get16(in + 0x0C);
+
+	state.cycles         = Get64(in + 0x10);
+	state.instructions   = Get64(in + 0x18);
+	state.interrupts     = Get64(in + 0x20);
+
+	return state;
+}
+
+template <typename Variant, typename Bus>
+bool SaveState(BasicCPU<Variant, Bus> const& cpu, std::string filepath, std::type_identity_t<BasicCPU<Variant, Bus>> const* base) {
+	std::vector<Byte> out(SAVESTATE_DATA_OFFSET, 0x00);
+
+	std::memcpy(out.data(), SAVESTATE_MAGIC, sizeof(SAVESTATE_MAGIC) - 1);
+	out[sizeof(SAVESTATE_MAGIC) - 1] = SAVESTATE_VERSION;
+
+	Put32(out, 0x0008, (base != nullptr) ? SAVESTATE_FLAG_BASE : 0);
+
+	WriteState(out, cpu.GetState());
+	out[SAVESTATE_VARIANT_OFFSET] = SAVESTATE_VARIANT<Variant>;
+
+	uint32_t stored = 0;
+
+	for (int page = 0; page < MAX_PAGES; page++) {
+		Byte const* const data = cpu.GetPage((Byte) page);
+
+		SAVESTATE_PAGE kind = SAVESTATE_PAGE::PAGE_DATA;
+		uint32_t argument = 0;
+
+		if (base != nullptr && std::memcmp(data, base->GetPage((Byte) page), MAX_PAGE_SIZE) == 0) {
+			kind = SAVESTATE_PAGE::PAGE_BASE;
+		}
+
+		else if (std::all_of(data, data + MAX_PAGE_SIZE, [data](Byte value) { return value == data[0]; })) {
+			kind = SAVESTATE_PAGE::PAGE_FILL;
+			argument = data[0];
+		}
+
+		else {
+			argument = stored++;
+			out.insert(out.end(), data, data + MAX_PAGE_SIZE);
+		}
+
+		Put32(out, SAVESTATE_PAGES_OFFSET + page * 4, ((uint32_t)(kind) << 24) | argument);
+	}
+
+	// devices
+	std::vector<Device*> const devices = cpu.GetDevices();
+
+	size_t const devicesOffset = out.size();
+	Put32(out, 0x000C, (uint32_t) devicesOffset);
+
+	out.resize(out.size() + 4);
+	Put32(out, devicesOffset, (uint32_t) devices.size());
+
+	for (Device const* device : devices) {
+		std::vector<Byte> const state = device->SaveState();
+
+		size_t const offset = out.size();
+		out.resize(offset + 4);
+		Put32(out, offset, (uint32_t) state.size());
+
+		out.insert(out.end(), state.begin(), state.end());
+	}
+
+	std::ofstream save(filepath, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!save.is_open()) {
+		return false;
+	}
+
+	save.write(reinterpret_cast<char const*>(out.data()), static_cast<std::streamsize>(out.size()));
+
+	return save.good();
+}
+
+template <typename Variant, typename Bus>
+static bool LoadStateFromMemory(BasicCPU<Variant, Bus>& cpu, Byte const* in, size_t size, BasicCPU<Variant, Bus> const* base) {
+	if (size < SAVESTATE_DATA_OFFSET
+		|| std::memcmp(in, SAVESTATE_MAGIC, sizeof(SAVESTATE_MAGIC) - 1) != 0
+		|| in[sizeof(SAVESTATE_MAGIC) - 1] != SAVESTATE_VERSION
+		|| in[SAVESTATE_VARIANT_OFFSET] != SAVESTATE_VARIANT<Variant>) {
+		return false;
+	}
+
+	uint32_t const flags = Get32(in + 0x0008);
+	size_t const devicesOffset = Get32(in + 0x000C);
+
+	if (((flags & SAVESTATE_FLAG_BASE) && base == nullptr) || devicesOffset + 4 > size) {
+		return false;
+	}
+
+	// check everything before touching the CPU
+	for (int page = 0; page < MAX_PAGES; page++) {
+		uint32_t const entry = Get32(in + SAVESTATE_PAGES_OFFSET + page * 4);
+		uint32_t const argument = entry & 0xFFFFFF;
+
+		switch ((SAVESTATE_PAGE)(entry >> 24)) {
+			case SAVESTATE_PAGE::PAGE_DATA:
+				if (SAVESTATE_DATA_OFFSET + (argument + 1) * MAX_PAGE_SIZE > devicesOffset) return false;
+				break;
+
+			case SAVESTATE_PAGE::PAGE_FILL:
+				if (argument > 0xFF) return false;
+				break;
+
+			case SAVESTATE_PAGE::PAGE_BASE:
+				if (base == nullptr) return false;
+				break;
+
+			default:
+				return false;
+		}
+	}
+
+	std::vector<Device*> const devices = cpu.GetDevices();
+	std::vector<std::vector<Byte>> states;
+
+	size_t offset = devicesOffset + 4;
+
+	if (Get32(in + devicesOffset) != devices.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < devices.size(); i++) {
+		if (offset + 4 > size) return false;
+
+		size_t const stateSize = Get32(in + offset);
+		offset += 4;
+
+		if (offset + stateSize > size) return false;
+
+		states.emplace_back(in + offset, in + offset + stateSize);
+		offset += stateSize;
+	}
+
+	// devices may still reject their state : load them first, and put back the previous states on failure
+	std::vector<std::vector<Byte>> previous;
+
+	for (Device const* device : devices) {
+		previous.push_back(device->SaveState());
+	}
+
+	for (size_t i = 0; i < devices.size(); i++) {
+		if (!devices[i]->LoadState(states[i])) {
+			for (size_t j = 0; j < i; j++) {
+				devices[j]->LoadState(previous[j]);
+			}
+
+			return false;
+		}
+	}
+
+	Byte fill[MAX_PAGE_SIZE];
+
+	for (int page = 0; page < MAX_PAGES; page++) {
+		uint32_t const entry = Get32(in + SAVESTATE_PAGES_OFFSET + page * 4);
+		uint32_t const argument = entry & 0xFFFFFF;
+
+		switch ((SAVESTATE_PAGE)(entry >> 24)) {
+			case SAVESTATE_PAGE::PAGE_DATA:
+				cpu.SetPage((Byte) page, in + SAVESTATE_DATA_OFFSET + argument * MAX_PAGE_SIZE);
+				break;
+
+			case SAVESTATE_PAGE::PAGE_FILL:
+				std::memset(fill, (int) argument, MAX_PAGE_SIZE);
+				cpu.SetPage((Byte) page, fill);
+				break;
+
+			case SAVESTATE_PAGE::PAGE_BASE:
+				cpu.SetPage((Byte) page, base->GetPage((Byte) page));
+				break;
+		}
+	}
+
+	cpu.SetState(ReadState(in + SAVESTATE_STATE_OFFSET));
+
+	return true;
+}
+
+template <typename Variant, typename Bus>
+bool LoadState(BasicCPU<Variant, Bus>& cpu, std::string filepath, std::type_identity_t<BasicCPU<Variant, Bus>> const* base) {
+#ifndef _WIN32
+	int const fd = open(filepath.c_str(), O_RDONLY);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	size_t const size = (size_t) info.st_size;
+	void* const mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (mapped == MAP_FAILED) {
+		return false;
+	}
+
+	bool const loaded = LoadStateFromMemory(cpu, static_cast<Byte const*>(mapped), size, base);
+
+	munmap(mapped, size);
+
+	return loaded;
+#else
+	std::ifstream save(filepath, std::ios::in | std::ios::binary | std::ios::ate);
+
+	if (!save.is_open()) {
+		return false;
+	}
+
+	std::vector<Byte> in((size_t) save.tellg());
+	save.seekg(0, std::ios::beg);
+	save.read(reinterpret_cast<char*>(in.data()), static_cast<std::streamsize>(in.size()));
+
+	return save.good() && LoadStateFromMemory(cpu, in.data(), in.size(), base);
+#endif
+}
+
+template bool SaveState(BasicCPU<MOS6502, InstructionStepped> const&, std::string, BasicCPU<MOS6502, InstructionStepped> const*);
+template bool SaveState(BasicCPU<MOS6502, CycleStepped> const&, std::string, BasicCPU<MOS6502, CycleStepped> const*);
+template bool SaveState(BasicCPU<MOS6502Undocumented, InstructionStepped> const&, std::string, BasicCPU<MOS6502Undocumented, InstructionStepped> const*);
+template bool SaveState(BasicCPU<MOS6502Undocumented, CycleStepped> const&, std::string, BasicCPU<MOS6502Undocumented, CycleStepped> const*);
+template bool SaveState(BasicCPU<CMOS65C02, InstructionStepped> const&, std::string, BasicCPU<CMOS65C02, InstructionStepped> const*);
+template bool SaveState(BasicCPU<CMOS65C02, CycleStepped> const&, std::string, BasicCPU<CMOS65C02, CycleStepped> const*);
+
+template bool LoadState(BasicCPU<MOS6502, InstructionStepped>&, std::string, BasicCPU<MOS6502, InstructionStepped> const*);
+template bool LoadState(BasicCPU<MOS6502, CycleStepped>&, std::string, BasicCPU<MOS6502, CycleStepped> const*);
+template bool LoadState(BasicCPU<MOS6502Undocumented, InstructionStepped>&, std::string, BasicCPU<MOS6502Undocumented, InstructionStepped> const*);
+template bool LoadState(BasicCPU<MOS6502Undocumented, CycleStepped>&, std::string, BasicCPU<MOS6502Undocumented, CycleStepped> const*);
+template bool LoadState(BasicCPU<CMOS65C02, InstructionStepped>&, std::string, BasicCPU<CMOS65C02, InstructionStepped> const*);
+template bool LoadState(BasicCPU<CMOS65C02, CycleStepped>&, std::string, BasicCPU<CMOS65C02, CycleStepped> const*);
@@ -0,0 +1,15 @@
+#include "steps.hpp"
+
+template <typename Variant, typename Bus>
+StepGenerator BasicCPU<Variant, Bus>::Steps() {
+	while (!_busCycles.empty() || _map[GetBigEndianAddress(_programCounter)] != 0x00) {
+		co_yield Tick();
+	}
+}
+
+template StepGenerator BasicCPU<MOS6502, InstructionStepped>::Steps();
+template StepGenerator BasicCPU<MOS6502, CycleStepped>::Steps();
+template StepGenerator BasicCPU<MOS6502Undocumented, InstructionStepped>::Steps();
+template StepGenerator BasicCPU<MOS6502Undocumented, CycleStepped>::Steps();
+template StepGenerator BasicCPU<CMOS65C02, InstructionStepped>::Steps();
+template StepGenerator BasicCPU<CMOS65C02, CycleStepped>::Steps();
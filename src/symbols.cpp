@@ -0,0 +1,322 @@
+#include "symbols.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+
+#include "memory.hpp"
+
+// $8000, 0x8000, C:8000 (VICE), 8000 (hex) or 32768 (decimal), false if it isn't a number
+static bool ParseValue(std::string text, bool hexadecimal, long& value) {
+	if (text.size() > 2 && text[1] == ':') {
+		text = text.substr(2);
+	}
+
+	if (!text.empty() && text[0] == '$') {
+		text = text.substr(1);
+		hexadecimal = true;
+	}
+
+	else if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+		text = text.substr(2);
+		hexadecimal = true;
+	}
+
+	if (text.empty()) {
+		return false;
+	}
+
+	char* end = nullptr;
+	value = std::strtol(text.c_str(), &end, hexadecimal ? 16 : 10);
+
+	return *end == '\0';
+}
+
+static std::string Trim(std::string const& text) {
+	size_t const first = text.find_first_not_of(" \t\r");
+	size_t const last = text.find_last_not_of(" \t\r");
+
+	return (first == std::string::npos) ? "" : text.substr(first, last - first + 1);
+}
+
+bool SymbolTable::Load(std::string const& filepath) {
+	std::ifstream input(filepath);
+
+	if (!input.is_open()) {
+		return false;
+	}
+
+	std::string first;
+	std::getline(input, first);
+	input.seekg(0);
+
+	// ld65 debug files start with their version
+	if (first.rfind("version", 0) == 0) {
+		LoadDebugInfo(input);
+	}
+
+	else {
+		LoadLabels(input);
+	}
+
+	return true;
+}
+
+void SymbolTable::Add(std::string const& name, Word address, Word size) {
+	_symbols.push_back({ name, address, size });
+
+	_sorted = false;
+	_table.clear();
+}
+
+bool SymbolTable::IsEmpty() const {
+	return _symbols.empty();
+}
+
+std::vector<Symbol> const& SymbolTable::GetSymbols() const {
+	Sort();
+	return _symbols;
+}
+
+Symbol const* SymbolTable::Find(Word address) const {
+	Sort();
+
+	auto next = std::upper_bound(_symbols.begin(), _symbols.end(), address, [](Word a, Symbol const& symbol) {
+		return a < symbol.address;
+	});
+
+	if (next == _symbols.begin()) {
+		return nullptr;
+	}
+
+	// first of the symbols sharing the address
+	Word const start = std::prev(next)->address;
+	auto const symbol = std::lower_bound(_symbols.begin(), next, start, [](Symbol const& symbol, Word a) {
+		return symbol.address < a;
+	});
+
+	if (symbol->size != 0 && address >= symbol->address + symbol->size) {
+		return nullptr;
+	}
+
+	return &*symbol;
+}
+
+void SymbolTable::FindAll(Word const* addresses, size_t count, int32_t* indices) const {
+	Sort();
+
+	if (_table.empty()) {
+		_table.assign(MAX_ADDRESSABLE, -1);
+
+		for (size_t i = 0; i < _symbols.size(); i++) {
+			Symbol const& symbol = _symbols[i];
+
+			// the first of the symbols sharing an address wins
+			if (i > 0 && _symbols[i - 1].address == symbol.address) {
+				continue;
+			}
+
+			size_t end = MAX_ADDRESSABLE;
+
+			for (size_t j = i + 1; j < _symbols.size(); j++) {
+				if (_symbols[j].address != symbol.address) {
+					end = _symbols[j].address;
+					break;
+				}
+			}
+
+			if (symbol.size != 0) {
+				end = std::min<size_t>(end, symbol.address + symbol.size);
+			}
+
+			std::fill(_table.begin() + symbol.address, _table.begin() + end, (int32_t) i);
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		indices[i] = _table[addresses[i]];
+	}
+}
+
+std::string SymbolTable::Format(Word address) const {
+	Symbol const* const symbol = Find(address);
+
+	std::ostringstream text;
+	text << std::hex << std::uppercase;
+
+	if (symbol == nullptr) {
+		text << "$" << std::setfill('0') << std::setw(4) << address;
+	}
+
+	else if (symbol->address == address) {
+		text << symbol->name;
+	}
+
+	else {
+		text << symbol->name << "+$" << address - symbol->address;
+	}
+
+	return text.str();
+}
+
+std::vector<SourceLine> const& SymbolTable::GetLines() const {
+	return _lines;
+}
+
+void SymbolTable::LoadDebugInfo(std::istream& input) {
+	struct Span {
+		long segment;
+		long start; // from the segment start
+		long size;
+	};
+
+	struct Line {
+		long file;
+		long line;
+		std::string spans; // ids separated by +
+	};
+
+	std::map<long, std::string> files;
+	std::map<long, long> segments; // start of each
+	std::map<long, Span> spans;
+	std::vector<Line> lines;
+
+	std::string line;
+
+	// sym id=0,name="reset",addrsize=absolute,size=3,scope=0,def=1,val=0x8000,seg=0,type=lab
+	// line id=4,file=0,line=12,span=7
+	while (std::getline(input, line)) {
+		size_t const tab = line.find_first_of(" \t");
+
+		if (tab == std::string::npos) {
+			continue;
+		}
+
+		std::string const record = line.substr(0, tab);
+		std::map<std::string, std::string> values;
+
+		std::istringstream fields(Trim(line.substr(tab)));
+		std::string field;
+
+		while (std::getline(fields, field, ',')) {
+			size_t const equal = field.find('=');
+
+			if (equal != std::string::npos) {
+				values[field.substr(0, equal)] = field.substr(equal + 1);
+			}
+		}
+
+		auto const number = [&](char const* key, long fallback) {
+			long value = fallback;
+			return (values.count(key) != 0 && ParseValue(values[key], false, value)) ? value : fallback;
+		};
+
+		auto const text = [&](char const* key) {
+			std::string const& quoted = values[key];
+			return (quoted.size() >= 2) ? quoted.substr(1, quoted.size() - 2) : quoted;
+		};
+
+		long const id = number("id", -1);
+
+		if (record == "sym") {
+			std::string const name = text("name");
+			long const value = number("val", -1);
+
+			if (values["type"] == "lab" && !name.empty() && value >= 0 && value < MAX_ADDRESSABLE) {
+				Add(name, (Word) value, (Word) number("size", 0));
+			}
+		}
+
+		else if (record == "file") {
+			files[id] = text("name");
+		}
+
+		else if (record == "seg") {
+			segments[id] = number("start", 0);
+		}
+
+		else if (record == "span") {
+			spans[id] = { number("seg", -1), number("start", 0), number("size", 0) };
+		}
+
+		else if (record == "line" && values.count("span") != 0) {
+			lines.push_back({ number("file", -1), number("line", 0), values["span"] });
+		}
+	}
+
+	// spans and segments come after the lines referring to them
+	for (Line const& entry : lines) {
+		std::istringstream ids(entry.spans);
+		std::string id;
+
+		while (std::getline(ids, id, '+')) {
+			auto const span = spans.find(std::strtol(id.c_str(), nullptr, 10));
+
+			if (span == spans.end() || segments.count(span->second.segment) == 0) {
+				continue;
+			}
+
+			long const address = segments[span->second.segment] + span->second.start;
+
+			if (address >= 0 && address < MAX_ADDRESSABLE && span->second.size > 0) {
+				_lines.push_back({ files[entry.file], (uint32_t) entry.line, (Word) address, (Word) span->second.size });
+			}
+		}
+	}
+}
+
+void SymbolTable::LoadLabels(std::istream& input) {
+	std::string line;
+
+	while (std::getline(input, line)) {
+		line = Trim(line.substr(0, line.find_first_of(";#")));
+
+		long value = -1;
+
+		// VICE : al C:8000 .name
+		if (line.rfind("al ", 0) == 0) {
+			std::istringstream words(line.substr(3));
+			std::string address;
+			std::string name;
+
+			words >> address >> name;
+
+			if (!name.empty() && name[0] == '.') {
+				name = name.substr(1);
+			}
+
+			if (!name.empty() && ParseValue(address, true, value) && value < MAX_ADDRESSABLE) {
+				Add(name, (Word) value);
+			}
+
+			continue;
+		}
+
+		// name = $8000
+		size_t const equal = line.find('=');
+
+		if (equal == std::string::npos) {
+			continue;
+		}
+
+		std::string const name = Trim(line.substr(0, equal));
+
+		if (!name.empty() && ParseValue(Trim(line.substr(equal + 1)), false, value) && value >= 0 && value < MAX_ADDRESSABLE) {
+			Add(name, (Word) value);
+		}
+	}
+}
+
+void SymbolTable::Sort() const {
+	if (_sorted) {
+		return;
+	}
+
+	std::stable_sort(_symbols.begin(), _symbols.end(), [](Symbol const& a, Symbol const& b) {
+		return a.address < b.address;
+	});
+
+	_sorted = true;
+}
@@ -1,5 +1,7 @@
 #include "tools.hpp"
 
+#include <fstream>
+
 Word GetBigEndianAddress(Word address) {
 	Byte low = (address >> 8);
 	Byte high = (Byte) address;
@@ -12,4 +14,52 @@ Word GetLittleEndianAddress(Word address) {
 	Byte high = (address >> 8);
 
 	return (((Word) low) << 8) | (Word) high;
-}
\ No newline at end of file
+}
+
+bool LoadFile(std::vector<Byte>& data, std::string const& filepath) {
+	std::ifstream file(filepath, std::ios::in | std::ios::binary | std::ios::ate);
+
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::streampos const fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	data.resize((size_t) fileSize);
+	file.read(reinterpret_cast<char*>(data.data()), fileSize);
+
+	return !file.fail();
+}
+
+bool ParseAddress(std::string const& text, Word& address) {
+	std::string const digits = (!text.empty() && text[0] == '$') ? text.substr(1) : text;
+
+	if (digits.empty() || digits.size() > 4) {
+		return false;
+	}
+
+	unsigned int value = 0;
+
+	for (char const digit : digits) {
+		if (digit >= '0' && digit <= '9') {
+			value = (value << 4) | (unsigned int)(digit - '0');
+		}
+
+		else if (digit >= 'a' && digit <= 'f') {
+			value = (value << 4) | (unsigned int)(digit - 'a' + 10);
+		}
+
+		else if (digit >= 'A' && digit <= 'F') {
+			value = (value << 4) | (unsigned int)(digit - 'A' + 10);
+		}
+
+		else {
+			return false;
+		}
+	}
+
+	address = (Word) value;
+
+	return true;
+}
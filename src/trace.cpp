@@ -0,0 +1,204 @@
+#include "trace.hpp"
+
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+static char const TRACE_MAGIC[7] = { '6', '5', '0', '2', 'T', 'R', 'C' };
+
+TraceWriter::TraceWriter(CPU* cpu, std::ostream* output) {
+	_cpu = cpu;
+	_output = output;
+
+	_output->write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+	_output->put((char) TRACE_VERSION);
+}
+
+void TraceWriter::Step() {
+	CPUState const state = _cpu->GetState();
+	Word const pc = state.programCounter;
+
+	TraceRecord record = {};
+	record.cycles = state.cycles;
+	record.programCounter = pc;
+	record.accumulator = state.accumulator;
+	record.indexX = state.indexX;
+	record.indexY = state.indexY;
+	record.stackPointer = state.stackPointer;
+	record.statusFlags = state.statusFlags;
+	record.interrupt = _cpu->IsInterruptPending();
+
+	for (Word i = 0; i < 3; i++) {
+		Word const address = (Word)(pc + i);
+		record.bytes[i] = _cpu->GetPage(address >> 8)[address & 0xFF];
+	}
+
+	_output->write((char const*) &record, sizeof(record));
+
+	_cpu->Step();
+}
+
+uint64_t TraceWriter::Run(uint64_t cycles) {
+	return _cpu->RunCycles(cycles, [this]() { Step(); });
+}
+
+TraceFile::~TraceFile() {
+	Close();
+}
+
+bool TraceFile::Open(std::string const& filepath) {
+	Close();
+
+#ifndef _WIN32
+	int const file = open(filepath.c_str(), O_RDONLY);
+
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat status;
+
+	if (fstat(file, &status) != 0 || (size_t) status.st_size < TRACE_HEADER_SIZE) {
+		close(file);
+		return false;
+	}
+
+	_size = (size_t) status.st_size;
+	_data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+
+	if (_data == MAP_FAILED) {
+		_data = nullptr;
+		return false;
+	}
+
+	// read once front to back
+	madvise(_data, _size, MADV_SEQUENTIAL);
+#else
+	HANDLE const file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(file, &size) || (size_t) size.QuadPart < TRACE_HEADER_SIZE) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+
+	if (mapping == nullptr) {
+		return false;
+	}
+
+	_size = (size_t) size.QuadPart;
+	_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+
+	if (_data == nullptr) {
+		return false;
+	}
+#endif
+
+	Byte const* const header = (Byte const*) _data;
+
+	if (std::memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header[sizeof(TRACE_MAGIC)] != TRACE_VERSION) {
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+TraceRecord const* TraceFile::GetRecords() const {
+	return (TraceRecord const*)((Byte const*) _data + TRACE_HEADER_SIZE);
+}
+
+size_t TraceFile::GetCount() const {
+	return (_data == nullptr) ? 0 : (_size - TRACE_HEADER_SIZE) / sizeof(TraceRecord);
+}
+
+void TraceFile::Close() {
+	if (_data == nullptr) {
+		return;
+	}
+
+#ifndef _WIN32
+	munmap(_data, _size);
+#else
+	UnmapViewOfFile(_data);
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+size_t FindFirstDifference(void const* a, void const* b, size_t size) {
+	Byte const* const left = (Byte const*) a;
+	Byte const* const right = (Byte const*) b;
+
+	size_t offset = 0;
+
+	// 64 bytes a turn until a block differs
+#if defined(__AVX2__)
+	for (; offset + 64 <= size; offset += 64) {
+		__m256i const low = _mm256_xor_si256(_mm256_loadu_si256((__m256i const*)(left + offset)), _mm256_loadu_si256((__m256i const*)(right + offset)));
+		__m256i const high = _mm256_xor_si256(_mm256_loadu_si256((__m256i const*)(left + offset + 32)), _mm256_loadu_si256((__m256i const*)(right + offset + 32)));
+		__m256i const differences = _mm256_or_si256(low, high);
+
+		if (!_mm256_testz_si256(differences, differences)) {
+			break;
+		}
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	for (; offset + 64 <= size; offset += 64) {
+		__m128i equal = _mm_set1_epi8(-1);
+
+		for (size_t i = 0; i < 64; i += 16) {
+			__m128i const x = _mm_loadu_si128((__m128i const*)(left + offset + i));
+			__m128i const y = _mm_loadu_si128((__m128i const*)(right + offset + i));
+			equal = _mm_and_si128(equal, _mm_cmpeq_epi8(x, y));
+		}
+
+		if (_mm_movemask_epi8(equal) != 0xFFFF) {
+			break;
+		}
+	}
+#endif
+
+	// then by words and bytes, for the tail and inside the differing block
+	for (; offset + 8 <= size; offset += 8) {
+		uint64_t x;
+		uint64_t y;
+
+		std::memcpy(&x, left + offset, 8);
+		std::memcpy(&y, right + offset, 8);
+
+		if (x != y) {
+			break;
+		}
+	}
+
+	for (; offset < size; offset++) {
+		if (left[offset] != right[offset]) {
+			return offset;
+		}
+	}
+
+	return size;
+}
@@ -0,0 +1,581 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <filesystem>
+#include <algorithm>
+
+#include "cpu.hpp"
+#include "opcodes.hpp"
+
+// conformance <file.json | directory>... [--variant 6502|6502u|65c02] [--bus] [--threads <n>] [--verbose]
+// Runs single-step test vectors in the ProcessorTests JSON format (one array of cases per file, each with the
+// initial and final registers and RAM and the bus cycles) and reports the mismatches by opcode
+// --bus also compares the bus cycles (address, value, read/write) with the bus log of the cycle-stepped CPU, in the order of
+// its handlers (see CycleStepped), the cycles it has no access for are only counted. Otherwise only the count is compared
+// Exits with 0 if every case passes, 1 if some fail, 2 on errors
+
+struct TestState {
+	Word pc;
+	Byte s, a, x, y, p;
+	std::vector<std::pair<Word, Byte>> ram; // address, value
+};
+
+struct TestCycle {
+	Word address;
+	Byte value;
+	bool read;
+};
+
+struct TestCase {
+	std::string_view name;
+	TestState initial;
+	TestState final;
+	std::vector<TestCycle> cycles;
+};
+
+// Forward only reader over a whole file, no document is built : cases are decoded one after the other into
+// the same TestCase, whose vectors keep their capacity
+class JsonCursor {
+	public:
+		JsonCursor(char const* begin, char const* end) : _p(begin), _end(end) {}
+
+		bool Consume(char c) {
+			Skip();
+
+			if (_p != _end && *_p == c) {
+				_p++;
+				return true;
+			}
+
+			return false;
+		}
+
+		bool ReadString(std::string_view& text) {
+			if (!Consume('"')) {
+				return false;
+			}
+
+			char const* const start = _p;
+
+			while (_p != _end && *_p != '"') {
+				_p += (*_p == '\\' && _p + 1 != _end) ? 2 : 1;
+			}
+
+			if (_p == _end) {
+				return false;
+			}
+
+			text = std::string_view(start, _p - start);
+			_p++;
+
+			return true;
+		}
+
+		bool ReadNumber(long& value) {
+			Skip();
+
+			bool const negative = (_p != _end && *_p == '-');
+			_p += negative;
+
+			if (_p == _end || *_p < '0' || *_p > '9') {
+				return false;
+			}
+
+			value = 0;
+			while (_p != _end && *_p >= '0' && *_p <= '9') {
+				value = value * 10 + (*_p++ - '0');
+			}
+
+			value = negative ? -value : value;
+
+			return true;
+		}
+
+		// Any value, for the keys not used
+		bool SkipValue() {
+			Skip();
+
+			if (_p == _end) {
+				return false;
+			}
+
+			if (*_p == '"') {
+				std::string_view text;
+				return ReadString(text);
+			}
+
+			if (*_p == '{' || *_p == '[') {
+				int depth = 0;
+
+				do {
+					if (*_p == '"') {
+						std::string_view text;
+
+						if (!ReadString(text)) {
+							return false;
+						}
+
+						continue;
+					}
+
+					depth += (*_p == '{' || *_p == '[') - (*_p == '}' || *_p == ']');
+					_p++;
+				} while (_p != _end && depth > 0);
+
+				return depth == 0;
+			}
+
+			// number, true, false, null
+			while (_p != _end && *_p != ',' && *_p != '}' && *_p != ']' && *_p != ' ' && *_p != '\n' && *_p != '\r' && *_p != '\t') {
+				_p++;
+			}
+
+			return true;
+		}
+
+	private:
+		void Skip() {
+			while (_p != _end && (*_p == ' ' || *_p == '\n' || *_p == '\r' || *_p == '\t')) {
+				_p++;
+			}
+		}
+
+	private:
+		char const* _p;
+		char const* _end;
+};
+
+bool ReadState(JsonCursor& json, TestState& state) {
+	state.ram.clear();
+
+	if (!json.Consume('{')) {
+		return false;
+	}
+
+	do {
+		std::string_view key;
+		long value = 0;
+
+		if (!json.ReadString(key) || !json.Consume(':')) {
+			return false;
+		}
+
+		if (key == "ram") {
+			if (!json.Consume('[')) {
+				return false;
+			}
+
+			if (!json.Consume(']')) {
+				do {
+					long address = 0;
+
+					if (!json.Consume('[') || !json.ReadNumber(address) || !json.Consume(',') || !json.ReadNumber(value) || !json.Consume(']')) {
+						return false;
+					}
+
+					state.ram.push_back({ (Word) address, (Byte) value });
+				} while (json.Consume(','));
+
+				if (!json.Consume(']')) {
+					return false;
+				}
+			}
+		}
+
+		else if (key == "pc" || key == "s" || key == "a" || key == "x" || key == "y" || key == "p") {
+			if (!json.ReadNumber(value)) {
+				return false;
+			}
+
+			switch (key[0]) {
+				case 'p': if (key.size() == 2) state.pc = (Word) value; else state.p = (Byte) value; break;
+				case 's': state.s = (Byte) value; break;
+				case 'a': state.a = (Byte) value; break;
+				case 'x': state.x = (Byte) value; break;
+				case 'y': state.y = (Byte) value; break;
+			}
+		}
+
+		else if (!json.SkipValue()) {
+			return false;
+		}
+	} while (json.Consume(','));
+
+	return json.Consume('}');
+}
+
+bool ReadCase(JsonCursor& json, TestCase& test) {
+	test.cycles.clear();
+
+	if (!json.Consume('{')) {
+		return false;
+	}
+
+	do {
+		std::string_view key;
+
+		if (!json.ReadString(key) || !json.Consume(':')) {
+			return false;
+		}
+
+		if (key == "name") {
+			if (!json.ReadString(test.name)) {
+				return false;
+			}
+		}
+
+		else if (key == "initial" || key == "final") {
+			if (!ReadState(json, key == "initial" ? test.initial : test.final)) {
+				return false;
+			}
+		}
+
+		else if (key == "cycles") {
+			if (!json.Consume('[')) {
+				return false;
+			}
+
+			if (!json.Consume(']')) {
+				do {
+					long address = 0;
+					long value = 0;
+					std::string_view kind;
+
+					if (!json.Consume('[') || !json.ReadNumber(address) || !json.Consume(',') || !json.ReadNumber(value) || !json.Consume(',')
+						|| !json.ReadString(kind) || !json.Consume(']')) {
+						return false;
+					}
+
+					test.cycles.push_back({ (Word) address, (Byte) value, kind == "read" });
+				} while (json.Consume(','));
+
+				if (!json.Consume(']')) {
+					return false;
+				}
+			}
+		}
+
+		else if (!json.SkipValue()) {
+			return false;
+		}
+	} while (json.Consume(','));
+
+	return json.Consume('}');
+}
+
+struct OpcodeResult {
+	uint64_t cases = 0;
+	uint64_t failed = 0;
+	uint64_t registers = 0; // failures by kind, a case can have several
+	uint64_t memory = 0;
+	uint64_t cycles = 0;
+
+	std::string firstFailure;
+};
+
+struct Options {
+	bool bus = false;
+	bool verbose = false;
+};
+
+// Counts the case and its mismatches in result, returns their description (empty if it passes)
+template <typename Variant, typename Bus>
+std::string RunCase(BasicCPU<Variant, Bus>& cpu, TestCase const& test, Options const& options, OpcodeResult& result) {
+	// previous case undone
+	cpu.Reset();
+
+	for (auto const& [address, value] : test.initial.ram) {
+		cpu.GetWritablePage(address >> 8)[address & 0xFF] = value;
+	}
+
+	CPUState state = cpu.GetState();
+	state.programCounter = test.initial.pc;
+	state.stackPointer = test.initial.s;
+	state.accumulator = test.initial.a;
+	state.indexX = test.initial.x;
+	state.indexY = test.initial.y;
+	state.statusFlags = test.initial.p;
+	state.irqLine = false;
+	state.nmiPending = false;
+	state.cycles = 0;
+	state.instructions = 0;
+	cpu.SetState(state);
+
+	std::vector<BusState> bus;
+
+	if constexpr (Bus::CYCLE_STEPPED) {
+		do {
+			bus.push_back(cpu.Tick());
+		} while (bus.size() < cpu.GetCycles());
+	}
+
+	else {
+		cpu.Step();
+	}
+
+	std::ostringstream errors;
+	errors << std::hex << std::uppercase << std::setfill('0');
+
+	CPUState const final = cpu.GetState();
+
+	auto const compare = [&](char const* name, int actual, int expected, int width) {
+		if (actual != expected) {
+			errors << " " << name << " $" << std::setw(width) << actual << " (expected $" << std::setw(width) << expected << ")";
+		}
+	};
+
+	compare("PC", final.programCounter, test.final.pc, 4);
+	compare("S", final.stackPointer, test.final.s, 2);
+	compare("A", final.accumulator, test.final.a, 2);
+	compare("X", final.indexX, test.final.x, 2);
+	compare("Y", final.indexY, test.final.y, 2);
+	compare("P", final.statusFlags, test.final.p, 2);
+
+	bool const registers = !errors.str().empty();
+	size_t const registerErrors = errors.str().size();
+
+	for (auto const& [address, value] : test.final.ram) {
+		Byte const actual = cpu.GetPage(address >> 8)[address & 0xFF];
+
+		if (actual != value) {
+			errors << " [$" << std::setw(4) << address << "] $" << std::setw(2) << (int) actual << " (expected $" << std::setw(2) << (int) value << ")";
+		}
+	}
+
+	bool const memory = errors.str().size() != registerErrors;
+	size_t const memoryErrors = errors.str().size();
+
+	if (cpu.GetCycles() != test.cycles.size()) {
+		errors << std::dec << " " << cpu.GetCycles() << " cycles (expected " << test.cycles.size() << ")" << std::hex;
+	}
+
+	else if (options.bus) {
+		for (size_t i = 0; i < test.cycles.size(); i++) {
+			TestCycle const& expected = test.cycles[i];
+
+			if (bus[i].access && (bus[i].addressBus != expected.address || bus[i].dataBus != expected.value || bus[i].readWrite != expected.read)) {
+				errors << std::dec << " cycle " << i << std::hex << " $" << std::setw(4) << bus[i].addressBus << " $" << std::setw(2) << (int) bus[i].dataBus
+					<< (bus[i].readWrite ? " read" : " write") << " (expected $" << std::setw(4) << expected.address << " $" << std::setw(2) << (int) expected.value
+					<< (expected.read ? " read)" : " write)");
+				break;
+			}
+		}
+	}
+
+	bool const cycles = errors.str().size() != memoryErrors;
+
+	result.cases++;
+
+	if (!registers && !memory && !cycles) {
+		return "";
+	}
+
+	result.failed++;
+	result.registers += registers;
+	result.memory += memory;
+	result.cycles += cycles;
+
+	return std::string(test.name) + " :" + errors.str();
+}
+
+// One file after the other from the shared list, results kept per worker
+template <typename Processor>
+void RunWorker(std::vector<std::filesystem::path> const& files, std::atomic<size_t>& next, Options const& options,
+	std::array<OpcodeResult, 0x100>& results, std::mutex& errorsLock) {
+
+	std::vector<Byte> ram(MAX_RAM_SIZE, 0x00);
+	std::vector<Byte> rom(MAX_ROM_SIZE, 0x00);
+
+	Processor cpu(&ram, 0x0000, MAX_RAM_SIZE, &rom, 0x8000, MAX_ROM_SIZE);
+	cpu.SetTraceOutput(nullptr);
+
+	TestCase test;
+	std::string contents;
+
+	for (size_t index = next++; index < files.size(); index = next++) {
+		std::ifstream input(files[index], std::ios::binary);
+		contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+		JsonCursor json(contents.data(), contents.data() + contents.size());
+		bool valid = json.Consume('[');
+
+		if (valid && !json.Consume(']')) {
+			do {
+				if (!ReadCase(json, test)) {
+					valid = false;
+					break;
+				}
+
+				// the opcode is the byte at the initial PC
+				Byte opcode = 0x00;
+				for (auto const& [address, value] : test.initial.ram) {
+					if (address == test.initial.pc) {
+						opcode = value;
+					}
+				}
+
+				OpcodeResult& result = results[opcode];
+				std::string const failure = RunCase(cpu, test, options, result);
+
+				if (!failure.empty()) {
+					if (result.firstFailure.empty()) {
+						result.firstFailure = failure;
+					}
+
+					if (options.verbose) {
+						std::lock_guard<std::mutex> lock(errorsLock);
+						std::cerr << failure << std::endl;
+					}
+				}
+			} while (json.Consume(','));
+
+			valid = valid && json.Consume(']');
+		}
+
+		if (!valid) {
+			std::lock_guard<std::mutex> lock(errorsLock);
+			std::cerr << "malformed " << files[index].string() << std::endl;
+		}
+	}
+}
+
+template <typename Variant, typename Bus>
+std::array<OpcodeResult, 0x100> RunAll(std::vector<std::filesystem::path> const& files, Options const& options, unsigned threads) {
+	std::vector<std::array<OpcodeResult, 0x100>> results(threads);
+	std::vector<std::thread> workers;
+	std::atomic<size_t> next = 0;
+	std::mutex errorsLock;
+
+	for (unsigned i = 0; i < threads; i++) {
+		workers.emplace_back(RunWorker<BasicCPU<Variant, Bus>>, std::cref(files), std::ref(next), std::cref(options), std::ref(results[i]), std::ref(errorsLock));
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	std::array<OpcodeResult, 0x100> total;
+
+	for (auto const& result : results) {
+		for (size_t opcode = 0; opcode < 0x100; opcode++) {
+			total[opcode].cases += result[opcode].cases;
+			total[opcode].failed += result[opcode].failed;
+			total[opcode].registers += result[opcode].registers;
+			total[opcode].memory += result[opcode].memory;
+			total[opcode].cycles += result[opcode].cycles;
+
+			if (total[opcode].firstFailure.empty()) {
+				total[opcode].firstFailure = result[opcode].firstFailure;
+			}
+		}
+	}
+
+	return total;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage : " << argv[0] << " <file.json | directory>... [--variant 6502|6502u|65c02] [--bus] [--threads <n>] [--verbose]" << std::endl;
+		return 2;
+	}
+
+	std::vector<std::filesystem::path> files;
+	std::string variant = "6502";
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	Options options;
+
+	for (int i = 1; i < argc; i++) {
+		std::string const option = argv[i];
+
+		if (option == "--variant" && i + 1 < argc) {
+			variant = argv[++i];
+		}
+
+		else if (option == "--threads" && i + 1 < argc) {
+			threads = std::max(1, std::stoi(argv[++i]));
+		}
+
+		else if (option == "--bus") {
+			options.bus = true;
+		}
+
+		else if (option == "--verbose") {
+			options.verbose = true;
+		}
+
+		else if (std::filesystem::is_directory(option)) {
+			for (auto const& entry : std::filesystem::directory_iterator(option)) {
+				if (entry.path().extension() == ".json") {
+					files.push_back(entry.path());
+				}
+			}
+		}
+
+		else if (std::filesystem::exists(option)) {
+			files.push_back(option);
+		}
+
+		else {
+			std::cerr << "can't find " << option << std::endl;
+			return 2;
+		}
+	}
+
+	// largest first, for a balanced end of run
+	std::sort(files.begin(), files.end(), [](auto const& a, auto const& b) {
+		return std::filesystem::file_size(a) > std::filesystem::file_size(b);
+	});
+
+	std::array<OpcodeResult, 0x100> results;
+
+	if (files.empty()) {
+		std::cerr << "no test files" << std::endl;
+		return 2;
+	}
+
+	if (variant == "6502")       results = options.bus ? RunAll<MOS6502, CycleStepped>(files, options, threads) : RunAll<MOS6502, InstructionStepped>(files, options, threads);
+	else if (variant == "6502u") results = options.bus ? RunAll<MOS6502Undocumented, CycleStepped>(files, options, threads) : RunAll<MOS6502Undocumented, InstructionStepped>(files, options, threads);
+	else if (variant == "65c02") results = options.bus ? RunAll<CMOS65C02, CycleStepped>(files, options, threads) : RunAll<CMOS65C02, InstructionStepped>(files, options, threads);
+
+	else {
+		std::cerr << "unknown variant " << variant << std::endl;
+		return 2;
+	}
+
+	uint64_t cases = 0;
+	uint64_t failed = 0;
+
+	for (size_t opcode = 0; opcode < 0x100; opcode++) {
+		OpcodeResult const& result = results[opcode];
+
+		if (result.cases == 0) {
+			continue;
+		}
+
+		cases += result.cases;
+		failed += result.failed;
+
+		if (result.failed == 0) {
+			continue;
+		}
+
+		std::string const name = (*GetOpcodes(variant))[opcode].name;
+
+		std::cout << "$" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << opcode << std::dec << std::setfill(' ')
+			<< " " << std::left << std::setw(4) << name << std::right << std::setw(8) << result.failed << " / " << std::left << std::setw(8) << result.cases << std::right
+			<< " registers " << std::setw(6) << result.registers << " memory " << std::setw(6) << result.memory << " cycles " << std::setw(6) << result.cycles
+			<< "  " << result.firstFailure << std::endl;
+	}
+
+	std::cout << (cases - failed) << " / " << cases << " cases passed" << std::endl;
+
+	return (failed == 0) ? 0 : 1;
+}
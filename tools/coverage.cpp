@@ -0,0 +1,116 @@
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "coverage.hpp"
+#include "symbols.hpp"
+#include "tools.hpp"
+
+// coverage <run.cov>... [--merge <merged.cov>] [--lcov <debug.dbg> <rom> [--start $8000] [--variant 6502|6502u|65c02]] [--test <name>]
+// ORs the bitmaps of the runs, saves the result and/or prints it as a lcov tracefile
+// The ROM is mapped so it ends at $FFFF unless --start is given
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage : " << argv[0] << " <run.cov>... [--merge <merged.cov>] [--lcov <debug.dbg> <rom> [--start $8000] [--variant 6502|6502u|65c02]] [--test <name>]" << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> runs;
+	std::string merged;
+	std::string debugInfo;
+	std::string romPath;
+	std::string testName;
+	bool hasStart = false;
+	Word romStart = 0x0000;
+	OpcodeTable const* opcodes = &GetOpcodes<MOS6502>();
+
+	for (int i = 1; i < argc; i++) {
+		std::string const option = argv[i];
+
+		if (option == "--merge" && i + 1 < argc) {
+			merged = argv[++i];
+		}
+
+		else if (option == "--lcov" && i + 2 < argc) {
+			debugInfo = argv[++i];
+			romPath = argv[++i];
+		}
+
+		else if (option == "--start" && i + 1 < argc) {
+			if (!ParseAddress(argv[++i], romStart)) {
+				std::cerr << "bad address " << argv[i] << std::endl;
+				return 1;
+			}
+
+			hasStart = true;
+		}
+
+		else if (option == "--variant" && i + 1 < argc) {
+			opcodes = GetOpcodes(argv[++i]);
+
+			if (opcodes == nullptr) {
+				std::cerr << "unknown variant " << argv[i] << std::endl;
+				return 1;
+			}
+		}
+
+		else if (option == "--test" && i + 1 < argc) {
+			testName = argv[++i];
+		}
+
+		else {
+			runs.push_back(option);
+		}
+	}
+
+	Coverage total;
+
+	for (std::string const& run : runs) {
+		Coverage coverage;
+
+		if (!coverage.Load(run)) {
+			std::cerr << "can't load " << run << std::endl;
+			return 1;
+		}
+
+		total.Merge(coverage);
+	}
+
+	std::cerr << runs.size() << " run(s), " << total.Count(COVERAGE_BIT::EXECUTED) << " instructions executed, "
+		<< total.Count(COVERAGE_BIT::TAKEN) << " branches taken, " << total.Count(COVERAGE_BIT::NOT_TAKEN) << " branches not taken" << std::endl;
+
+	if (!merged.empty() && !total.Save(merged)) {
+		std::cerr << "can't save " << merged << std::endl;
+		return 1;
+	}
+
+	if (!debugInfo.empty()) {
+		SymbolTable symbols;
+		std::vector<Byte> rom;
+
+		if (!symbols.Load(debugInfo)) {
+			std::cerr << "can't load " << debugInfo << std::endl;
+			return 1;
+		}
+
+		if (!LoadFile(rom, romPath) || rom.empty() || rom.size() > MAX_ADDRESSABLE) {
+			std::cerr << "can't load " << romPath << std::endl;
+			return 1;
+		}
+
+		if (!hasStart) {
+			romStart = (Word)(MAX_ADDRESSABLE - rom.size());
+		}
+
+		std::vector<Byte> memory(MAX_ADDRESSABLE, 0x00);
+
+		for (size_t i = 0; i < rom.size() && romStart + i < MAX_ADDRESSABLE; i++) {
+			memory[romStart + i] = rom[i];
+		}
+
+		total.DisplayLcov(std::cout, symbols, memory.data(), testName, *opcodes);
+	}
+
+	return 0;
+}
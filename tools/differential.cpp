@@ -0,0 +1,568 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <filesystem>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "cpu.hpp"
+#include "opcodes.hpp"
+#include "idle.hpp"
+#include "analysis.hpp"
+#include "recompiler.hpp"
+
+// differential [--runs <n>] [--budget <instructions>] [--size <bytes>] [--seed <n>] [--threads <n>]
+//              [--engines cycle,idle,recompiled] [--compiler "<command>"] [--output <prefix>] [--keep-going]
+// Runs random programs on every engine against the instruction-stepped interpreter, the reference, and shrinks
+// the first divergence found to a minimal reproducer
+// - engines advance by their own unit (an instruction, a skipped loop, a recompiled block), the reference then
+//   steps up to the same cycle and registers, cycles and every page dirty in either memory are compared
+// - recompiled builds every program with the compiler command, eg. "g++ -O0 -shared -fPIC -Iinc"
+// Exits with 0 if no run diverged, 1 otherwise, 2 on errors
+
+constexpr Word PROGRAM_START = 0x8000;
+
+// Program at PROGRAM_START followed by $00, vectors to the program
+// Runs stop before a $00 or undocumented opcode, or at the instructions budget
+struct TestProgram {
+	std::vector<Byte> ram;
+	std::vector<Byte> rom;
+	std::vector<Word> instructions; // offsets in rom
+	uint64_t budget;
+};
+
+struct Options {
+	size_t runs = 1000;
+	uint64_t budget = 1000;
+	size_t size = 0x100;
+	uint64_t seed = 1;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::string> engines = { "cycle", "idle" };
+	std::string compiler;
+	std::string output;
+	bool keepGoing = false;
+};
+
+struct Divergence {
+	bool found = false;
+	std::string engine;
+	uint64_t instruction = 0; // reference instructions run before it
+	std::string details;
+	std::vector<bool> executed; // rom offsets run by the reference
+};
+
+class Engine {
+	public:
+		virtual ~Engine() = default;
+
+		// Runs its smallest unit, false if it stopped before a $00 or undocumented opcode instead
+		virtual bool Advance() = 0;
+
+		virtual CPUState GetState() const = 0;
+		virtual Byte const* GetPage(Byte page) const = 0;
+		virtual bool IsPageDirty(Byte page) const = 0;
+};
+
+template <typename Processor>
+class InterpreterEngine : public Engine {
+	public:
+		InterpreterEngine(TestProgram& program) : _cpu(&program.ram, 0x0000, MAX_RAM_SIZE, &program.rom, PROGRAM_START, MAX_ROM_SIZE) {
+			_cpu.SetTraceOutput(nullptr);
+		}
+
+		bool Advance() override {
+			if (IsStopped(_cpu)) {
+				return false;
+			}
+
+			if constexpr (std::is_same_v<Processor, CycleCPU>) {
+				// every bus cycle of the instruction handed out
+				uint64_t const start = _cpu.GetCycles();
+				uint64_t ticks = 0;
+
+				do {
+					_cpu.Tick();
+					ticks++;
+				} while (ticks < _cpu.GetCycles() - start);
+			}
+
+			else {
+				_cpu.Step();
+			}
+
+			return true;
+		}
+
+		CPUState GetState() const override { return _cpu.GetState(); }
+		Byte const* GetPage(Byte page) const override { return _cpu.GetPage(page); }
+		bool IsPageDirty(Byte page) const override { return _cpu.IsPageDirty(page); }
+
+		// Before $00, or an undocumented opcode : without a handler it takes no cycle and Run loops on it
+		template <typename CPUType>
+		static bool IsStopped(CPUType const& cpu) {
+			Word const pc = cpu.GetState().programCounter;
+			Byte const opcode = cpu.GetPage(pc >> 8)[pc & 0xFF];
+
+			return opcode == 0x00 || CPUType::GetOpcodes()[opcode].flow == FLOW::INVALID;
+		}
+
+	protected:
+		Processor _cpu;
+};
+
+class IdleEngine : public InterpreterEngine<CPU> {
+	public:
+		IdleEngine(TestProgram& program) : InterpreterEngine<CPU>(program), _skipper(&_cpu) {}
+
+		bool Advance() override {
+			if (IsStopped(_cpu)) {
+				return false;
+			}
+
+			_skipper.Run(1);
+
+			return true;
+		}
+
+	private:
+		IdleSkipper _skipper;
+};
+
+class RecompiledEngine : public InterpreterEngine<CPU> {
+	public:
+		RecompiledEngine(TestProgram& program) : InterpreterEngine<CPU>(program), _recompiled(&_cpu) {}
+
+		// Builds and loads the blocks of the program, false if the compiler or the library failed
+		// The last library built by the thread is kept while the ROM doesn't change : shrinking only clears RAM at the end
+		bool Build(TestProgram const& program, std::string const& compiler) {
+			static std::atomic<uint64_t> builds = 0;
+			static uint64_t const tag = std::random_device()();
+
+			struct Library {
+				std::vector<Byte> rom;
+				std::string path;
+
+				~Library() {
+					if (!path.empty()) {
+						std::filesystem::remove(path);
+					}
+				}
+			};
+
+			thread_local Library last;
+
+			if (last.rom == program.rom && !last.path.empty()) {
+				return _recompiled.Load(last.path);
+			}
+
+			if (!last.path.empty()) {
+				std::filesystem::remove(last.path);
+				last.path.clear();
+			}
+
+			std::filesystem::path const base = std::filesystem::temp_directory_path() / ("differential-" + std::to_string(tag) + "-" + std::to_string(builds++));
+			std::string const source = base.string() + ".cpp";
+			std::string const library = base.string() + ".so";
+
+			ROMAnalysis analysis(&program.rom, PROGRAM_START);
+			analysis.Analyze();
+
+			{
+				std::ofstream output(source);
+				WriteRecompiledSource(analysis, program.rom, PROGRAM_START, output);
+			}
+
+			bool const built = std::system((compiler + " " + source + " -o " + library).c_str()) == 0 && _recompiled.Load(library);
+			std::filesystem::remove(source);
+
+			if (!built) {
+				std::filesystem::remove(library);
+				return false;
+			}
+
+			last.rom = program.rom;
+			last.path = library;
+
+			return true;
+		}
+
+		bool Advance() override {
+			if (IsStopped(_cpu)) {
+				return false;
+			}
+
+			_recompiled.Run(1);
+
+			return true;
+		}
+
+	private:
+		RecompiledROM _recompiled;
+};
+
+std::string Describe(CPUState const& state) {
+	std::ostringstream text;
+	text << std::hex << std::uppercase << std::setfill('0') << "PC:" << std::setw(4) << state.programCounter << " A:" << std::setw(2) << (int) state.accumulator
+		<< " X:" << std::setw(2) << (int) state.indexX << " Y:" << std::setw(2) << (int) state.indexY << " P:" << std::setw(2) << (int) state.statusFlags
+		<< " SP:" << std::setw(2) << (int) state.stackPointer << std::dec << " cycle " << state.cycles;
+
+	return text.str();
+}
+
+// Empty if the engines agree
+std::string Compare(Engine const& reference, Engine const& engine) {
+	CPUState const expected = reference.GetState();
+	CPUState const actual = engine.GetState();
+
+	if (expected.programCounter != actual.programCounter || expected.accumulator != actual.accumulator || expected.indexX != actual.indexX
+		|| expected.indexY != actual.indexY || expected.statusFlags != actual.statusFlags || expected.stackPointer != actual.stackPointer
+		|| expected.cycles != actual.cycles) {
+		return "reference " + Describe(expected) + "\n    engine    " + Describe(actual);
+	}
+
+	// pages never written are still those of the images
+	for (int page = 0; page < MAX_PAGES; page++) {
+		if (!reference.IsPageDirty((Byte) page) && !engine.IsPageDirty((Byte) page)) {
+			continue;
+		}
+
+		Byte const* const left = reference.GetPage((Byte) page);
+		Byte const* const right = engine.GetPage((Byte) page);
+
+		if (std::memcmp(left, right, MAX_PAGE_SIZE) == 0) {
+			continue;
+		}
+
+		for (int i = 0; i < MAX_PAGE_SIZE; i++) {
+			if (left[i] != right[i]) {
+				std::ostringstream text;
+				text << std::hex << std::uppercase << std::setfill('0') << "memory $" << std::setw(4) << (page << 8 | i) << " reference $" << std::setw(2) << (int) left[i]
+					<< " engine $" << std::setw(2) << (int) right[i] << " at " << Describe(expected);
+
+				return text.str();
+			}
+		}
+	}
+
+	return "";
+}
+
+std::unique_ptr<Engine> MakeEngine(std::string const& name, TestProgram& program, Options const& options) {
+	if (name == "cycle") {
+		return std::make_unique<InterpreterEngine<CycleCPU>>(program);
+	}
+
+	if (name == "idle") {
+		return std::make_unique<IdleEngine>(program);
+	}
+
+	if (name == "recompiled") {
+		auto engine = std::make_unique<RecompiledEngine>(program);
+		return engine->Build(program, options.compiler) ? std::move(engine) : nullptr;
+	}
+
+	return nullptr;
+}
+
+Divergence RunProgram(TestProgram program, Options const& options) {
+	Divergence divergence;
+	divergence.executed.assign(program.rom.size(), false);
+
+	for (std::string const& name : options.engines) {
+		InterpreterEngine<CPU> reference(program);
+		std::unique_ptr<Engine> const engine = MakeEngine(name, program, options);
+
+		if (engine == nullptr) {
+			divergence.found = true;
+			divergence.engine = name;
+			divergence.details = "engine couldn't be set up";
+			return divergence;
+		}
+
+		bool running = true;
+
+		for (uint64_t units = 0; running && units < program.budget && reference.GetState().instructions < program.budget; units++) {
+			running = engine->Advance();
+
+			// the reference catches up with the unit run by the engine
+			uint64_t const cycles = engine->GetState().cycles;
+			while (reference.GetState().cycles < cycles) {
+				Word const pc = reference.GetState().programCounter;
+
+				if (!reference.Advance()) {
+					break;
+				}
+
+				if (pc >= PROGRAM_START) {
+					divergence.executed[pc - PROGRAM_START] = true;
+				}
+			}
+
+			std::string const details = Compare(reference, *engine);
+
+			if (!details.empty()) {
+				divergence.found = true;
+				divergence.engine = name;
+				divergence.instruction = reference.GetState().instructions;
+				divergence.details = details;
+				return divergence;
+			}
+		}
+	}
+
+	return divergence;
+}
+
+TestProgram Generate(std::mt19937_64& random, Options const& options) {
+	TestProgram program;
+	program.ram.resize(MAX_RAM_SIZE);
+	program.rom.assign(MAX_ROM_SIZE, 0x00);
+	program.budget = options.budget;
+
+	for (Byte& value : program.ram) {
+		value = (Byte) random();
+	}
+
+	// documented opcodes, BRK ends the runs
+	std::vector<Byte> opcodes;
+	for (int opcode = 1; opcode < 0x100; opcode++) {
+		if (CPU::GetOpcodes()[opcode].flow != FLOW::INVALID) {
+			opcodes.push_back((Byte) opcode);
+		}
+	}
+
+	size_t offset = 0;
+
+	while (true) {
+		Byte const opcode = opcodes[random() % opcodes.size()];
+		OpcodeInfo const& info = CPU::GetOpcodes()[opcode];
+		Byte const length = GetInstructionLength(info.mode);
+
+		if (offset + length > options.size) {
+			break;
+		}
+
+		Word operand = (Word) random();
+
+		// transfers mostly stay in the program, data mostly goes to RAM
+		if ((info.flow == FLOW::JUMP || info.flow == FLOW::CALL) && random() % 4 != 0) {
+			operand = (Word)(PROGRAM_START + random() % options.size);
+		}
+
+		else if (length == 3 && random() % 4 != 0) {
+			operand = (Word)(random() % MAX_RAM_SIZE);
+		}
+
+		program.instructions.push_back((Word) offset);
+		program.rom[offset] = opcode;
+
+		for (Byte i = 1; i < length; i++) {
+			program.rom[offset + i] = (Byte)(operand >> (8 * (i - 1)));
+		}
+
+		offset += length;
+	}
+
+	for (Word vector : { NMI_LOW, RESET_LOW, IRQ_LOW }) {
+		program.rom[vector - PROGRAM_START] = (Byte) PROGRAM_START;
+		program.rom[vector - PROGRAM_START + 1] = (Byte)(PROGRAM_START >> 8);
+	}
+
+	return program;
+}
+
+// Keeps every simplification after which the program still diverges
+TestProgram Shrink(TestProgram program, Divergence& divergence, Options const& options) {
+	auto const fails = [&](TestProgram const& candidate) {
+		Divergence const result = RunProgram(candidate, options);
+
+		if (result.found) {
+			divergence = result;
+		}
+
+		return result.found;
+	};
+
+	program.budget = divergence.instruction + 1;
+
+	// instructions the reference never ran all at once
+	{
+		TestProgram candidate = program;
+
+		for (Word offset : program.instructions) {
+			if (!divergence.executed[offset]) {
+				std::fill_n(candidate.rom.begin() + offset, GetInstructionLength(CPU::GetOpcodes()[program.rom[offset]].mode), 0x00);
+			}
+		}
+
+		if (candidate.rom != program.rom && fails(candidate)) {
+			program = candidate;
+		}
+	}
+
+	// then those run from the last one, replaced by $00 (the run ends there) or else by NOPs
+	for (size_t i = program.instructions.size(); i-- > 0;) {
+		Word const offset = program.instructions[i];
+		Byte const length = GetInstructionLength(CPU::GetOpcodes()[program.rom[offset]].mode);
+
+		if (program.rom[offset] == 0x00 || program.rom[offset] == 0xEA || !divergence.executed[offset]) {
+			continue;
+		}
+
+		for (Byte fill : { (Byte) 0x00, (Byte) 0xEA }) {
+			TestProgram candidate = program;
+			std::fill(candidate.rom.begin() + offset, candidate.rom.begin() + offset + length, fill);
+
+			if (fails(candidate)) {
+				program = candidate;
+				break;
+			}
+		}
+	}
+
+	// RAM cleared by halves, then smaller and smaller blocks
+	for (size_t block = MAX_RAM_SIZE / 2; block > 0; block /= 2) {
+		for (size_t start = 0; start < MAX_RAM_SIZE; start += block) {
+			if (std::all_of(program.ram.begin() + start, program.ram.begin() + start + block, [](Byte value) { return value == 0x00; })) {
+				continue;
+			}
+
+			TestProgram candidate = program;
+			std::fill(candidate.ram.begin() + start, candidate.ram.begin() + start + block, 0x00);
+
+			if (fails(candidate)) {
+				program = candidate;
+			}
+		}
+	}
+
+	program.budget = divergence.instruction + 1;
+
+	return program;
+}
+
+void Report(std::ostream& output, uint64_t seed, TestProgram const& program, Divergence const& divergence) {
+	output << "seed " << seed << " : " << divergence.engine << " diverges after " << divergence.instruction << " instruction(s)" << std::endl;
+	output << "    " << divergence.details << std::endl;
+
+	output << "program" << std::endl;
+
+	for (Word offset : program.instructions) {
+		Byte const* const bytes = &program.rom[offset];
+
+		if (bytes[0] != 0x00 && bytes[0] != 0xEA) {
+			output << "    $" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << (PROGRAM_START + offset) << "    "
+				<< Disassemble((Word)(PROGRAM_START + offset), bytes) << std::dec << std::setfill(' ') << std::endl;
+		}
+	}
+
+	output << "RAM" << std::endl;
+
+	for (size_t address = 0; address < program.ram.size(); address++) {
+		if (program.ram[address] != 0x00) {
+			output << "    $" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << address << " = $" << std::setw(2) << (int) program.ram[address]
+				<< std::dec << std::setfill(' ') << std::endl;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+
+	for (int i = 1; i < argc; i++) {
+		std::string const option = argv[i];
+
+		if (option == "--runs" && i + 1 < argc) options.runs = std::stoul(argv[++i]);
+		else if (option == "--budget" && i + 1 < argc) options.budget = std::stoull(argv[++i]);
+		else if (option == "--size" && i + 1 < argc) options.size = std::min<size_t>(std::stoul(argv[++i]), MAX_ROM_SIZE - 0x10);
+		else if (option == "--seed" && i + 1 < argc) options.seed = std::stoull(argv[++i]);
+		else if (option == "--threads" && i + 1 < argc) options.threads = std::max(1, std::stoi(argv[++i]));
+		else if (option == "--compiler" && i + 1 < argc) options.compiler = argv[++i];
+		else if (option == "--output" && i + 1 < argc) options.output = argv[++i];
+		else if (option == "--keep-going") options.keepGoing = true;
+
+		else if (option == "--engines" && i + 1 < argc) {
+			options.engines.clear();
+
+			std::istringstream names(argv[++i]);
+			std::string name;
+
+			while (std::getline(names, name, ',')) {
+				options.engines.push_back(name);
+			}
+		}
+
+		else {
+			std::cerr << "usage : " << argv[0] << " [--runs <n>] [--budget <instructions>] [--size <bytes>] [--seed <n>] [--threads <n>]"
+				<< " [--engines cycle,idle,recompiled] [--compiler \"<command>\"] [--output <prefix>] [--keep-going]" << std::endl;
+			return 2;
+		}
+	}
+
+	for (std::string const& name : options.engines) {
+		if (name != "cycle" && name != "idle" && name != "recompiled") {
+			std::cerr << "unknown engine " << name << std::endl;
+			return 2;
+		}
+
+		if (name == "recompiled" && options.compiler.empty()) {
+			std::cerr << "the recompiled engine needs --compiler" << std::endl;
+			return 2;
+		}
+	}
+
+	std::atomic<size_t> next = 0;
+	std::atomic<size_t> failures = 0;
+	std::mutex outputLock;
+	std::vector<std::thread> workers;
+
+	for (unsigned t = 0; t < options.threads; t++) {
+		workers.emplace_back([&]() {
+			for (size_t run = next++; run < options.runs; run = next++) {
+				if (failures > 0 && !options.keepGoing) {
+					break;
+				}
+
+				uint64_t const seed = options.seed + run;
+				std::mt19937_64 random(seed);
+
+				TestProgram program = Generate(random, options);
+				Divergence divergence = RunProgram(program, options);
+
+				if (!divergence.found) {
+					continue;
+				}
+
+				size_t const failure = failures++;
+				program = Shrink(program, divergence, options);
+
+				std::lock_guard<std::mutex> lock(outputLock);
+				Report(std::cout, seed, program, divergence);
+
+				// the images, to load in the emulator or the other tools
+				if (!options.output.empty()) {
+					std::string const prefix = options.output + "-" + std::to_string(failure);
+					std::ofstream(prefix + ".rom", std::ios::binary).write((char const*) program.rom.data(), program.rom.size());
+					std::ofstream(prefix + ".ram", std::ios::binary).write((char const*) program.ram.data(), program.ram.size());
+				}
+			}
+		});
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	std::cout << std::min(next.load(), options.runs) << " run(s), " << failures << " divergence(s)" << std::endl;
+
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "analysis.hpp"
+#include "symbols.hpp"
+#include "tools.hpp"
+
+// disassemble <rom> [--start $8000] [--entry $C000]... [--symbols <file>]... [--variant 6502|6502u|65c02] [--dot]
+// The ROM is mapped so it ends at $FFFF unless --start is given, opcodes are the NMOS ones unless --variant is given
+// Symbols come from ld65 debug files, VICE label files or name = $XXXX maps
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage : " << argv[0] << " <rom> [--start $8000] [--entry $C000]... [--symbols <file>]... [--variant 6502|6502u|65c02] [--dot]" << std::endl;
+		return 1;
+	}
+
+	std::vector<Byte> rom;
+
+	if (!LoadFile(rom, argv[1]) || rom.empty() || rom.size() > 0x10000) {
+		std::cerr << "can't load " << argv[1] << std::endl;
+		return 1;
+	}
+
+	Word romStart = (Word)(0x10000 - rom.size());
+	std::vector<Word> entries;
+	SymbolTable symbols;
+	OpcodeTable const* opcodes = &GetOpcodes<MOS6502>();
+	bool dot = false;
+
+	for (int i = 2; i < argc; i++) {
+		std::string const option = argv[i];
+
+		if (option == "--start" && i + 1 < argc) {
+			if (!ParseAddress(argv[++i], romStart)) {
+				std::cerr << "bad address " << argv[i] << std::endl;
+				return 1;
+			}
+		}
+
+		else if (option == "--entry" && i + 1 < argc) {
+			Word entry = 0x0000;
+
+			if (!ParseAddress(argv[++i], entry)) {
+				std::cerr << "bad address " << argv[i] << std::endl;
+				return 1;
+			}
+
+			entries.push_back(entry);
+		}
+
+		else if (option == "--variant" && i + 1 < argc) {
+			opcodes = GetOpcodes(argv[++i]);
+
+			if (opcodes == nullptr) {
+				std::cerr << "unknown variant " << argv[i] << std::endl;
+				return 1;
+			}
+		}
+
+		else if (option == "--symbols" && i + 1 < argc) {
+			if (!symbols.Load(argv[++i])) {
+				std::cerr << "can't load " << argv[i] << std::endl;
+				return 1;
+			}
+		}
+
+		else if (option == "--dot") {
+			dot = true;
+		}
+	}
+
+	ROMAnalysis analysis(&rom, romStart, *opcodes);
+	analysis.SetSymbols(symbols.IsEmpty() ? nullptr : &symbols);
+
+	for (Word entry : entries) {
+		analysis.AddEntryPoint(entry);
+	}
+
+	analysis.Analyze();
+
+	if (dot) {
+		analysis.DisplayGraph(std::cout);
+		return 0;
+	}
+
+	analysis.DisplayListing(std::cout);
+
+	std::cerr << analysis.GetInstructions().size() << " instructions, "
+		<< analysis.GetBlocks().size() << " blocks, "
+		<< analysis.GetJumpTables().size() << " jump tables, "
+		<< analysis.GetExternalTargets().size() << " targets outside the ROM" << std::endl;
+
+	return 0;
+}
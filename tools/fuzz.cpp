@@ -0,0 +1,164 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <cstdlib>
+#include <cstdint>
+
+#include "cpu.hpp"
+#include "opcodes.hpp"
+#include "tools.hpp"
+
+// libFuzzer target running a ROM with the fuzzer input as RAM contents or as an MMIO input stream
+//
+// clang++ -std=c++20 -O2 -g -fsanitize=fuzzer -Iinc tools/fuzz.cpp src/<everything but main.cpp> -ldl -o fuzz
+// FUZZ_ROM=game.rom [FUZZ_MODE=ram|mmio] [FUZZ_MMIO=$D000] [FUZZ_BUDGET=100000] ./fuzz corpus/
+//
+// The ROM is mapped so it ends at $FFFF, RAM covers $0000-$07FF
+// - ram : the input is copied at the start of RAM
+// - mmio : every read of the MMIO page returns the next input byte ($00 once it is exhausted)
+// A run ends at a BRK or after FUZZ_BUDGET instructions. Illegal opcodes, stack overflows and underflows
+// and writes to ROM abort (a crash for libFuzzer)
+// Built with -DFUZZ_STANDALONE instead of -fsanitize=fuzzer, it replays the files given as arguments
+
+namespace {
+	// Feeds the input to the CPU one byte per read
+	class InputStream : public Device {
+		public:
+			void SetInput(Byte const* data, size_t size) {
+				_data = data;
+				_size = size;
+				_position = 0;
+			}
+
+			Byte Read(Word /* address */) override {
+				return (_position < _size) ? _data[_position++] : (Byte) 0x00;
+			}
+
+		private:
+			Byte const* _data = nullptr;
+			size_t _size = 0;
+			size_t _position = 0;
+	};
+
+	std::unique_ptr<CPU> cpu;
+
+	InputStream stream;
+	bool mmio = false;
+	uint64_t budget = 100000;
+
+	std::bitset<MAX_PAGES> romPages;
+
+	[[noreturn]] void Crash(char const* reason, Word pc) {
+		std::cerr << "fuzz : " << reason << " at $" << std::hex << std::uppercase << pc << std::endl;
+		std::abort();
+	}
+}
+
+extern "C" int LLVMFuzzerInitialize(int* /* argc */, char*** /* argv */) {
+	char const* const romPath = std::getenv("FUZZ_ROM");
+	std::vector<Byte> rom;
+
+	if (romPath == nullptr || !LoadFile(rom, romPath) || rom.empty() || rom.size() > (size_t)(0x10000 - MAX_RAM_SIZE)) {
+		std::cerr << "fuzz : FUZZ_ROM must name a ROM of at most " << 0x10000 - MAX_RAM_SIZE << " bytes" << std::endl;
+		std::exit(1);
+	}
+
+	char const* const mode = std::getenv("FUZZ_MODE");
+	char const* const mmioAddress = std::getenv("FUZZ_MMIO");
+	char const* const instructions = std::getenv("FUZZ_BUDGET");
+
+	mmio = mode != nullptr && std::string(mode) == "mmio";
+	budget = (instructions != nullptr) ? std::strtoull(instructions, nullptr, 10) : budget;
+
+	Word const romStart = (Word)(0x10000 - rom.size());
+	std::vector<Byte> ram(MAX_RAM_SIZE, (Byte) 0x00);
+
+	cpu = std::make_unique<CPU>(std::make_shared<MemoryImage const>(&ram, (Word) 0x0000, (Word) MAX_RAM_SIZE, &rom, romStart, (Word) rom.size()));
+	cpu->SetTraceOutput(nullptr);
+
+	if (mmio) {
+		Word mmioStart = 0xD000;
+
+		if (mmioAddress != nullptr && !ParseAddress(mmioAddress, mmioStart)) {
+			std::cerr << "fuzz : bad FUZZ_MMIO address " << mmioAddress << std::endl;
+			std::exit(1);
+		}
+
+		cpu->AttachDevice(&stream, mmioStart, MAX_PAGE_SIZE);
+	}
+
+	for (int page = romStart >> 8; page < MAX_PAGES; page++) {
+		romPages.set(page);
+	}
+
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const* data, size_t size) {
+	// only the pages written by the previous run are copied back
+	cpu->Reset();
+
+	if (mmio) {
+		stream.SetInput(data, size);
+	}
+
+	else {
+		for (size_t offset = 0; offset < size && offset < MAX_RAM_SIZE; offset += MAX_PAGE_SIZE) {
+			Byte* const page = cpu->GetWritablePage((Byte)(offset >> 8));
+			std::copy(data + offset, data + std::min<size_t>({ size, offset + MAX_PAGE_SIZE, MAX_RAM_SIZE }), page);
+		}
+	}
+
+	for (uint64_t i = 0; i < budget; i++) {
+		CPUState const state = cpu->GetState();
+		Byte const opcode = cpu->GetPage(state.programCounter >> 8)[state.programCounter & 0xFF];
+
+		// BRK ends the run, like CPU::Run
+		if (CPU::GetOpcodes()[opcode].flow == FLOW::STOP) {
+			break;
+		}
+
+		if (CPU::GetOpcodes()[opcode].flow == FLOW::INVALID) {
+			Crash("illegal opcode", state.programCounter);
+		}
+
+		int const moves = CPU::GetOpcodes()[opcode].stack;
+
+		if (moves > 0 && state.stackPointer < moves) {
+			Crash("stack overflow", state.programCounter);
+		}
+
+		if (moves < 0 && state.stackPointer - moves > 0xFF) {
+			Crash("stack underflow", state.programCounter);
+		}
+
+		cpu->Step();
+
+		if ((cpu->GetDirtyPages() & romPages).any()) {
+			Crash("write to ROM", state.programCounter);
+		}
+	}
+
+	return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+int main(int argc, char* argv[]) {
+	LLVMFuzzerInitialize(&argc, &argv);
+
+	for (int i = 1; i < argc; i++) {
+		std::vector<Byte> input;
+
+		if (!LoadFile(input, argv[i])) {
+			std::cerr << "can't load " << argv[i] << std::endl;
+			return 1;
+		}
+
+		LLVMFuzzerTestOneInput(input.data(), input.size());
+	}
+
+	return 0;
+}
+#endif
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cstdio>
+
+#include "metrics.hpp"
+
+// metrics <file> [--prometheus <output.prom>] [--watch <seconds>]
+// Prints the counters of a running emulator, or writes them in the Prometheus text format
+// (the file is replaced atomically, for the node_exporter textfile collector)
+
+std::string Prometheus(MetricsBlock const& block) {
+	std::ostringstream text;
+
+	auto const metric = [&](char const* name, char const* type, char const* help, uint64_t value) {
+		text << "# HELP emulator6502_" << name << " " << help << "\n";
+		text << "# TYPE emulator6502_" << name << " " << type << "\n";
+		text << "emulator6502_" << name << " " << value << "\n";
+	};
+
+	metric("instructions_total", "counter", "Instructions executed.", block.instructions.load(std::memory_order_relaxed));
+	metric("cycles_total", "counter", "CPU cycles elapsed.", block.cycles.load(std::memory_order_relaxed));
+	metric("interrupts_total", "counter", "IRQ and NMI entries.", block.interrupts.load(std::memory_order_relaxed));
+	metric("instructions_per_second", "gauge", "Instructions per second over the last interval.", block.instructionsPerSecond.load(std::memory_order_relaxed));
+	metric("program_counter", "gauge", "Program counter at the last update.", block.programCounter.load(std::memory_order_relaxed));
+	metric("updates_total", "counter", "Updates published.", block.updates.load(std::memory_order_relaxed));
+
+	text << "# HELP emulator6502_stops_total Runs stopped, by reason.\n";
+	text << "# TYPE emulator6502_stops_total counter\n";
+
+	for (size_t i = 0; i < (size_t) STOP_REASON::COUNT; i++) {
+		text << "emulator6502_stops_total{reason=\"" << GetStopReasonName((STOP_REASON) i) << "\"} " << block.stops[i].load(std::memory_order_relaxed) << "\n";
+	}
+
+	return text.str();
+}
+
+void Display(MetricsBlock const& block) {
+	std::cout << "instructions      " << block.instructions.load(std::memory_order_relaxed) << std::endl;
+	std::cout << "cycles            " << block.cycles.load(std::memory_order_relaxed) << std::endl;
+	std::cout << "interrupts        " << block.interrupts.load(std::memory_order_relaxed) << std::endl;
+	std::cout << "instructions/s    " << block.instructionsPerSecond.load(std::memory_order_relaxed) << std::endl;
+	std::cout << "pc                $" << std::hex << std::uppercase << block.programCounter.load(std::memory_order_relaxed) << std::dec << std::endl;
+	std::cout << "last stop         " << GetStopReasonName((STOP_REASON) block.lastStop.load(std::memory_order_relaxed)) << std::endl;
+
+	for (size_t i = 0; i < (size_t) STOP_REASON::COUNT; i++) {
+		std::cout << "stops " << GetStopReasonName((STOP_REASON) i) << std::string(12 - std::string(GetStopReasonName((STOP_REASON) i)).size(), ' ')
+			<< block.stops[i].load(std::memory_order_relaxed) << std::endl;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage : " << argv[0] << " <file> [--prometheus <output.prom>] [--watch <seconds>]" << std::endl;
+		return 1;
+	}
+
+	std::string prometheus;
+	double watch = 0.0;
+
+	for (int i = 2; i < argc; i++) {
+		std::string const option = argv[i];
+
+		if (option == "--prometheus" && i + 1 < argc) {
+			prometheus = argv[++i];
+		}
+
+		else if (option == "--watch" && i + 1 < argc) {
+			watch = std::stod(argv[++i]);
+		}
+	}
+
+	MetricsBlock* const block = MapMetrics(argv[1], false);
+
+	if (block == nullptr) {
+		std::cerr << "can't map " << argv[1] << std::endl;
+		return 1;
+	}
+
+	do {
+		if (prometheus.empty()) {
+			Display(*block);
+			std::cout << std::endl;
+		}
+
+		else {
+			std::string const temporary = prometheus + ".tmp";
+			std::ofstream(temporary) << Prometheus(*block);
+			std::rename(temporary.c_str(), prometheus.c_str());
+		}
+
+		if (watch > 0.0) {
+			std::this_thread::sleep_for(std::chrono::duration<double>(watch));
+		}
+	} while (watch > 0.0);
+
+	UnmapMetrics(block);
+
+	return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <vector>
+#include <fstream>
+#include <string>
+
+#include "recompiler.hpp"
+#include "tools.hpp"
+
+// recompile <rom> <output.cpp> [--start $8000] [--entry $C000]...
+// The ROM is mapped so it ends at $FFFF unless --start is given
+// Build the output with : g++ -O2 -shared -fPIC -Iinc <output.cpp> -o <library>
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		std::cerr << "usage : " << argv[0] << " <rom> <output.cpp> [--start $8000] [--entry $C000]..." << std::endl;
+		return 1;
+	}
+
+	std::vector<Byte> rom;
+
+	if (!LoadFile(rom, argv[1]) || rom.empty() || rom.size() > 0x10000) {
+		std::cerr << "can't load " << argv[1] << std::endl;
+		return 1;
+	}
+
+	Word romStart = (Word)(0x10000 - rom.size());
+	std::vector<Word> entries;
+
+	for (int i = 3; i < argc; i++) {
+		std::string const option = argv[i];
+
+		if (option == "--start" && i + 1 < argc) {
+			if (!ParseAddress(argv[++i], romStart)) {
+				std::cerr << "bad address " << argv[i] << std::endl;
+				return 1;
+			}
+		}
+
+		else if (option == "--entry" && i + 1 < argc) {
+			Word entry = 0x0000;
+
+			if (!ParseAddress(argv[++i], entry)) {
+				std::cerr << "bad address " << argv[i] << std::endl;
+				return 1;
+			}
+
+			entries.push_back(entry);
+		}
+	}
+
+	ROMAnalysis analysis(&rom, romStart);
+
+	for (Word entry : entries) {
+		analysis.AddEntryPoint(entry);
+	}
+
+	analysis.Analyze();
+
+	std::ofstream output(argv[2]);
+
+	if (!output.is_open()) {
+		std::cerr << "can't write " << argv[2] << std::endl;
+		return 1;
+	}
+
+	WriteRecompiledSource(analysis, rom, romStart, output);
+
+	std::cerr << analysis.GetBlocks().size() << " blocks written to " << argv[2] << std::endl;
+
+	return 0;
+}
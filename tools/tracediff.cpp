@@ -0,0 +1,116 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include <cstring>
+
+#include "trace.hpp"
+#include "opcodes.hpp"
+
+// tracediff <a.trace> <b.trace> [--context <records>]
+// Finds the first record where two binary traces (see trace.hpp) differ and prints it disassembled, with the
+// records leading to it
+// Exits with 0 if the traces are identical, 1 if they diverge, 2 on errors
+
+std::string Format(size_t index, TraceRecord const& record) {
+	std::ostringstream line;
+	line << std::setw(10) << index << "  cycle " << std::setw(12) << record.cycles << "  ";
+	line << std::hex << std::uppercase << std::setfill('0') << "$" << std::setw(4) << record.programCounter << "    ";
+
+	if (record.interrupt) {
+		line << std::left << std::setfill(' ') << std::setw(32) << "(interrupt)" << std::right << std::setfill('0');
+	}
+
+	else {
+		std::string const text = Disassemble(record.programCounter, record.bytes);
+		line << std::left << std::setfill(' ') << std::setw(32) << text << std::right << std::setfill('0');
+	}
+
+	line << "A:" << std::setw(2) << (int) record.accumulator << " X:" << std::setw(2) << (int) record.indexX << " Y:" << std::setw(2) << (int) record.indexY
+		<< " P:" << std::setw(2) << (int) record.statusFlags << " SP:" << std::setw(2) << (int) record.stackPointer;
+
+	return line.str();
+}
+
+std::string Differences(TraceRecord const& a, TraceRecord const& b) {
+	std::string fields;
+
+	auto const compare = [&](bool differs, char const* name) {
+		if (differs) {
+			fields += (fields.empty() ? "" : ", ") + std::string(name);
+		}
+	};
+
+	compare(a.cycles != b.cycles, "cycles");
+	compare(a.programCounter != b.programCounter, "pc");
+	compare(std::memcmp(a.bytes, b.bytes, sizeof(a.bytes)) != 0, "instruction");
+	compare(a.accumulator != b.accumulator, "A");
+	compare(a.indexX != b.indexX, "X");
+	compare(a.indexY != b.indexY, "Y");
+	compare(a.statusFlags != b.statusFlags, "P");
+	compare(a.stackPointer != b.stackPointer, "SP");
+	compare(a.interrupt != b.interrupt, "interrupt");
+
+	return fields;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		std::cerr << "usage : " << argv[0] << " <a.trace> <b.trace> [--context <records>]" << std::endl;
+		return 2;
+	}
+
+	size_t context = 8;
+
+	for (int i = 3; i < argc; i++) {
+		std::string const option = argv[i];
+
+		if (option == "--context" && i + 1 < argc) {
+			context = std::stoul(argv[++i]);
+		}
+	}
+
+	TraceFile a;
+	TraceFile b;
+
+	for (auto const& [trace, path] : { std::make_pair(&a, argv[1]), std::make_pair(&b, argv[2]) }) {
+		if (!trace->Open(path)) {
+			std::cerr << "can't map " << path << std::endl;
+			return 2;
+		}
+	}
+
+	size_t const common = std::min(a.GetCount(), b.GetCount());
+
+	// whole records are compared at once, the byte found gives the record
+	size_t const offset = FindFirstDifference(a.GetRecords(), b.GetRecords(), common * sizeof(TraceRecord));
+	size_t const index = offset / sizeof(TraceRecord);
+
+	if (index == common && a.GetCount() == b.GetCount()) {
+		std::cout << "identical, " << common << " records" << std::endl;
+		return 0;
+	}
+
+	for (size_t i = (index > context) ? index - context : 0; i < index; i++) {
+		std::cout << "  " << Format(i, a.GetRecords()[i]) << std::endl;
+	}
+
+	if (index == common) {
+		TraceFile const& longer = (a.GetCount() > b.GetCount()) ? a : b;
+
+		std::cout << "> " << Format(index, longer.GetRecords()[index]) << std::endl;
+		std::cout << "diverge at record " << index << " : " << ((&longer == &a) ? argv[2] : argv[1]) << " ends" << std::endl;
+
+		return 1;
+	}
+
+	TraceRecord const& left = a.GetRecords()[index];
+	TraceRecord const& right = b.GetRecords()[index];
+
+	std::cout << "< " << Format(index, left) << std::endl;
+	std::cout << "> " << Format(index, right) << std::endl;
+	std::cout << "diverge at record " << index << " : " << Differences(left, right) << std::endl;
+
+	return 1;
+}